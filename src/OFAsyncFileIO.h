@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2008-2026 Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3.0 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * version 3.0 along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#import "OFObject.h"
+#import "OFFile.h"
+#import "OFKernelEventObserver.h"
+
+#if defined(OF_HAVE_FILES) && defined(OF_HAVE_SOCKETS) && \
+    defined(OF_HAVE_THREADS) && defined(OF_HAVE_PIPE) && \
+    defined(OF_FILE_HANDLE_IS_FD) && !defined(OF_WINDOWS)
+# define OF_HAVE_ASYNC_FILE_IO
+#endif
+
+#ifdef OF_HAVE_ASYNC_FILE_IO
+# import "OFPlainCondition.h"
+# import "OFPlainMutex.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+/*
+ * Regular files are always ready for reading and writing, so observing them
+ * directly would make the run loop block on every read and write. Instead,
+ * OFRunLoop observes this object, which performs one read or write of the
+ * file at a time in the background, using io_uring if available and worker
+ * threads otherwise. It is ready for reading whenever no operation is in
+ * progress, which is signaled through a pipe.
+ */
+OF_SUBCLASSING_RESTRICTED
+@interface OFAsyncFileIO: OFObject <OFReadyForReadingObserving>
+{
+@public
+	OFFile *_Nullable _file;
+	int _fileDescriptor, _notifyFD[2];
+	OFPlainMutex _mutex;
+	OFPlainCondition _condition;
+	int _state, _operation;
+	unsigned char *_Nullable _buffer;
+	size_t _bufferSize, _length, _consumed;
+	size_t _result;
+	int _errNo;
+	size_t _numObservers;
+	/*
+	 * The run loop request currently being handled for the file and the
+	 * one that started the operation in progress or done.
+	 */
+	id _Nullable _currentRequest, _owner;
+	OFAsyncFileIO *_Nullable _next;
+}
+
+- (instancetype)initWithFile: (OFFile *)file
+	      fileDescriptor: (int)fileDescriptor;
+
+/*
+ * Returns false if the file is not observed by a run loop and no result of a
+ * background read is left, in which case the caller needs to read itself.
+ * Throws an OFReadFailedException with EAGAIN if a background read has been
+ * started or is still in progress.
+ */
+- (bool)readIntoBuffer: (void *)buffer
+		length: (size_t)length
+	     bytesRead: (size_t *)bytesRead;
+
+/*
+ * Returns false if the file is not observed by a run loop, in which case the
+ * caller needs to write itself. Throws an OFWriteFailedException with EAGAIN
+ * if a background write has been started or is still in progress. The result
+ * of a background write is only returned to the request that started it, so
+ * the run loop needs to set _currentRequest while it handles a request.
+ */
+- (bool)writeBuffer: (const void *)buffer
+	     length: (size_t)length
+       bytesWritten: (size_t *)bytesWritten;
+
+/*
+ * Waits for an operation in progress and gives back data that was read ahead,
+ * so that the file position is where the caller expects it.
+ */
+- (void)finishOperation;
+
+/* Called by the run loop when it starts or stops observing the file. */
+- (void)addObserver;
+- (void)removeObserver;
+@end
+
+OF_ASSUME_NONNULL_END
+#endif
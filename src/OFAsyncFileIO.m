@@ -0,0 +1,699 @@
+/*
+ * Copyright (c) 2008-2026 Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3.0 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * version 3.0 along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+
+#include "unistd_wrapper.h"
+
+#import "OFAsyncFileIO.h"
+
+#ifdef OF_HAVE_ASYNC_FILE_IO
+# if defined(HAVE_IO_URING) && defined(IORING_FEAT_RW_CUR_POS)
+#  define USE_IO_URING
+# endif
+
+# ifdef USE_IO_URING
+#  include <linux/io_uring.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+# endif
+
+# import "OFAtomic.h"
+# import "OFOnce.h"
+# import "OFPlainThread.h"
+
+# import "OFInitializationFailedException.h"
+# import "OFOutOfRangeException.h"
+# import "OFReadFailedException.h"
+# import "OFWriteFailedException.h"
+
+enum {
+	stateIdle,
+	stateBusy,
+	stateDone
+};
+enum {
+	operationRead,
+	operationWrite
+};
+
+static const size_t maxWorkers = 4;
+
+static OFPlainMutex queueMutex;
+static OFPlainCondition queueCondition;
+static OFAsyncFileIO *firstQueued = nil, *lastQueued = nil;
+static size_t numWorkers = 0, numIdleWorkers = 0;
+
+# ifdef USE_IO_URING
+static const unsigned int numEntries = 64;
+
+/*
+ * A single ring is shared by all files. Submissions are serialized by a mutex,
+ * while a dedicated thread reaps the completions.
+ */
+static OFPlainMutex ringMutex;
+static int ringFD = -1;
+static struct io_uring_sqe *SQEs;
+static unsigned int *SQHead, *SQTail, *SQArray, SQMask, SQEntries;
+static unsigned int *CQHead, *CQTail, CQMask;
+static struct io_uring_cqe *CQEs;
+
+static int
+ioUringSetup(unsigned int entries, struct io_uring_params *params)
+{
+	return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int
+ioUringEnter(int fd, unsigned int toSubmit, unsigned int minComplete,
+    unsigned int flags)
+{
+	return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete,
+	    flags, NULL, 0);
+}
+# endif
+
+static void
+completeOperation(OFAsyncFileIO *operation, size_t result, int errNo)
+{
+	OFEnsure(OFPlainMutexLock(&operation->_mutex) == 0);
+
+	operation->_result = result;
+	operation->_errNo = errNo;
+	operation->_consumed = 0;
+	operation->_state = stateDone;
+
+	while (write(operation->_notifyFD[1], "", 1) < 1)
+		OFEnsure(errno == EINTR);
+
+	OFEnsure(OFPlainConditionBroadcast(&operation->_condition) == 0);
+	OFEnsure(OFPlainMutexUnlock(&operation->_mutex) == 0);
+
+	/* Retained when the operation was submitted. */
+	objc_release(operation);
+}
+
+static void
+performOperation(OFAsyncFileIO *operation)
+{
+	ssize_t ret;
+
+	do {
+		if (operation->_operation == operationRead)
+			ret = read(operation->_fileDescriptor,
+			    operation->_buffer, operation->_length);
+		else
+			ret = write(operation->_fileDescriptor,
+			    operation->_buffer, operation->_length);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret < 0)
+		completeOperation(operation, 0, errno);
+	else
+		completeOperation(operation, (size_t)ret, 0);
+}
+
+static void
+workerMain(id object)
+{
+	OFEnsure(OFPlainMutexLock(&queueMutex) == 0);
+
+	for (;;) {
+		OFAsyncFileIO *operation;
+
+		while (firstQueued == nil) {
+			numIdleWorkers++;
+			OFEnsure(OFPlainConditionWait(&queueCondition,
+			    &queueMutex) == 0);
+			numIdleWorkers--;
+		}
+
+		operation = firstQueued;
+		if ((firstQueued = operation->_next) == nil)
+			lastQueued = nil;
+		operation->_next = nil;
+
+		OFEnsure(OFPlainMutexUnlock(&queueMutex) == 0);
+		performOperation(operation);
+		OFEnsure(OFPlainMutexLock(&queueMutex) == 0);
+	}
+}
+
+static void
+enqueueOperation(OFAsyncFileIO *operation)
+{
+	OFEnsure(OFPlainMutexLock(&queueMutex) == 0);
+
+	if (numIdleWorkers == 0 && numWorkers < maxWorkers) {
+		OFPlainThread thread;
+
+		if (OFPlainThreadNew(&thread, "OFAsyncFileIO", workerMain, nil,
+		    NULL) == 0) {
+			OFPlainThreadDetach(thread);
+			numWorkers++;
+		}
+	}
+
+	/* Without any worker, the operation has to be performed right away. */
+	if (numWorkers == 0) {
+		OFEnsure(OFPlainMutexUnlock(&queueMutex) == 0);
+		performOperation(operation);
+		return;
+	}
+
+	if (lastQueued != nil)
+		lastQueued->_next = operation;
+	else
+		firstQueued = operation;
+	lastQueued = operation;
+
+	OFEnsure(OFPlainConditionSignal(&queueCondition) == 0);
+	OFEnsure(OFPlainMutexUnlock(&queueMutex) == 0);
+}
+
+# ifdef USE_IO_URING
+static void
+reaperMain(id object)
+{
+	for (;;) {
+		unsigned int head = *CQHead;
+		unsigned int tail = *(volatile unsigned int *)CQTail;
+
+		OFAcquireMemoryBarrier();
+
+		for (; head != tail; head++) {
+			struct io_uring_cqe cqe = CQEs[head & CQMask];
+			OFAsyncFileIO *operation =
+			    (OFAsyncFileIO *)(uintptr_t)cqe.user_data;
+
+			OFReleaseMemoryBarrier();
+			*(volatile unsigned int *)CQHead = head + 1;
+
+			if (cqe.res < 0)
+				completeOperation(operation, 0, -cqe.res);
+			else
+				completeOperation(operation,
+				    (size_t)cqe.res, 0);
+		}
+
+		if (ioUringEnter(ringFD, 0, 1, IORING_ENTER_GETEVENTS) < 0)
+			OFEnsure(errno == EINTR);
+	}
+}
+
+static bool
+setUpRing(void)
+{
+	struct io_uring_params params;
+	size_t SQRingSize, CQRingSize, SQEsSize;
+	char *SQRing, *CQRing = NULL;
+	OFPlainThread thread;
+
+	memset(&params, 0, sizeof(params));
+
+	if ((ringFD = ioUringSetup(numEntries, &params)) == -1)
+		return false;
+
+	/*
+	 * Reads and writes need to use and update the file position like
+	 * read() and write() do, and completions must never be dropped.
+	 */
+	if (!(params.features & IORING_FEAT_RW_CUR_POS) ||
+	    !(params.features & IORING_FEAT_NODROP))
+		goto error;
+
+	SQRingSize = params.sq_off.array +
+	    params.sq_entries * sizeof(unsigned int);
+	CQRingSize = params.cq_off.cqes +
+	    params.cq_entries * sizeof(struct io_uring_cqe);
+	SQEsSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (CQRingSize > SQRingSize)
+			SQRingSize = CQRingSize;
+
+		CQRingSize = 0;
+	}
+
+	/* The ring lives as long as the process, so it is never unmapped. */
+	if ((SQRing = mmap(NULL, SQRingSize, PROT_READ | PROT_WRITE,
+	    MAP_SHARED | MAP_POPULATE, ringFD,
+	    IORING_OFF_SQ_RING)) == MAP_FAILED)
+		goto error;
+
+	if (CQRingSize > 0) {
+		if ((CQRing = mmap(NULL, CQRingSize, PROT_READ | PROT_WRITE,
+		    MAP_SHARED | MAP_POPULATE, ringFD,
+		    IORING_OFF_CQ_RING)) == MAP_FAILED)
+			goto error_sq_ring;
+	}
+
+	if ((SQEs = mmap(NULL, SQEsSize, PROT_READ | PROT_WRITE,
+	    MAP_SHARED | MAP_POPULATE, ringFD,
+	    IORING_OFF_SQES)) == MAP_FAILED)
+		goto error_cq_ring;
+
+	SQHead = (unsigned int *)(void *)(SQRing + params.sq_off.head);
+	SQTail = (unsigned int *)(void *)(SQRing + params.sq_off.tail);
+	SQArray = (unsigned int *)(void *)(SQRing + params.sq_off.array);
+	SQMask = *(unsigned int *)(void *)(SQRing + params.sq_off.ring_mask);
+	SQEntries =
+	    *(unsigned int *)(void *)(SQRing + params.sq_off.ring_entries);
+
+	if (CQRing == NULL)
+		CQRing = SQRing;
+
+	CQHead = (unsigned int *)(void *)(CQRing + params.cq_off.head);
+	CQTail = (unsigned int *)(void *)(CQRing + params.cq_off.tail);
+	CQMask = *(unsigned int *)(void *)(CQRing + params.cq_off.ring_mask);
+	CQEs = (struct io_uring_cqe *)(void *)(CQRing + params.cq_off.cqes);
+
+	if (OFPlainMutexNew(&ringMutex) != 0)
+		goto error_sqes;
+
+	if (OFPlainThreadNew(&thread, "OFAsyncFileIO", reaperMain, nil,
+	    NULL) != 0) {
+		OFPlainMutexFree(&ringMutex);
+		goto error_sqes;
+	}
+
+	OFPlainThreadDetach(thread);
+
+	return true;
+
+error_sqes:
+	munmap(SQEs, SQEsSize);
+error_cq_ring:
+	if (CQRing != NULL)
+		munmap(CQRing, CQRingSize);
+error_sq_ring:
+	munmap(SQRing, SQRingSize);
+error:
+	close(ringFD);
+	ringFD = -1;
+
+	return false;
+}
+
+static bool
+submitToRing(OFAsyncFileIO *operation)
+{
+	struct io_uring_sqe *sqe;
+	unsigned int head, tail, index;
+	int submitted;
+
+	OFEnsure(OFPlainMutexLock(&ringMutex) == 0);
+
+	tail = *SQTail;
+	head = *(volatile unsigned int *)SQHead;
+	OFAcquireMemoryBarrier();
+
+	if (tail - head >= SQEntries) {
+		OFEnsure(OFPlainMutexUnlock(&ringMutex) == 0);
+		return false;
+	}
+
+	index = tail & SQMask;
+	sqe = &SQEs[index];
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = (operation->_operation == operationRead
+	    ? IORING_OP_READ : IORING_OP_WRITE);
+	sqe->fd = operation->_fileDescriptor;
+	/* An offset of -1 means the current file position. */
+	sqe->off = (uint64_t)-1;
+	sqe->addr = (uint64_t)(uintptr_t)operation->_buffer;
+	sqe->len = (uint32_t)operation->_length;
+	sqe->user_data = (uint64_t)(uintptr_t)operation;
+	SQArray[index] = index;
+
+	OFReleaseMemoryBarrier();
+	*(volatile unsigned int *)SQTail = tail + 1;
+
+	do {
+		submitted = ioUringEnter(ringFD, 1, 0, 0);
+	} while (submitted < 0 && errno == EINTR);
+
+	/*
+	 * The kernel only consumes submissions in io_uring_enter(), which is
+	 * serialized by the mutex, so a failed submission can be taken back.
+	 */
+	if (submitted < 1) {
+		*(volatile unsigned int *)SQTail = tail;
+		OFEnsure(OFPlainMutexUnlock(&ringMutex) == 0);
+		return false;
+	}
+
+	OFEnsure(OFPlainMutexUnlock(&ringMutex) == 0);
+
+	return true;
+}
+# endif
+
+static void
+initEngine(void)
+{
+	OFEnsure(OFPlainMutexNew(&queueMutex) == 0);
+	OFEnsure(OFPlainConditionNew(&queueCondition) == 0);
+
+# ifdef USE_IO_URING
+	setUpRing();
+# endif
+}
+
+static void
+submitOperation(OFAsyncFileIO *operation)
+{
+	static OFOnceControl onceControl = OFOnceControlInitValue;
+
+	OFOnce(&onceControl, initEngine);
+
+	/* Released once the operation completed. */
+	objc_retain(operation);
+
+# ifdef USE_IO_URING
+	if (ringFD != -1 && operation->_length <= UINT32_MAX &&
+	    submitToRing(operation))
+		return;
+# endif
+
+	enqueueOperation(operation);
+}
+
+@implementation OFAsyncFileIO
+- (instancetype)init
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithFile: (OFFile *)file
+	      fileDescriptor: (int)fileDescriptor
+{
+	self = [super init];
+
+	@try {
+		_file = file;
+		_fileDescriptor = fileDescriptor;
+		_notifyFD[0] = _notifyFD[1] = -1;
+
+		if (pipe(_notifyFD) != 0)
+			@throw [OFInitializationFailedException
+			    exceptionWithClass: self.class];
+
+		if (OFPlainMutexNew(&_mutex) != 0) {
+			close(_notifyFD[0]);
+			close(_notifyFD[1]);
+			_notifyFD[0] = _notifyFD[1] = -1;
+
+			@throw [OFInitializationFailedException
+			    exceptionWithClass: self.class];
+		}
+
+		if (OFPlainConditionNew(&_condition) != 0) {
+			OFPlainMutexFree(&_mutex);
+			close(_notifyFD[0]);
+			close(_notifyFD[1]);
+			_notifyFD[0] = _notifyFD[1] = -1;
+
+			@throw [OFInitializationFailedException
+			    exceptionWithClass: self.class];
+		}
+
+		/*
+		 * The pipe contains a byte whenever no operation is in
+		 * progress, so that the run loop sees us as ready.
+		 */
+		while (write(_notifyFD[1], "", 1) < 1)
+			OFEnsure(errno == EINTR);
+	} @catch (id e) {
+		objc_release(self);
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	if (_notifyFD[0] != -1) {
+		OFPlainConditionFree(&_condition);
+		OFPlainMutexFree(&_mutex);
+		close(_notifyFD[0]);
+		close(_notifyFD[1]);
+	}
+
+	objc_release(_owner);
+	OFFreeMemory(_buffer);
+
+	[super dealloc];
+}
+
+- (int)fileDescriptorForReading
+{
+	return _notifyFD[0];
+}
+
+static void
+startOperation(OFAsyncFileIO *self, int operation, size_t length)
+{
+	char buffer;
+
+	if (length > self->_bufferSize) {
+		self->_buffer = OFResizeMemory(self->_buffer, length, 1);
+		self->_bufferSize = length;
+	}
+
+	self->_operation = operation;
+	self->_length = length;
+	self->_state = stateBusy;
+	objc_release(self->_owner);
+	self->_owner = (operation == operationWrite
+	    ? objc_retain(self->_currentRequest) : nil);
+
+	while (read(self->_notifyFD[0], &buffer, 1) < 1)
+		OFEnsure(errno == EINTR);
+}
+
+static void
+discardResult(OFAsyncFileIO *self)
+{
+	/*
+	 * Data that was read ahead but not consumed yet needs to be given
+	 * back, so that the next operation starts where the caller expects.
+	 *
+	 * A write cannot be taken back, so its data stays in the file, just
+	 * like it would if the request that started it had written it itself
+	 * before being cancelled.
+	 */
+	if (self->_operation == operationRead && self->_errNo == 0 &&
+	    self->_result > self->_consumed)
+		lseek(self->_fileDescriptor,
+		    -(off_t)(self->_result - self->_consumed), SEEK_CUR);
+
+	objc_release(self->_owner);
+	self->_owner = nil;
+	self->_state = stateIdle;
+}
+
+- (bool)readIntoBuffer: (void *)buffer
+		length: (size_t)length
+	     bytesRead: (size_t *)bytesRead
+{
+	bool ret = true, submit = false;
+	int errNo = 0;
+
+	if (length > SSIZE_MAX)
+		@throw [OFOutOfRangeException exception];
+
+	OFEnsure(OFPlainMutexLock(&_mutex) == 0);
+
+	for (;;) {
+		if (_state == stateIdle) {
+			if (_numObservers == 0) {
+				ret = false;
+				break;
+			}
+
+			startOperation(self, operationRead, length);
+			submit = true;
+			errNo = EAGAIN;
+			break;
+		}
+
+		if (_state == stateBusy) {
+			if (_numObservers > 0) {
+				errNo = EAGAIN;
+				break;
+			}
+
+			OFEnsure(OFPlainConditionWait(&_condition,
+			    &_mutex) == 0);
+			continue;
+		}
+
+		if (_operation != operationRead) {
+			discardResult(self);
+			continue;
+		}
+
+		if (_errNo != 0) {
+			errNo = _errNo;
+			_state = stateIdle;
+			break;
+		}
+
+		if (length > _result - _consumed)
+			length = _result - _consumed;
+
+		memcpy(buffer, _buffer + _consumed, length);
+		_consumed += length;
+
+		if (_consumed == _result)
+			_state = stateIdle;
+
+		*bytesRead = length;
+		break;
+	}
+
+	OFEnsure(OFPlainMutexUnlock(&_mutex) == 0);
+
+	/* Submitted without the lock, as it might complete right away. */
+	if (submit)
+		submitOperation(self);
+
+	if (errNo != 0)
+		@throw [OFReadFailedException exceptionWithObject: _file
+						  requestedLength: length
+							    errNo: errNo];
+
+	return ret;
+}
+
+- (bool)writeBuffer: (const void *)buffer
+	     length: (size_t)length
+       bytesWritten: (size_t *)bytesWritten
+{
+	bool ret = true, submit = false;
+	int errNo = 0;
+
+	if (length > SSIZE_MAX)
+		@throw [OFOutOfRangeException exception];
+
+	OFEnsure(OFPlainMutexLock(&_mutex) == 0);
+
+	for (;;) {
+		if (_state == stateIdle) {
+			if (_numObservers == 0) {
+				ret = false;
+				break;
+			}
+
+			startOperation(self, operationWrite, length);
+			memcpy(_buffer, buffer, length);
+			submit = true;
+			errNo = EAGAIN;
+			break;
+		}
+
+		if (_state == stateBusy) {
+			if (_numObservers > 0) {
+				errNo = EAGAIN;
+				break;
+			}
+
+			OFEnsure(OFPlainConditionWait(&_condition,
+			    &_mutex) == 0);
+			continue;
+		}
+
+		/*
+		 * The result of a write only belongs to the request that
+		 * started it. Anyone else would write the data again.
+		 */
+		if (_operation != operationWrite || _owner == nil ||
+		    _owner != _currentRequest || _result > length) {
+			discardResult(self);
+			continue;
+		}
+
+		objc_release(_owner);
+		_owner = nil;
+		_state = stateIdle;
+
+		if (_errNo != 0) {
+			errNo = _errNo;
+			break;
+		}
+
+		*bytesWritten = _result;
+		break;
+	}
+
+	OFEnsure(OFPlainMutexUnlock(&_mutex) == 0);
+
+	/* Submitted without the lock, as it might complete right away. */
+	if (submit)
+		submitOperation(self);
+
+	if (errNo != 0)
+		@throw [OFWriteFailedException exceptionWithObject: _file
+						   requestedLength: length
+						      bytesWritten: 0
+							     errNo: errNo];
+
+	return ret;
+}
+
+- (void)finishOperation
+{
+	OFEnsure(OFPlainMutexLock(&_mutex) == 0);
+
+	while (_state == stateBusy)
+		OFEnsure(OFPlainConditionWait(&_condition, &_mutex) == 0);
+
+	/*
+	 * A finished write already moved the file position, so its result is
+	 * kept for the request that started it, as it would write the data
+	 * again otherwise.
+	 */
+	if (_state == stateDone &&
+	    (_operation != operationWrite || _owner == nil))
+		discardResult(self);
+
+	OFEnsure(OFPlainMutexUnlock(&_mutex) == 0);
+}
+
+- (void)addObserver
+{
+	OFEnsure(OFPlainMutexLock(&_mutex) == 0);
+	_numObservers++;
+	OFEnsure(OFPlainMutexUnlock(&_mutex) == 0);
+}
+
+- (void)removeObserver
+{
+	OFEnsure(OFPlainMutexLock(&_mutex) == 0);
+	_numObservers--;
+	OFEnsure(OFPlainMutexUnlock(&_mutex) == 0);
+}
+@end
+#endif
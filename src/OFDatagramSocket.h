@@ -29,6 +29,22 @@ OF_ASSUME_NONNULL_BEGIN
 @class OFData;
 @class OFDatagramSocket;
 
+/**
+ * @struct OFDatagramSocketPacket OFDatagramSocket.h ObjFW/ObjFW.h
+ *
+ * @brief A datagram that is received or sent together with others.
+ */
+typedef struct {
+	/** The buffer to receive the datagram into or the datagram to send */
+	void *buffer;
+	/** The size of the buffer, which is only used for receiving */
+	size_t capacity;
+	/** The length of the received datagram or of the datagram to send */
+	size_t length;
+	/** The sender of the received datagram or the receiver to send to */
+	OFSocketAddress address;
+} OFDatagramSocketPacket;
+
 #ifdef OF_HAVE_BLOCKS
 /**
  * @brief A block which is called when a packet has been received.
@@ -88,6 +104,35 @@ typedef OFData *_Nullable (^OFDatagramSocketAsyncSendDataBlock)(
 typedef OFData *_Nullable (^OFDatagramSocketDataSentHandler)(
     OFDatagramSocket *socket, OFData *data,
     const OFSocketAddress *_Nonnull receiver, id _Nullable exception);
+
+/**
+ * @brief A handler which is called when packets have been received.
+ *
+ * @param socket The socket that received the packets
+ * @param packets The packets that have been received
+ * @param count The number of packets that have been received
+ * @param exception An exception which occurred while receiving or `nil` on
+ *		    success
+ * @return A bool whether the same handler should be used for the next receive
+ */
+typedef bool (^OFDatagramSocketPacketsReceivedHandler)(
+    OFDatagramSocket *socket, OFDatagramSocketPacket *packets, size_t count,
+    id _Nullable exception);
+
+/**
+ * @brief A handler which is called when packets have been sent.
+ *
+ * @param socket The socket that sent the packets
+ * @param packets The packets that have been sent
+ * @param count The number of packets that have been sent, which is less than
+ *		the number of packets passed if an exception occurred
+ * @param exception An exception which occurred while sending or `nil` on
+ *		    success
+ * @return A bool whether the same packets should be sent again
+ */
+typedef bool (^OFDatagramSocketPacketsSentHandler)(
+    OFDatagramSocket *socket, const OFDatagramSocketPacket *packets,
+    size_t count, id _Nullable exception);
 #endif
 
 /**
@@ -127,6 +172,36 @@ typedef OFData *_Nullable (^OFDatagramSocketDataSentHandler)(
 		didSendData: (OFData *)data
 		   receiver: (const OFSocketAddress *_Nonnull)receiver
 		  exception: (nullable id)exception;
+
+/**
+ * @brief This method is called when packets have been received.
+ *
+ * @param socket The datagram socket which received the packets
+ * @param packets The packets that have been received
+ * @param count The number of packets that have been received
+ * @param exception An exception that occurred while receiving, or nil on
+ *		    success
+ * @return A bool whether the same handler should be used for the next receive
+ */
+-	(bool)socket: (OFDatagramSocket *)socket
+   didReceivePackets: (OFDatagramSocketPacket *)packets
+	       count: (size_t)count
+	   exception: (nullable id)exception;
+
+/**
+ * @brief This method is called when packets have been sent.
+ *
+ * @param socket The datagram socket which sent the packets
+ * @param packets The packets that have been sent
+ * @param count The number of packets that have been sent, which is less than
+ *		the number of packets passed if an exception occurred
+ * @param exception An exception that occurred while sending, or nil on success
+ * @return A bool whether the same packets should be sent again
+ */
+-	(bool)socket: (OFDatagramSocket *)socket
+      didSendPackets: (const OFDatagramSocketPacket *)packets
+	       count: (size_t)count
+	   exception: (nullable id)exception;
 @end
 
 /**
@@ -327,6 +402,85 @@ typedef OFData *_Nullable (^OFDatagramSocketDataSentHandler)(
 		       handler: (OFDatagramSocketPacketReceivedHandler)handler;
 #endif
 
+/**
+ * @brief Receives several datagrams at once.
+ *
+ * This waits for the first datagram if the socket can block and then receives
+ * as many of the datagrams that are already available as fit into the
+ * specified packets. Each datagram is truncated to the capacity of its packet.
+ *
+ * On Linux, this only needs a single system call.
+ *
+ * @param packets The packets to receive the datagrams into. The buffer and
+ *		  capacity of each packet must be set.
+ * @param count The number of packets
+ * @return The number of packets that have been received
+ * @throw OFReadFailedException Receiving failed
+ * @throw OFNotOpenException The socket is not open
+ */
+- (size_t)receivePackets: (OFDatagramSocketPacket *)packets
+		   count: (size_t)count;
+
+/**
+ * @brief Asynchronously receives several datagrams at once.
+ *
+ * @param packets The packets to receive the datagrams into. The buffer and
+ *		  capacity of each packet must be set and the packets must stay
+ *		  valid until the receive has completed.
+ * @param count The number of packets
+ */
+- (void)asyncReceivePackets: (OFDatagramSocketPacket *)packets
+		      count: (size_t)count;
+
+/**
+ * @brief Asynchronously receives several datagrams at once.
+ *
+ * @param packets The packets to receive the datagrams into. The buffer and
+ *		  capacity of each packet must be set and the packets must stay
+ *		  valid until the receive has completed.
+ * @param count The number of packets
+ * @param runLoopMode The run loop mode in which to perform the asynchronous
+ *		      receive
+ */
+- (void)asyncReceivePackets: (OFDatagramSocketPacket *)packets
+		      count: (size_t)count
+		runLoopMode: (OFRunLoopMode)runLoopMode;
+
+#ifdef OF_HAVE_BLOCKS
+/**
+ * @brief Asynchronously receives several datagrams at once.
+ *
+ * @param packets The packets to receive the datagrams into. The buffer and
+ *		  capacity of each packet must be set and the packets must stay
+ *		  valid until the receive has completed.
+ * @param count The number of packets
+ * @param handler The handler to call when datagrams have been received. If the
+ *		  handler returns true, it will be called again with the same
+ *		  packets when more datagrams have been received.
+ */
+- (void)asyncReceivePackets: (OFDatagramSocketPacket *)packets
+		      count: (size_t)count
+		    handler: (OFDatagramSocketPacketsReceivedHandler)handler;
+
+/**
+ * @brief Asynchronously receives several datagrams at once.
+ *
+ * @param packets The packets to receive the datagrams into. The buffer and
+ *		  capacity of each packet must be set and the packets must stay
+ *		  valid until the receive has completed.
+ * @param count The number of packets
+ * @param runLoopMode The run loop mode in which to perform the asynchronous
+ *		      receive
+ * @param handler The handler to call when datagrams have been received. If the
+ *		  handler returns true, it will be called again with the same
+ *		  packets when more datagrams have been received.
+ */
+- (void)asyncReceivePackets: (OFDatagramSocketPacket *)packets
+		      count: (size_t)count
+		runLoopMode: (OFRunLoopMode)runLoopMode
+		    handler: (OFDatagramSocketPacketsReceivedHandler)handler;
+#endif
+
 /**
  * @brief Sends the specified datagram to the specified address.
  *
@@ -436,6 +590,80 @@ typedef OFData *_Nullable (^OFDatagramSocketDataSentHandler)(
 	      handler: (OFDatagramSocketDataSentHandler)handler;
 #endif
 
+/**
+ * @brief Sends several datagrams at once.
+ *
+ * On Linux, this only needs a single system call.
+ *
+ * @param packets The packets to send. The buffer, length and address of each
+ *		  packet must be set.
+ * @param count The number of packets
+ * @return The number of packets that have been sent, which can only be less
+ *	   than `count` if the socket cannot block
+ * @throw OFWriteFailedException Sending the first packet failed
+ * @throw OFNotOpenException The socket is not open
+ */
+- (size_t)sendPackets: (const OFDatagramSocketPacket *)packets
+		count: (size_t)count;
+
+/**
+ * @brief Asynchronously sends several datagrams at once.
+ *
+ * @param packets The packets to send. The buffer, length and address of each
+ *		  packet must be set and the packets must stay valid until the
+ *		  send has completed.
+ * @param count The number of packets
+ */
+- (void)asyncSendPackets: (const OFDatagramSocketPacket *)packets
+		   count: (size_t)count;
+
+/**
+ * @brief Asynchronously sends several datagrams at once.
+ *
+ * @param packets The packets to send. The buffer, length and address of each
+ *		  packet must be set and the packets must stay valid until the
+ *		  send has completed.
+ * @param count The number of packets
+ * @param runLoopMode The run loop mode in which to perform the asynchronous
+ *		      send
+ */
+- (void)asyncSendPackets: (const OFDatagramSocketPacket *)packets
+		   count: (size_t)count
+	     runLoopMode: (OFRunLoopMode)runLoopMode;
+
+#ifdef OF_HAVE_BLOCKS
+/**
+ * @brief Asynchronously sends several datagrams at once.
+ *
+ * @param packets The packets to send. The buffer, length and address of each
+ *		  packet must be set and the packets must stay valid until the
+ *		  send has completed.
+ * @param count The number of packets
+ * @param handler The handler to call when the packets have been sent. If it
+ *		  returns true, the same packets are sent again.
+ */
+- (void)asyncSendPackets: (const OFDatagramSocketPacket *)packets
+		   count: (size_t)count
+		 handler: (OFDatagramSocketPacketsSentHandler)handler;
+
+/**
+ * @brief Asynchronously sends several datagrams at once.
+ *
+ * @param packets The packets to send. The buffer, length and address of each
+ *		  packet must be set and the packets must stay valid until the
+ *		  send has completed.
+ * @param count The number of packets
+ * @param runLoopMode The run loop mode in which to perform the asynchronous
+ *		      send
+ * @param handler The handler to call when the packets have been sent. If it
+ *		  returns true, the same packets are sent again.
+ */
+- (void)asyncSendPackets: (const OFDatagramSocketPacket *)packets
+		   count: (size_t)count
+	     runLoopMode: (OFRunLoopMode)runLoopMode
+		 handler: (OFDatagramSocketPacketsSentHandler)handler;
+#endif
+
 /**
  * @brief Releases the socket from the current thread.
  *
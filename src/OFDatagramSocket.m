@@ -25,10 +25,14 @@
 #define _HPUX_ALT_XOPEN_SOCKET_API
 
 #include <errno.h>
+#include <string.h>
 
 #ifdef HAVE_FCNTL_H
 # include <fcntl.h>
 #endif
+#ifdef HAVE_SYS_UIO_H
+# include <sys/uio.h>
+#endif
 
 #import "OFDatagramSocket.h"
 #import "OFData.h"
@@ -52,6 +56,60 @@
 # define UNIQUE_ID -1
 #endif
 
+/* The number of packets passed to the kernel at once. */
+#define maxBatchCount 64
+
+/*
+ * Subclasses like OFIPXSocket and OFDDPSocket adjust every datagram in their
+ * overrides, which the batched system calls would bypass.
+ */
+static bool
+isOverridden(OFDatagramSocket *self, SEL selector)
+{
+	return ([self methodForSelector: selector] !=
+	    [OFDatagramSocket instanceMethodForSelector: selector]);
+}
+
+static void
+setSocketAddressFamily(OFSocketAddress *address)
+{
+	struct sockaddr *sa = (struct sockaddr *)&address->sockaddr;
+
+	if (address->length < (socklen_t)sizeof(sa->sa_family)) {
+		address->family = OFSocketAddressFamilyUnknown;
+		return;
+	}
+
+	switch (sa->sa_family) {
+	case AF_INET:
+		address->family = OFSocketAddressFamilyIPv4;
+		break;
+#ifdef OF_HAVE_IPV6
+	case AF_INET6:
+		address->family = OFSocketAddressFamilyIPv6;
+		break;
+#endif
+#ifdef OF_HAVE_UNIX_SOCKETS
+	case AF_UNIX:
+		address->family = OFSocketAddressFamilyUNIX;
+		break;
+#endif
+#ifdef OF_HAVE_IPX
+	case AF_IPX:
+		address->family = OFSocketAddressFamilyIPX;
+		break;
+#endif
+#ifdef OF_HAVE_APPLETALK
+	case AF_APPLETALK:
+		address->family = OFSocketAddressFamilyAppleTalk;
+		break;
+#endif
+	default:
+		address->family = OFSocketAddressFamilyUnknown;
+		break;
+	}
+}
+
 @implementation OFDatagramSocket
 @synthesize delegate = _delegate;
 
@@ -208,41 +266,8 @@
 				  errNo: _OFSocketErrNo()];
 #endif
 
-	if (sender != NULL) {
-		struct sockaddr *sa = (struct sockaddr *)&sender->sockaddr;
-
-		if (sender->length >= (socklen_t)sizeof(sa->sa_family)) {
-			switch (sa->sa_family) {
-			case AF_INET:
-				sender->family = OFSocketAddressFamilyIPv4;
-				break;
-#ifdef OF_HAVE_IPV6
-			case AF_INET6:
-				sender->family = OFSocketAddressFamilyIPv6;
-				break;
-#endif
-#ifdef OF_HAVE_UNIX_SOCKETS
-			case AF_UNIX:
-				sender->family = OFSocketAddressFamilyUNIX;
-				break;
-#endif
-#ifdef OF_HAVE_IPX
-			case AF_IPX:
-				sender->family = OFSocketAddressFamilyIPX;
-				break;
-#endif
-#ifdef OF_HAVE_APPLETALK
-			case AF_APPLETALK:
-				sender->family = OFSocketAddressFamilyAppleTalk;
-				break;
-#endif
-			default:
-				sender->family = OFSocketAddressFamilyUnknown;
-				break;
-			}
-		} else
-			sender->family = OFSocketAddressFamilyUnknown;
-	}
+	if (sender != NULL)
+		setSocketAddressFamily(sender);
 
 	return ret;
 }
@@ -326,6 +351,145 @@
 }
 #endif
 
+- (size_t)receivePackets: (OFDatagramSocketPacket *)packets
+		   count: (size_t)count
+{
+	if (_socket == OFInvalidSocketHandle)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	if (count == 0)
+		return 0;
+
+	if (isOverridden(self,
+	    @selector(receiveIntoBuffer:length:sender:))) {
+		packets[0].length = [self
+		    receiveIntoBuffer: packets[0].buffer
+			       length: packets[0].capacity
+			       sender: &packets[0].address];
+		return 1;
+	}
+
+#if defined(HAVE_RECVMMSG) && defined(MSG_WAITFORONE)
+	struct mmsghdr messages[maxBatchCount];
+	struct iovec iov[maxBatchCount];
+	int ret;
+
+	if (count > maxBatchCount)
+		count = maxBatchCount;
+
+	memset(messages, 0, count * sizeof(*messages));
+
+	for (size_t i = 0; i < count; i++) {
+		iov[i].iov_base = packets[i].buffer;
+		iov[i].iov_len = packets[i].capacity;
+
+		messages[i].msg_hdr.msg_name = &packets[i].address.sockaddr;
+		messages[i].msg_hdr.msg_namelen =
+		    (socklen_t)sizeof(packets[i].address.sockaddr);
+		messages[i].msg_hdr.msg_iov = &iov[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	/*
+	 * MSG_WAITFORONE only waits for the first datagram and then receives
+	 * the ones that are already available.
+	 */
+	while ((ret = recvmmsg(_socket, messages, (unsigned int)count,
+	    MSG_WAITFORONE, NULL)) < 0) {
+		int errNo = _OFSocketErrNo();
+
+		if (errNo != EINTR)
+			@throw [OFReadFailedException
+			    exceptionWithObject: self
+				requestedLength: packets[0].capacity
+					  errNo: errNo];
+	}
+
+	for (int i = 0; i < ret; i++) {
+		packets[i].length = messages[i].msg_len;
+		packets[i].address.length = messages[i].msg_hdr.msg_namelen;
+		setSocketAddressFamily(&packets[i].address);
+	}
+
+	return ret;
+#else
+	size_t received;
+
+	packets[0].length = [self receiveIntoBuffer: packets[0].buffer
+					     length: packets[0].capacity
+					     sender: &packets[0].address];
+	received = 1;
+
+# if defined(MSG_DONTWAIT) && !defined(OF_WINDOWS)
+	/* Only receive the datagrams that are already available. */
+	for (; received < count; received++) {
+		OFDatagramSocketPacket *packet = &packets[received];
+		ssize_t ret;
+
+		packet->address.length =
+		    (socklen_t)sizeof(packet->address.sockaddr);
+
+		if ((ret = recvfrom(_socket, packet->buffer, packet->capacity,
+		    MSG_DONTWAIT, (struct sockaddr *)&packet->address.sockaddr,
+		    &packet->address.length)) < 0)
+			break;
+
+		packet->length = ret;
+		setSocketAddressFamily(&packet->address);
+	}
+# endif
+
+	return received;
+#endif
+}
+
+- (void)asyncReceivePackets: (OFDatagramSocketPacket *)packets
+		      count: (size_t)count
+{
+	[self asyncReceivePackets: packets
+			    count: count
+		      runLoopMode: OFDefaultRunLoopMode];
+}
+
+- (void)asyncReceivePackets: (OFDatagramSocketPacket *)packets
+		      count: (size_t)count
+		runLoopMode: (OFRunLoopMode)runLoopMode
+{
+	[OFRunLoop of_addAsyncReceiveForDatagramSocket: self
+					       packets: packets
+						 count: count
+						  mode: runLoopMode
+# ifdef OF_HAVE_BLOCKS
+					       handler: NULL
+# endif
+					      delegate: _delegate];
+}
+
+#ifdef OF_HAVE_BLOCKS
+- (void)asyncReceivePackets: (OFDatagramSocketPacket *)packets
+		      count: (size_t)count
+		    handler: (OFDatagramSocketPacketsReceivedHandler)handler
+{
+	[self asyncReceivePackets: packets
+			    count: count
+		      runLoopMode: OFDefaultRunLoopMode
+			  handler: handler];
+}
+
+- (void)asyncReceivePackets: (OFDatagramSocketPacket *)packets
+		      count: (size_t)count
+		runLoopMode: (OFRunLoopMode)runLoopMode
+		    handler: (OFDatagramSocketPacketsReceivedHandler)handler
+{
+	[OFRunLoop of_addAsyncReceiveForDatagramSocket: self
+					       packets: packets
+						 count: count
+						  mode: runLoopMode
+					       handler: handler
+					      delegate: nil];
+}
+#endif
+
 - (void)sendBuffer: (const void *)buffer
 	    length: (size_t)length
 	  receiver: (const OFSocketAddress *)receiver
@@ -454,6 +618,132 @@
 }
 #endif
 
+- (size_t)sendPackets: (const OFDatagramSocketPacket *)packets
+		count: (size_t)count
+{
+	size_t sent = 0;
+
+	if (_socket == OFInvalidSocketHandle)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+#ifdef HAVE_SENDMMSG
+	bool batched =
+	    !isOverridden(self, @selector(sendBuffer:length:receiver:));
+
+	while (batched && sent < count) {
+		struct mmsghdr messages[maxBatchCount];
+		struct iovec iov[maxBatchCount];
+		size_t batchCount = count - sent;
+		int ret;
+
+		if (batchCount > maxBatchCount)
+			batchCount = maxBatchCount;
+
+		memset(messages, 0, batchCount * sizeof(*messages));
+
+		for (size_t i = 0; i < batchCount; i++) {
+			const OFDatagramSocketPacket *packet =
+			    &packets[sent + i];
+
+			iov[i].iov_base = packet->buffer;
+			iov[i].iov_len = packet->length;
+
+			messages[i].msg_hdr.msg_name =
+			    (void *)&packet->address.sockaddr;
+			messages[i].msg_hdr.msg_namelen =
+			    packet->address.length;
+			messages[i].msg_hdr.msg_iov = &iov[i];
+			messages[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		if ((ret = sendmmsg(_socket, messages,
+		    (unsigned int)batchCount, 0)) < 0) {
+			int errNo = _OFSocketErrNo();
+
+			if (errNo == EINTR)
+				continue;
+
+			/* Let the caller retry once the socket is writable. */
+			if (sent > 0 &&
+			    (errNo == EAGAIN || errNo == EWOULDBLOCK))
+				return sent;
+
+			@throw [OFWriteFailedException
+			    exceptionWithObject: self
+				requestedLength: packets[sent].length
+				   bytesWritten: 0
+					  errNo: errNo];
+		}
+
+		sent += ret;
+	}
+#endif
+
+	for (; sent < count; sent++) {
+		@try {
+			[self sendBuffer: packets[sent].buffer
+				  length: packets[sent].length
+				receiver: &packets[sent].address];
+		} @catch (OFWriteFailedException *e) {
+			/* Let the caller retry once the socket is writable. */
+			if (sent > 0 && (e.errNo == EAGAIN ||
+			    e.errNo == EWOULDBLOCK))
+				break;
+
+			@throw e;
+		}
+	}
+
+	return sent;
+}
+
+- (void)asyncSendPackets: (const OFDatagramSocketPacket *)packets
+		   count: (size_t)count
+{
+	[self asyncSendPackets: packets
+			 count: count
+		   runLoopMode: OFDefaultRunLoopMode];
+}
+
+- (void)asyncSendPackets: (const OFDatagramSocketPacket *)packets
+		   count: (size_t)count
+	     runLoopMode: (OFRunLoopMode)runLoopMode
+{
+	[OFRunLoop of_addAsyncSendForDatagramSocket: self
+					    packets: packets
+					      count: count
+					       mode: runLoopMode
+# ifdef OF_HAVE_BLOCKS
+					    handler: NULL
+# endif
+					   delegate: _delegate];
+}
+
+#ifdef OF_HAVE_BLOCKS
+- (void)asyncSendPackets: (const OFDatagramSocketPacket *)packets
+		   count: (size_t)count
+		 handler: (OFDatagramSocketPacketsSentHandler)handler
+{
+	[self asyncSendPackets: packets
+			 count: count
+		   runLoopMode: OFDefaultRunLoopMode
+		       handler: handler];
+}
+
+- (void)asyncSendPackets: (const OFDatagramSocketPacket *)packets
+		   count: (size_t)count
+	     runLoopMode: (OFRunLoopMode)runLoopMode
+		 handler: (OFDatagramSocketPacketsSentHandler)handler
+{
+	[OFRunLoop of_addAsyncSendForDatagramSocket: self
+					    packets: packets
+					      count: count
+					       mode: runLoopMode
+					    handler: handler
+					   delegate: nil];
+}
+#endif
+
 - (void)cancelAsyncRequests
 {
 	[OFRunLoop of_cancelAsyncRequestsForObject: self];
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2008-2026 Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3.0 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * version 3.0 along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#import "OFEnumerator.h"
+#import "OFFileManager.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFArray OF_GENERIC(ObjectType);
+@class OFIRI;
+@class OFMutableArray OF_GENERIC(ObjectType);
+
+/**
+ * @class OFDirectoryEnumerator OFDirectoryEnumerator.h ObjFW/ObjFW.h
+ *
+ * @brief A class for enumerating the items in a directory without building an
+ *	  array of all of them first.
+ *
+ * Only the attributes that have been requested are retrieved for each item.
+ * For local files, this often means that no additional system call is needed
+ * per item at all if only the type is requested.
+ *
+ * Fast enumeration retrieves one item at a time, so that
+ * @ref currentAttributes and @ref skipDescendants can be used in the loop.
+ */
+@interface OFDirectoryEnumerator: OFEnumerator OF_GENERIC(OFIRI *)
+{
+	OFIRI *_IRI;
+	OFDirectoryEnumeratorOptions _options;
+	OFArray OF_GENERIC(OFFileAttributeKey) *_Nullable _attributeKeys;
+	OFFileAttributes _Nullable _currentAttributes;
+	size_t _currentLevel;
+	OFMutableArray OF_GENERIC(OFEnumerator OF_GENERIC(OFIRI *) *)
+	    *_Nullable _enumerators;
+	OFIRI *_Nullable _pendingDirectoryIRI;
+	OF_RESERVE_IVARS(OFDirectoryEnumerator, 4)
+}
+
+/**
+ * @brief The IRI of the directory that is enumerated.
+ */
+@property (readonly, nonatomic) OFIRI *IRI;
+
+/**
+ * @brief The options for the enumeration.
+ */
+@property (readonly, nonatomic) OFDirectoryEnumeratorOptions options;
+
+/**
+ * @brief The keys of the attributes to retrieve for each item, or `nil` if
+ *	  only the type should be retrieved.
+ */
+@property OF_NULLABLE_PROPERTY (readonly, nonatomic)
+    OFArray OF_GENERIC(OFFileAttributeKey) *attributeKeys;
+
+/**
+ * @brief The attributes of the item that was last returned by
+ *	  @ref nextObject.
+ *
+ * This contains the requested attributes as well as @ref OFFileType, which is
+ * always retrieved. It might contain additional attributes if they could be
+ * retrieved together with the requested ones.
+ */
+@property OF_NULLABLE_PROPERTY (readonly, nonatomic)
+    OFFileAttributes currentAttributes;
+
+/**
+ * @brief The depth of the item that was last returned by @ref nextObject.
+ *
+ * The items directly in the enumerated directory have a level of 1.
+ */
+@property (readonly, nonatomic) size_t currentLevel;
+
+/**
+ * @brief Creates a new directory enumerator for the specified directory.
+ *
+ * @param IRI The IRI of the directory to enumerate
+ * @param options The options for the enumeration
+ * @param attributeKeys The keys of the attributes to retrieve for each item,
+ *			or `nil` if only the type should be retrieved
+ * @return A new, autoreleased directory enumerator
+ * @throw OFOpenItemFailedException Opening the directory failed
+ * @throw OFUnsupportedProtocolException No handler is registered for the IRI's
+ *					 scheme
+ */
++ (instancetype)
+    enumeratorWithIRI: (OFIRI *)IRI
+	      options: (OFDirectoryEnumeratorOptions)options
+	attributeKeys: (nullable OFArray OF_GENERIC(OFFileAttributeKey) *)
+			   attributeKeys;
+
+- (instancetype)init OF_UNAVAILABLE;
+
+/**
+ * @brief Initializes an already allocated directory enumerator for the
+ *	  specified directory.
+ *
+ * This uses @ref OFFileManager#contentsOfDirectoryAtIRI: and
+ * @ref OFFileManager#attributesOfItemAtIRI:. Use
+ * @ref OFFileManager#enumeratorAtIRI:options:attributeKeys: to get an
+ * enumerator that is optimized for the IRI's scheme.
+ *
+ * @param IRI The IRI of the directory to enumerate
+ * @param options The options for the enumeration
+ * @param attributeKeys The keys of the attributes to retrieve for each item,
+ *			or `nil` if only the type should be retrieved
+ * @return An initialized directory enumerator
+ * @throw OFOpenItemFailedException Opening the directory failed
+ * @throw OFUnsupportedProtocolException No handler is registered for the IRI's
+ *					 scheme
+ */
+- (instancetype)
+    initWithIRI: (OFIRI *)IRI
+	options: (OFDirectoryEnumeratorOptions)options
+  attributeKeys: (nullable OFArray OF_GENERIC(OFFileAttributeKey) *)
+		     attributeKeys OF_DESIGNATED_INITIALIZER;
+
+/**
+ * @brief Returns the IRI of the next item or `nil` if there is none left.
+ *
+ * @return The IRI of the next item or `nil` if there is none left
+ * @throw OFOpenItemFailedException Opening a subdirectory failed
+ * @throw OFReadFailedException Reading a directory failed
+ * @throw OFGetItemAttributesFailedException Retrieving the attributes of an
+ *					     item failed
+ */
+- (nullable OFIRI *)nextObject;
+
+/**
+ * @brief Skips the contents of the directory that was last returned by
+ *	  @ref nextObject when enumerating recursively.
+ */
+- (void)skipDescendants;
+@end
+
+OF_ASSUME_NONNULL_END
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2008-2026 Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3.0 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * version 3.0 along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#import "OFDirectoryEnumerator.h"
+#import "OFArray.h"
+#import "OFDictionary.h"
+#import "OFFileManager.h"
+#import "OFIRI.h"
+
+#import "OFInvalidArgumentException.h"
+
+@implementation OFDirectoryEnumerator
+@synthesize IRI = _IRI, options = _options, attributeKeys = _attributeKeys;
+@synthesize currentAttributes = _currentAttributes;
+@synthesize currentLevel = _currentLevel;
+
++ (instancetype)
+    enumeratorWithIRI: (OFIRI *)IRI
+	      options: (OFDirectoryEnumeratorOptions)options
+	attributeKeys: (OFArray OF_GENERIC(OFFileAttributeKey) *)attributeKeys
+{
+	return objc_autoreleaseReturnValue(
+	    [[self alloc] initWithIRI: IRI
+			      options: options
+			attributeKeys: attributeKeys]);
+}
+
+- (instancetype)init
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)
+    initWithIRI: (OFIRI *)IRI
+	options: (OFDirectoryEnumeratorOptions)options
+  attributeKeys: (OFArray OF_GENERIC(OFFileAttributeKey) *)attributeKeys
+{
+	self = [super init];
+
+	@try {
+		if (IRI == nil)
+			@throw [OFInvalidArgumentException exception];
+
+		_IRI = [IRI copy];
+		_options = options;
+		_attributeKeys = [attributeKeys copy];
+
+		/*
+		 * Subclasses only use the properties, so that they can read
+		 * the directory themselves.
+		 */
+		if (self.class == [OFDirectoryEnumerator class]) {
+			void *pool = objc_autoreleasePoolPush();
+			OFArray *contents = [[OFFileManager defaultManager]
+			    contentsOfDirectoryAtIRI: IRI];
+
+			_enumerators = [[OFMutableArray alloc]
+			    initWithObject: contents.objectEnumerator];
+
+			objc_autoreleasePoolPop(pool);
+		}
+	} @catch (id e) {
+		objc_release(self);
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	objc_release(_IRI);
+	objc_release(_attributeKeys);
+	objc_release(_currentAttributes);
+	objc_release(_enumerators);
+	objc_release(_pendingDirectoryIRI);
+
+	[super dealloc];
+}
+
+- (OFIRI *)nextObject
+{
+	OFFileManager *fileManager = [OFFileManager defaultManager];
+	void *pool = objc_autoreleasePoolPush();
+	OFEnumerator OF_GENERIC(OFIRI *) *enumerator;
+	OFIRI *IRI;
+	OFFileAttributes attributes;
+	OFMutableFileAttributes currentAttributes;
+	OFFileAttributeType type;
+
+	if (_pendingDirectoryIRI != nil) {
+		OFArray *contents = [fileManager
+		    contentsOfDirectoryAtIRI: _pendingDirectoryIRI];
+
+		[_enumerators addObject: contents.objectEnumerator];
+
+		objc_release(_pendingDirectoryIRI);
+		_pendingDirectoryIRI = nil;
+	}
+
+	while ((enumerator = _enumerators.lastObject) != nil) {
+		if ((IRI = [enumerator nextObject]) != nil)
+			break;
+
+		[_enumerators removeLastObject];
+	}
+
+	objc_release(_currentAttributes);
+	_currentAttributes = nil;
+
+	if (enumerator == nil) {
+		_currentLevel = 0;
+		objc_autoreleasePoolPop(pool);
+		return nil;
+	}
+
+	_currentLevel = _enumerators.count;
+
+	attributes = [fileManager attributesOfItemAtIRI: IRI];
+	type = attributes.fileType;
+
+	currentAttributes = [OFMutableDictionary dictionary];
+	[currentAttributes setObject: type forKey: OFFileType];
+
+	for (OFFileAttributeKey key in _attributeKeys) {
+		id object = [attributes objectForKey: key];
+
+		if (object != nil)
+			[currentAttributes setObject: object forKey: key];
+	}
+
+	[currentAttributes makeImmutable];
+	_currentAttributes = objc_retain(currentAttributes);
+
+	if ((_options & OFDirectoryEnumeratorOptionRecursive) &&
+	    [type isEqual: OFFileTypeDirectory])
+		_pendingDirectoryIRI = objc_retain(IRI);
+
+	objc_retain(IRI);
+	objc_autoreleasePoolPop(pool);
+
+	return objc_autoreleaseReturnValue(IRI);
+}
+
+- (int)countByEnumeratingWithState: (OFFastEnumerationState *)state
+			   objects: (id *)objects
+			     count: (int)count
+{
+	/*
+	 * Only return one item at a time, so that the current attributes
+	 * match the item in the loop.
+	 */
+	return [super countByEnumeratingWithState: state
+					  objects: objects
+					    count: (count > 0 ? 1 : 0)];
+}
+
+- (void)skipDescendants
+{
+	objc_release(_pendingDirectoryIRI);
+	_pendingDirectoryIRI = nil;
+}
+@end
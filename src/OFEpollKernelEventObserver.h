@@ -21,13 +21,29 @@
 
 OF_ASSUME_NONNULL_BEGIN
 
-@class OFMapTable;
+struct epoll_event;
+struct OFEpollFDState;
 
 @interface OFEpollKernelEventObserver: OFKernelEventObserver
 {
 	int _epfd;
-	OFMapTable *_FDToEvents;
+	struct OFEpollFDState *_FDStates;
+	size_t _FDStatesCount;
+	struct epoll_event *_eventList;
+	int _eventListSize;
+	bool _edgeTriggered;
 }
+
+/*
+ * Whether objects are observed edge-triggered. This can only be changed while
+ * no objects are being observed.
+ *
+ * In edge-triggered mode, the delegate is only informed again once new data
+ * arrived or more buffer space became available. It therefore needs to read or
+ * write until the object would block, which is why this is not used by
+ * OFRunLoop.
+ */
+@property (nonatomic, getter=isEdgeTriggered) bool edgeTriggered;
 @end
 
 OF_ASSUME_NONNULL_END
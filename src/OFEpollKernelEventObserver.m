@@ -20,6 +20,7 @@
 #include "config.h"
 
 #include <errno.h>
+#include <string.h>
 
 #ifdef HAVE_FCNTL_H
 # include <fcntl.h>
@@ -30,17 +31,34 @@
 
 #import "OFEpollKernelEventObserver.h"
 #import "OFArray.h"
-#import "OFMapTable.h"
-#import "OFNull.h"
+#import "OFStreamSocket.h"
 
 #import "OFInitializationFailedException.h"
+#import "OFInvalidArgumentException.h"
 #import "OFObserveKernelEventsFailedException.h"
+#import "OFOutOfMemoryException.h"
+#import "OFOutOfRangeException.h"
 
-#define eventListSize 64
+static const int minEventListSize = 64;
+static const int maxEventListSize = 4096;
 
-static const OFMapTableFunctions mapFunctions = { NULL };
+/* Stored together with EPOLLIN / EPOLLOUT in the per-fd state. */
+static const unsigned char exclusiveFlag = 0x80;
+
+/*
+ * The objects observed for a file descriptor, which are retained, and the
+ * events it is registered for with epoll. The objects are kept here instead of
+ * in the arrays of the superclass, as removing them from those would need a
+ * linear search. An entry is only ever matched by both descriptor and object.
+ */
+struct OFEpollFDState {
+	id readObject, writeObject;
+	unsigned char events;
+};
 
 @implementation OFEpollKernelEventObserver
+@synthesize edgeTriggered = _edgeTriggered;
+
 - (instancetype)initWithRunLoopMode: (OFRunLoopMode)runLoopMode
 {
 	self = [super initWithRunLoopMode: runLoopMode];
@@ -63,13 +81,13 @@ static const OFMapTableFunctions mapFunctions = { NULL };
 			fcntl(_epfd, F_SETFD, flags | FD_CLOEXEC);
 #endif
 
-		_FDToEvents = [[OFMapTable alloc]
-		    initWithKeyFunctions: mapFunctions
-			 objectFunctions: mapFunctions];
+		_eventList = OFAllocMemory(minEventListSize,
+		    sizeof(*_eventList));
+		_eventListSize = minEventListSize;
 
 		memset(&event, 0, sizeof(event));
 		event.events = EPOLLIN;
-		event.data.ptr = [OFNull null];
+		event.data.fd = _cancelFD[0];
 
 		if (epoll_ctl(_epfd, EPOLL_CTL_ADD, _cancelFD[0], &event) == -1)
 			@throw [OFInitializationFailedException
@@ -84,49 +102,116 @@ static const OFMapTableFunctions mapFunctions = { NULL };
 
 - (void)dealloc
 {
+	for (size_t i = 0; i < _FDStatesCount; i++) {
+		if (_FDStates[i].readObject != nil)
+			[self of_stopObservingReadBufferOfObject:
+			    _FDStates[i].readObject];
+
+		objc_release(_FDStates[i].readObject);
+		objc_release(_FDStates[i].writeObject);
+	}
+
 	close(_epfd);
 
-	objc_release(_FDToEvents);
+	OFFreeMemory(_FDStates);
+	OFFreeMemory(_eventList);
 
 	[super dealloc];
 }
 
-- (void)of_addObject: (id)object
-      fileDescriptor: (int)fd
-	      events: (int)addEvents OF_DIRECT
+- (void)setEdgeTriggered: (bool)edgeTriggered
 {
-	struct epoll_event event;
-	intptr_t events;
+	for (size_t i = 0; i < _FDStatesCount; i++)
+		if (_FDStates[i].events != 0)
+			@throw [OFInvalidArgumentException exception];
 
-	events = (intptr_t)[_FDToEvents
-	    objectForKey: (void *)((intptr_t)fd + 1)];
-
-	memset(&event, 0, sizeof(event));
-	event.events = (int)events | addEvents;
-	event.data.ptr = object;
+	_edgeTriggered = edgeTriggered;
+}
 
-	if (epoll_ctl(_epfd, (events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD),
-	    fd, &event) == -1)
+static struct OFEpollFDState *
+stateForFD(OFEpollKernelEventObserver *self, int fd, bool create)
+{
+	if (fd < 0)
 		@throw [OFObserveKernelEventsFailedException
 		    exceptionWithObserver: self
-				    errNo: errno];
+				    errNo: EBADF];
+
+	if ((size_t)fd >= self->_FDStatesCount) {
+		size_t newCount;
+
+		if (!create)
+			return NULL;
+
+		newCount = (self->_FDStatesCount > 0
+		    ? self->_FDStatesCount : 64);
+		while (newCount <= (size_t)fd) {
+			if (newCount > SIZE_MAX / 2)
+				@throw [OFOutOfRangeException exception];
 
-	[_FDToEvents setObject: (void *)(events | addEvents)
-			forKey: (void *)((intptr_t)fd + 1)];
+			newCount *= 2;
+		}
+
+		self->_FDStates = OFResizeMemory(self->_FDStates, newCount,
+		    sizeof(*self->_FDStates));
+		memset(self->_FDStates + self->_FDStatesCount, 0,
+		    (newCount - self->_FDStatesCount) *
+		    sizeof(*self->_FDStates));
+		self->_FDStatesCount = newCount;
+	}
+
+	return &self->_FDStates[fd];
 }
 
-- (void)of_removeObject: (id)object
-	 fileDescriptor: (int)fd
-		 events: (int)removeEvents OF_DIRECT
+#ifdef EPOLLEXCLUSIVE
+static bool
+isListening(id object)
 {
-	intptr_t events;
+	return ([object respondsToSelector: @selector(isListening)] &&
+	    [object isListening]);
+}
+#endif
 
-	events = (intptr_t)[_FDToEvents
-	    objectForKey: (void *)((intptr_t)fd + 1)];
-	events &= ~removeEvents;
+/*
+ * Drops the objects that no longer have the descriptor they are stored for,
+ * e.g. because they were closed without being removed first and the descriptor
+ * was reused since. They are autoreleased, as their deallocation might call
+ * back into the observer.
+ */
+static void
+removeStaleObjects(OFEpollKernelEventObserver *self,
+    struct OFEpollFDState *state, int fd)
+{
+	if (state->readObject != nil &&
+	    [state->readObject fileDescriptorForReading] != fd) {
+		[self of_stopObservingReadBufferOfObject: state->readObject];
+		objc_autorelease(state->readObject);
+		state->readObject = nil;
+	}
 
-	if (events == 0) {
-		if (epoll_ctl(_epfd, EPOLL_CTL_DEL, fd, NULL) == -1)
+	if (state->writeObject != nil &&
+	    [state->writeObject fileDescriptorForWriting] != fd) {
+		objc_autorelease(state->writeObject);
+		state->writeObject = nil;
+	}
+}
+
+/* Registers the descriptor for the events its objects need with epoll. */
+static void
+updateEvents(OFEpollKernelEventObserver *self, struct OFEpollFDState *state,
+    int fd)
+{
+	unsigned char oldEvents = state->events & ~exclusiveFlag;
+	unsigned char newEvents = (state->readObject != nil ? EPOLLIN : 0) |
+	    (state->writeObject != nil ? EPOLLOUT : 0);
+	struct epoll_event event;
+	int op;
+
+	/* Skip the syscall if the fd is already observed for these events. */
+	if (newEvents == oldEvents)
+		return;
+
+	if (newEvents == 0) {
+		if (epoll_ctl(self->_epfd, EPOLL_CTL_DEL, fd, NULL) == -1)
 			/*
 			 * When an async connect fails, it seems the socket is
 			 * automatically removed from epoll, meaning ENOENT is
@@ -137,21 +222,119 @@ static const OFMapTableFunctions mapFunctions = { NULL };
 				    exceptionWithObserver: self
 						    errNo: errno];
 
-		[_FDToEvents removeObjectForKey: (void *)((intptr_t)fd + 1)];
-	} else {
-		struct epoll_event event;
+		state->events = 0;
+		return;
+	}
 
-		memset(&event, 0, sizeof(event));
-		event.events = (int)events;
-		event.data.ptr = object;
+	memset(&event, 0, sizeof(event));
+	event.events = newEvents | (self->_edgeTriggered ? EPOLLET : 0);
+	/* Looked up again when an event arrives, as the objects can change. */
+	event.data.fd = fd;
+
+	if (oldEvents == 0) {
+		op = EPOLL_CTL_ADD;
+
+#ifdef EPOLLEXCLUSIVE
+		/*
+		 * Listening sockets might be shared between multiple threads
+		 * with their own observer, in which case only one of them
+		 * should be woken up for a new connection.
+		 */
+		if (newEvents == EPOLLIN && isListening(state->readObject)) {
+			event.events |= EPOLLEXCLUSIVE;
+			newEvents |= exclusiveFlag;
+		}
+#endif
+	} else if (state->events & exclusiveFlag) {
+		/* EPOLLEXCLUSIVE cannot be modified, so delete and re-add. */
+		if (epoll_ctl(self->_epfd, EPOLL_CTL_DEL, fd, NULL) == -1 &&
+		    errno != ENOENT)
+			@throw [OFObserveKernelEventsFailedException
+			    exceptionWithObserver: self
+					    errNo: errno];
 
-		if (epoll_ctl(_epfd, EPOLL_CTL_MOD, fd, &event) == -1)
+		op = EPOLL_CTL_ADD;
+	} else
+		op = EPOLL_CTL_MOD;
+
+	if (epoll_ctl(self->_epfd, op, fd, &event) == -1) {
+		/*
+		 * If the fd was closed without being removed first, epoll
+		 * dropped it and our cached state is stale.
+		 */
+		if (op != EPOLL_CTL_MOD || errno != ENOENT ||
+		    epoll_ctl(self->_epfd, EPOLL_CTL_ADD, fd, &event) == -1)
 			@throw [OFObserveKernelEventsFailedException
 			    exceptionWithObserver: self
 					    errNo: errno];
+	}
+
+	state->events = newEvents;
+}
 
-		[_FDToEvents setObject: (void *)events
-				forKey: (void *)((intptr_t)fd + 1)];
+- (void)of_addObject: (id)object
+      fileDescriptor: (int)fd
+	      events: (int)events OF_DIRECT
+{
+	struct OFEpollFDState *state = stateForFD(self, fd, true);
+	id *objectPtr = (events == EPOLLIN
+	    ? &state->readObject : &state->writeObject);
+	id oldObject;
+
+	removeStaleObjects(self, state, fd);
+
+	oldObject = *objectPtr;
+	*objectPtr = object;
+
+	@try {
+		updateEvents(self, state, fd);
+	} @catch (id e) {
+		*objectPtr = oldObject;
+		@throw e;
+	}
+
+	if (oldObject == object)
+		return;
+
+	objc_retain(object);
+
+	if (events == EPOLLIN) {
+		if (oldObject != nil)
+			[self of_stopObservingReadBufferOfObject: oldObject];
+
+		[self of_observeReadBufferOfObject: object];
+	}
+
+	objc_release(oldObject);
+}
+
+- (void)of_removeObject: (id)object
+	 fileDescriptor: (int)fd
+		 events: (int)events OF_DIRECT
+{
+	struct OFEpollFDState *state = stateForFD(self, fd, false);
+	id *objectPtr;
+
+	if (state == NULL)
+		return;
+
+	removeStaleObjects(self, state, fd);
+
+	objectPtr = (events == EPOLLIN
+	    ? &state->readObject : &state->writeObject);
+
+	if (*objectPtr == object) {
+		if (events == EPOLLIN)
+			[self of_stopObservingReadBufferOfObject: object];
+
+		*objectPtr = nil;
+	} else
+		object = nil;
+
+	@try {
+		updateEvents(self, state, fd);
+	} @finally {
+		objc_release(object);
 	}
 }
 
@@ -160,8 +343,6 @@ static const OFMapTableFunctions mapFunctions = { NULL };
 	[self of_addObject: object
 	    fileDescriptor: object.fileDescriptorForReading
 		    events: EPOLLIN];
-
-	[super addObjectForReading: object];
 }
 
 - (void)addObjectForWriting: (id <OFReadyForWritingObserving>)object
@@ -169,8 +350,6 @@ static const OFMapTableFunctions mapFunctions = { NULL };
 	[self of_addObject: object
 	    fileDescriptor: object.fileDescriptorForWriting
 		    events: EPOLLOUT];
-
-	[super addObjectForWriting: object];
 }
 
 - (void)removeObjectForReading: (id <OFReadyForReadingObserving>)object
@@ -178,8 +357,6 @@ static const OFMapTableFunctions mapFunctions = { NULL };
 	[self of_removeObject: object
 	       fileDescriptor: object.fileDescriptorForReading
 		       events: EPOLLIN];
-
-	[super removeObjectForReading: object];
 }
 
 - (void)removeObjectForWriting: (id <OFReadyForWritingObserving>)object
@@ -187,20 +364,50 @@ static const OFMapTableFunctions mapFunctions = { NULL };
 	[self of_removeObject: object
 	       fileDescriptor: object.fileDescriptorForWriting
 		       events: EPOLLOUT];
+}
+
+static void
+notify(OFEpollKernelEventObserver *self, int fd, bool forReading)
+{
+	struct OFEpollFDState *state;
+	void *pool;
+	id object;
+
+	/* The delegate might have removed the object in the meantime. */
+	if ((size_t)fd >= self->_FDStatesCount)
+		return;
 
-	[super removeObjectForWriting: object];
+	state = &self->_FDStates[fd];
+	if ((object = (forReading
+	    ? state->readObject : state->writeObject)) == nil)
+		return;
+
+	pool = objc_autoreleasePoolPush();
+
+	/* The delegate might remove the object, which releases it. */
+	objc_retainAutorelease(object);
+
+	if (forReading) {
+		if ([self->_delegate respondsToSelector:
+		    @selector(objectIsReadyForReading:)])
+			[self->_delegate objectIsReadyForReading: object];
+	} else {
+		if ([self->_delegate respondsToSelector:
+		    @selector(objectIsReadyForWriting:)])
+			[self->_delegate objectIsReadyForWriting: object];
+	}
+
+	objc_autoreleasePoolPop(pool);
 }
 
 - (void)observeForTimeInterval: (OFTimeInterval)timeInterval
 {
-	OFNull *nullObject = [OFNull null];
-	struct epoll_event eventList[eventListSize];
 	int events;
 
 	if ([self processReadBuffers])
 		return;
 
-	while ((events = epoll_wait(_epfd, eventList, eventListSize,
+	while ((events = epoll_wait(_epfd, _eventList, _eventListSize,
 	    (timeInterval != -1 ? timeInterval * 1000 : -1))) < 0)
 		if (errno != EINTR)
 			@throw [OFObserveKernelEventsFailedException
@@ -208,35 +415,40 @@ static const OFMapTableFunctions mapFunctions = { NULL };
 					    errNo: errno];
 
 	for (int i = 0; i < events; i++) {
-		if (eventList[i].events & EPOLLIN) {
-			void *pool;
-
-			if (eventList[i].data.ptr == nullObject) {
-				char buffer;
-				OFEnsure(read(_cancelFD[0], &buffer, 1) == 1);
-				continue;
-			}
-
-			pool = objc_autoreleasePoolPush();
+		int fd = _eventList[i].data.fd;
 
-			if ([_delegate respondsToSelector:
-			    @selector(objectIsReadyForReading:)])
-				[_delegate objectIsReadyForReading:
-				    eventList[i].data.ptr];
-
-			objc_autoreleasePoolPop(pool);
+		if (fd == _cancelFD[0]) {
+			char buffer;
+			OFEnsure(read(_cancelFD[0], &buffer, 1) == 1);
+			continue;
 		}
 
-		if (eventList[i].events & EPOLLOUT) {
-			void *pool = objc_autoreleasePoolPush();
+		if (_eventList[i].events & EPOLLIN)
+			notify(self, fd, true);
 
-			if ([_delegate respondsToSelector:
-			    @selector(objectIsReadyForWriting:)])
-				[_delegate objectIsReadyForWriting:
-				    eventList[i].data.ptr];
+		if (_eventList[i].events & EPOLLOUT)
+			notify(self, fd, false);
+	}
 
-			objc_autoreleasePoolPop(pool);
+	/*
+	 * If the event list was filled completely, there are likely more
+	 * events pending, so allow fetching more of them with the next call.
+	 * Shrink it again once it is mostly unused.
+	 */
+	@try {
+		if (events == _eventListSize &&
+		    _eventListSize < maxEventListSize) {
+			_eventList = OFResizeMemory(_eventList,
+			    _eventListSize * 2, sizeof(*_eventList));
+			_eventListSize *= 2;
+		} else if (events < _eventListSize / 8 &&
+		    _eventListSize > minEventListSize) {
+			_eventList = OFResizeMemory(_eventList,
+			    _eventListSize / 2, sizeof(*_eventList));
+			_eventListSize /= 2;
 		}
+	} @catch (OFOutOfMemoryException *e) {
+		/* We don't care, the old event list is still usable */
 	}
 }
 @end
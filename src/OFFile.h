@@ -31,10 +31,19 @@ static const OFFileHandle OFInvalidFileHandle = NULL;
 
 OF_ASSUME_NONNULL_BEGIN
 
+@class OFAsyncFileIO;
+
 /**
  * @class OFFile OFFile.h ObjFW/ObjFW.h
  *
  * @brief A class which provides methods to read and write files.
+ *
+ * When a regular file is used with the asynchronous methods of @ref OFStream,
+ * the reads and writes are performed in the background where supported, so
+ * that they do not block the run loop. While asynchronous requests are
+ * pending, the file should not be read from or written to synchronously: If a
+ * background operation is in progress, a synchronous read or write fails with
+ * an @ref OFReadFailedException or @ref OFWriteFailedException with `EAGAIN`.
  */
 OF_SUBCLASSING_RESTRICTED
 @interface OFFile: OFSeekableStream
@@ -44,6 +53,9 @@ OF_SUBCLASSING_RESTRICTED
 {
 	OFFileHandle _handle;
 	bool _initialized, _atEndOfStream;
+#ifdef OF_FILE_HANDLE_IS_FD
+	OFAsyncFileIO *_Nullable _asyncIO;
+#endif
 }
 
 /**
@@ -33,8 +33,12 @@
 #ifdef HAVE_SYS_STAT_H
 # include <sys/stat.h>
 #endif
+#ifdef HAVE_SYS_UIO_H
+# include <sys/uio.h>
+#endif
 
 #import "OFFile.h"
+#import "OFFile+Private.h"
 #import "OFLocale.h"
 #import "OFString.h"
 #import "OFSystemInfo.h"
@@ -420,6 +424,21 @@ ioErrToErrNo()
 	if (_handle == OFInvalidFileHandle)
 		@throw [OFNotOpenException exceptionWithObject: self];
 
+#ifdef OF_HAVE_ASYNC_FILE_IO
+	if (_asyncIO != nil) {
+		size_t bytesRead;
+
+		if ([_asyncIO readIntoBuffer: buffer
+				      length: length
+				   bytesRead: &bytesRead]) {
+			if (bytesRead == 0)
+				_atEndOfStream = true;
+
+			return bytesRead;
+		}
+	}
+#endif
+
 #if defined(OF_WINDOWS)
 	if (length > UINT_MAX)
 		@throw [OFOutOfRangeException exception];
@@ -454,6 +473,17 @@ ioErrToErrNo()
 	if (_handle == OFInvalidFileHandle)
 		@throw [OFNotOpenException exceptionWithObject: self];
 
+#ifdef OF_HAVE_ASYNC_FILE_IO
+	if (_asyncIO != nil) {
+		size_t bytesWritten;
+
+		if ([_asyncIO writeBuffer: buffer
+				   length: length
+			     bytesWritten: &bytesWritten])
+			return bytesWritten;
+	}
+#endif
+
 #if defined(OF_WINDOWS)
 	int bytesWritten;
 
@@ -507,6 +537,111 @@ ioErrToErrNo()
 	return (size_t)bytesWritten;
 }
 
+#if defined(HAVE_WRITEV) && !defined(OF_WINDOWS) && !defined(OF_AMIGAOS)
+- (size_t)lowlevelWriteBuffers: (const OFStreamBuffer *)buffers
+			 count: (size_t)count
+{
+	struct iovec iov[16];
+	size_t length = 0;
+	ssize_t bytesWritten;
+
+	if (_handle == OFInvalidFileHandle)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+# ifdef OF_HAVE_ASYNC_FILE_IO
+	/* Background writes are done one buffer at a time. */
+	if (_asyncIO != nil && count > 0)
+		return [self lowlevelWriteBuffer: buffers[0].buffer
+					  length: buffers[0].length];
+# endif
+
+	/* Any further buffers are left for the caller as a short write. */
+	if (count > sizeof(iov) / sizeof(*iov))
+		count = sizeof(iov) / sizeof(*iov);
+
+	for (size_t i = 0; i < count; i++) {
+		if (buffers[i].length > SSIZE_MAX - length)
+			@throw [OFOutOfRangeException exception];
+
+		iov[i].iov_base = (void *)buffers[i].buffer;
+		iov[i].iov_len = buffers[i].length;
+		length += buffers[i].length;
+	}
+
+	if ((bytesWritten = writev(_handle, iov, (int)count)) < 0)
+		@throw [OFWriteFailedException
+		    exceptionWithObject: self
+			requestedLength: length
+			   bytesWritten: 0
+				  errNo: errno];
+
+	return (size_t)bytesWritten;
+}
+#endif
+
+#if defined(HAVE_PREAD) && !defined(OF_WINDOWS) && !defined(OF_AMIGAOS)
+- (size_t)lowlevelReadIntoBuffer: (void *)buffer
+			  length: (size_t)length
+			atOffset: (OFStreamOffset)offset
+{
+	ssize_t ret;
+
+	if (_handle == OFInvalidFileHandle)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	if (length > SSIZE_MAX)
+		@throw [OFOutOfRangeException exception];
+
+# ifdef OF_HAVE_ASYNC_FILE_IO
+	/* Keep the order with a background read or write in progress. */
+	[_asyncIO finishOperation];
+# endif
+
+# ifdef HAVE_PREAD64
+	if ((ret = pread64(_handle, buffer, length, offset)) < 0)
+# else
+	if ((ret = pread(_handle, buffer, length, offset)) < 0)
+# endif
+		@throw [OFReadFailedException exceptionWithObject: self
+						  requestedLength: length
+							    errNo: errno];
+
+	return ret;
+}
+#endif
+
+#if defined(HAVE_PWRITE) && !defined(OF_WINDOWS) && !defined(OF_AMIGAOS)
+- (size_t)lowlevelWriteBuffer: (const void *)buffer
+		       length: (size_t)length
+		     atOffset: (OFStreamOffset)offset
+{
+	ssize_t bytesWritten;
+
+	if (_handle == OFInvalidFileHandle)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	if (length > SSIZE_MAX)
+		@throw [OFOutOfRangeException exception];
+
+# ifdef OF_HAVE_ASYNC_FILE_IO
+	/* Keep the order with a background read or write in progress. */
+	[_asyncIO finishOperation];
+# endif
+
+# ifdef HAVE_PWRITE64
+	if ((bytesWritten = pwrite64(_handle, buffer, length, offset)) < 0)
+# else
+	if ((bytesWritten = pwrite(_handle, buffer, length, offset)) < 0)
+# endif
+		@throw [OFWriteFailedException exceptionWithObject: self
+						   requestedLength: length
+						      bytesWritten: 0
+							     errNo: errno];
+
+	return (size_t)bytesWritten;
+}
+#endif
+
 - (OFStreamOffset)lowlevelSeekToOffset: (OFStreamOffset)offset
 				whence: (OFSeekWhence)whence
 {
@@ -515,6 +650,10 @@ ioErrToErrNo()
 	if (_handle == OFInvalidFileHandle)
 		@throw [OFNotOpenException exceptionWithObject: self];
 
+#ifdef OF_HAVE_ASYNC_FILE_IO
+	[_asyncIO finishOperation];
+#endif
+
 #ifndef OF_AMIGAOS
 	int translatedWhence;
 
@@ -598,11 +737,47 @@ ioErrToErrNo()
 }
 #endif
 
+- (void)of_setAtEndOfStream
+{
+	_atEndOfStream = true;
+}
+
+#ifdef OF_HAVE_ASYNC_FILE_IO
+- (void)of_finishAsyncOperation
+{
+	[_asyncIO finishOperation];
+}
+
+- (OFAsyncFileIO *)of_asyncIO
+{
+	struct stat st;
+
+	if (_asyncIO != nil || _handle == OFInvalidFileHandle)
+		return _asyncIO;
+
+	/*
+	 * Only regular files are always ready and need reads and writes in the
+	 * background. Everything else can be observed directly.
+	 */
+	if (fstat(_handle, &st) != 0 || !S_ISREG(st.st_mode))
+		return nil;
+
+	_asyncIO = [[OFAsyncFileIO alloc] initWithFile: self
+					fileDescriptor: _handle];
+
+	return _asyncIO;
+}
+#endif
+
 - (void)close
 {
 	if (_handle == OFInvalidFileHandle)
 		@throw [OFNotOpenException exceptionWithObject: self];
 
+#ifdef OF_HAVE_ASYNC_FILE_IO
+	[_asyncIO finishOperation];
+#endif
+
 	closeHandle(_handle);
 	_handle = OFInvalidFileHandle;
 
@@ -614,6 +789,13 @@ ioErrToErrNo()
 	if (_initialized && _handle != OFInvalidFileHandle)
 		[self close];
 
+#ifdef OF_HAVE_ASYNC_FILE_IO
+	if (_asyncIO != nil) {
+		_asyncIO->_file = nil;
+		objc_release(_asyncIO);
+	}
+#endif
+
 	[super dealloc];
 }
 @end
@@ -53,6 +53,15 @@
 #ifdef HAVE_FCNTL_H
 # include <fcntl.h>
 #endif
+#ifdef OF_LINUX
+# include <sys/ioctl.h>
+# ifdef HAVE_LINUX_FS_H
+#  include <linux/fs.h>
+# endif
+# ifdef HAVE_SYS_SENDFILE_H
+#  include <sys/sendfile.h>
+# endif
+#endif
 #ifdef HAVE_PWD_H
 # include <pwd.h>
 #endif
@@ -64,6 +73,7 @@
 #import "OFArray.h"
 #import "OFData.h"
 #import "OFDate.h"
+#import "OFDirectoryEnumerator.h"
 #import "OFFile.h"
 #import "OFFileManager.h"
 #import "OFIRI.h"
@@ -73,8 +83,12 @@
 
 #ifdef OF_HAVE_THREADS
 # import "OFMutex.h"
+# import "OFPlainCondition.h"
+# import "OFPlainMutex.h"
+# import "OFPlainThread.h"
 #endif
 
+#import "OFCopyItemFailedException.h"
 #import "OFCreateDirectoryFailedException.h"
 #import "OFCreateSymbolicLinkFailedException.h"
 #import "OFGetItemAttributesFailedException.h"
@@ -84,6 +98,7 @@
 #import "OFMoveItemFailedException.h"
 #import "OFNotImplementedException.h"
 #import "OFOpenItemFailedException.h"
+#import "OFOutOfMemoryException.h"
 #import "OFOutOfRangeException.h"
 #import "OFReadFailedException.h"
 #import "OFRemoveItemFailedException.h"
@@ -953,6 +968,1120 @@ setExtendedAttributes(OFMutableFileAttributes attributes, OFIRI *IRI)
 }
 #endif
 
+#ifdef OF_LINUX
+typedef enum {
+	CopyMethodCopyFileRange,
+	CopyMethodSendFile,
+	CopyMethodReadWrite
+} CopyMethod;
+
+/*
+ * Copies a range of the source file to the same offset in the destination
+ * file. If the kernel does not support the method for the files, the next
+ * slower one is used, and also remembered for the following ranges.
+ */
+static int
+copyFileRange(int inFD, int outFD, off_t offset, off_t length,
+    CopyMethod *method)
+{
+	while (length > 0) {
+		size_t chunkLength = (length > 0x40000000
+		    ? 0x40000000 : (size_t)length);
+		ssize_t ret;
+
+		if (*method == CopyMethodCopyFileRange) {
+# ifdef HAVE_COPY_FILE_RANGE
+			off_t inOffset = offset, outOffset = offset;
+
+			ret = copy_file_range(inFD, &inOffset,
+			    outFD, &outOffset, chunkLength, 0);
+# else
+			errno = ENOSYS;
+			ret = -1;
+# endif
+		} else if (*method == CopyMethodSendFile) {
+# ifdef HAVE_SENDFILE
+			off_t inOffset = offset;
+
+			if (lseek(outFD, offset, SEEK_SET) == -1)
+				return errno;
+
+			ret = sendfile(outFD, inFD, &inOffset, chunkLength);
+# else
+			errno = ENOSYS;
+			ret = -1;
+# endif
+		} else {
+			char buffer[16384];
+
+			if (chunkLength > sizeof(buffer))
+				chunkLength = sizeof(buffer);
+
+			if ((ret = pread(inFD, buffer, chunkLength,
+			    offset)) > 0) {
+				for (ssize_t i = 0; i < ret;) {
+					ssize_t written = pwrite(outFD,
+					    buffer + i, ret - i, offset + i);
+
+					if (written < 0) {
+						if (errno == EINTR)
+							continue;
+
+						return errno;
+					}
+
+					i += written;
+				}
+			}
+		}
+
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+
+			if (*method != CopyMethodReadWrite &&
+			    (errno == EINVAL || errno == ENOSYS ||
+			    errno == EXDEV || errno == EOPNOTSUPP)) {
+				(*method)++;
+				continue;
+			}
+
+			return errno;
+		}
+
+		/* The source file has been truncated in the meantime. */
+		if (ret == 0)
+			break;
+
+		offset += ret;
+		length -= ret;
+	}
+
+	return 0;
+}
+
+/*
+ * Copies the contents of a regular file, letting the kernel do the work. The
+ * destination shares the extents of the source if the file system supports
+ * reflinks, and holes in sparse files are kept otherwise.
+ */
+static int
+copyFile(int inFD, int outFD, off_t size)
+{
+	CopyMethod method = CopyMethodCopyFileRange;
+	off_t offset = 0;
+	int errNo;
+
+	/*
+	 * Files in pseudo file systems such as procfs report a size of 0 but
+	 * still have contents, so these need to be read until the end.
+	 */
+	if (size == 0) {
+		char buffer[16384];
+		ssize_t ret;
+
+		while ((ret = read(inFD, buffer, sizeof(buffer))) != 0) {
+			if (ret < 0) {
+				if (errno == EINTR)
+					continue;
+
+				return errno;
+			}
+
+			for (ssize_t i = 0; i < ret;) {
+				ssize_t written = write(outFD, buffer + i,
+				    ret - i);
+
+				if (written < 0) {
+					if (errno == EINTR)
+						continue;
+
+					return errno;
+				}
+
+				i += written;
+			}
+		}
+
+		return 0;
+	}
+
+# ifdef FICLONE
+	if (ioctl(outFD, FICLONE, inFD) == 0)
+		return 0;
+# endif
+
+	while (offset < size) {
+		off_t dataEnd = size;
+
+# ifdef SEEK_DATA
+		off_t dataStart = lseek(inFD, offset, SEEK_DATA);
+
+		if (dataStart != -1) {
+			offset = dataStart;
+
+			if ((dataEnd = lseek(inFD, offset, SEEK_HOLE)) == -1 ||
+			    dataEnd > size)
+				dataEnd = size;
+		} else if (errno == ENXIO)
+			/* Only a hole is left. */
+			break;
+# endif
+
+		if ((errNo = copyFileRange(inFD, outFD, offset,
+		    dataEnd - offset, &method)) != 0)
+			return errNo;
+
+		offset = dataEnd;
+	}
+
+	/* Extend the destination in case the source ends with a hole. */
+	if (ftruncate(outFD, size) != 0)
+		return errno;
+
+	return 0;
+}
+#endif
+
+#if defined(HAVE_OPENAT) && defined(HAVE_FSTATAT) && \
+    defined(HAVE_FDOPENDIR) && \
+    (!defined(HAVE_STAT64) || defined(HAVE_FSTATAT64)) && \
+    !defined(OF_WINDOWS) && !defined(OF_AMIGAOS)
+# define USE_FILE_DIRECTORY_ENUMERATOR
+
+# ifdef OF_HAVE_THREADS
+#  define USE_PARALLEL_ENUMERATION
+# endif
+
+# ifndef O_CLOEXEC
+#  define O_CLOEXEC 0
+# endif
+# ifndef O_DIRECTORY
+#  define O_DIRECTORY 0
+# endif
+# ifndef O_NOFOLLOW
+#  define O_NOFOLLOW 0
+# endif
+
+enum {
+	attributeSize			  = 0x01,
+	attributePermissions		  = 0x02,
+	attributeOwner			  = 0x04,
+	attributeDates			  = 0x08,
+	attributeSymbolicLinkDestination = 0x10,
+	attributeExtendedAttributes	  = 0x20
+};
+/* The attributes that cannot be retrieved without a stat. */
+static const unsigned int statAttributes =
+    attributeSize | attributePermissions | attributeOwner | attributeDates;
+
+typedef struct {
+	char *name;
+	/* Only st_mode is set unless attributes that need a stat were asked. */
+	Stat stat;
+} DirectoryEntry;
+
+# ifdef USE_PARALLEL_ENUMERATION
+static const size_t maxParallelThreads = 8;
+/* Workers stop reading more directories once this many entries are queued. */
+static const size_t maxQueuedEntries = 16384;
+
+typedef enum {
+	ParallelErrorOpen,
+	ParallelErrorRead,
+	ParallelErrorStat
+} ParallelError;
+
+typedef struct ParallelDirectory {
+	struct ParallelDirectory *next;
+	/* Relative to the enumerated directory, NULL for itself. */
+	char *path;
+	size_t level;
+	DirectoryEntry *entries;
+	size_t numEntries, consumed;
+} ParallelDirectory;
+
+typedef struct {
+	OFPlainMutex mutex;
+	OFPlainCondition condition;
+	OFPlainThread threads[maxParallelThreads];
+	size_t numThreads, numBusyThreads;
+	int rootFD;
+	unsigned int attributes;
+	ParallelDirectory *firstJob, *lastJob;
+	ParallelDirectory *firstDone, *lastDone;
+	size_t numQueuedEntries;
+	bool cancelled;
+	int errNo;
+	ParallelError error;
+	char *errorPath;
+	/* Only accessed by the consuming thread. */
+	ParallelDirectory *current;
+} ParallelEnumeration;
+# endif
+
+# if defined(HAVE_STATX) && defined(STATX_TYPE)
+static bool statxUnsupported = false;
+# endif
+
+@interface OFFileDirectoryEnumerator: OFDirectoryEnumerator
+{
+	unsigned int _attributes;
+	OFMutableData *_directories;
+	OFMutableArray OF_GENERIC(OFIRI *) *_directoryIRIs;
+# ifdef USE_PARALLEL_ENUMERATION
+	ParallelEnumeration *_parallel;
+	OFIRI *_currentDirectoryIRI;
+# endif
+}
+
+- (void)of_openPendingDirectory;
+# ifdef USE_PARALLEL_ENUMERATION
+- (void)of_startParallelEnumerationAtPath: (const char *)path;
+- (OFIRI *)of_nextParallelObject;
+- (void)of_throwParallelError OF_NO_RETURN;
+# endif
+@end
+
+# ifdef HAVE_STRUCT_DIRENT_D_TYPE
+static mode_t
+modeForDirentType(unsigned char type)
+{
+	switch (type) {
+	case DT_REG:
+		return S_IFREG;
+	case DT_DIR:
+		return S_IFDIR;
+	case DT_LNK:
+		return S_IFLNK;
+	case DT_FIFO:
+		return S_IFIFO;
+	case DT_CHR:
+		return S_IFCHR;
+	case DT_BLK:
+		return S_IFBLK;
+	case DT_SOCK:
+		return S_IFSOCK;
+	default:
+		return 0;
+	}
+}
+# endif
+
+# if defined(HAVE_STATX) && defined(STATX_TYPE)
+static void
+statxToStat(const struct statx *stx, Stat *s)
+{
+	s->st_mode = stx->stx_mode;
+	s->st_size = stx->stx_size;
+	s->st_uid = stx->stx_uid;
+	s->st_gid = stx->stx_gid;
+#  ifdef HAVE_STRUCT_STAT_ST_ATIM
+	s->st_atim.tv_sec = stx->stx_atime.tv_sec;
+	s->st_atim.tv_nsec = stx->stx_atime.tv_nsec;
+#  else
+	s->st_atime = stx->stx_atime.tv_sec;
+#  endif
+#  ifdef HAVE_STRUCT_STAT_ST_MTIM
+	s->st_mtim.tv_sec = stx->stx_mtime.tv_sec;
+	s->st_mtim.tv_nsec = stx->stx_mtime.tv_nsec;
+#  else
+	s->st_mtime = stx->stx_mtime.tv_sec;
+#  endif
+#  ifdef HAVE_STRUCT_STAT_ST_CTIM
+	s->st_ctim.tv_sec = stx->stx_ctime.tv_sec;
+	s->st_ctim.tv_nsec = stx->stx_ctime.tv_nsec;
+#  else
+	s->st_ctime = stx->stx_ctime.tv_sec;
+#  endif
+}
+# endif
+
+/*
+ * Retrieves the type of a directory entry as well as the requested attributes.
+ * If the type is known from the directory and no other attributes are needed,
+ * this does not need a system call.
+ */
+static int
+statDirectoryEntry(int dirFD, const struct dirent *dirent,
+    unsigned int attributes, Stat *s)
+{
+	memset(s, 0, sizeof(*s));
+
+# ifdef HAVE_STRUCT_DIRENT_D_TYPE
+	if (!(attributes & statAttributes) &&
+	    (s->st_mode = modeForDirentType(dirent->d_type)) != 0)
+		return 0;
+# endif
+
+# if defined(HAVE_STATX) && defined(STATX_TYPE)
+	if (!statxUnsupported) {
+		unsigned int mask = STATX_TYPE;
+		struct statx stx;
+
+		if (attributes & attributeSize)
+			mask |= STATX_SIZE;
+		if (attributes & attributePermissions)
+			mask |= STATX_MODE;
+		if (attributes & attributeOwner)
+			mask |= STATX_UID | STATX_GID;
+		if (attributes & attributeDates)
+			mask |= STATX_ATIME | STATX_MTIME | STATX_CTIME;
+
+		if (statx(dirFD, dirent->d_name, AT_SYMLINK_NOFOLLOW, mask,
+		    &stx) == 0) {
+			statxToStat(&stx, s);
+			return 0;
+		}
+
+		if (errno != ENOSYS)
+			return errno;
+
+		statxUnsupported = true;
+	}
+# endif
+
+# ifdef HAVE_STAT64
+	if (fstatat64(dirFD, dirent->d_name, s, AT_SYMLINK_NOFOLLOW) != 0)
+		return errno;
+# else
+	if (fstatat(dirFD, dirent->d_name, s, AT_SYMLINK_NOFOLLOW) != 0)
+		return errno;
+# endif
+
+	return 0;
+}
+
+static OFFileAttributes
+attributesOfDirectoryEntry(Stat *s, OFIRI *IRI, unsigned int attributes)
+{
+	OFMutableFileAttributes ret = [OFMutableDictionary dictionary];
+
+	setTypeAttribute(ret, s);
+
+	if (attributes & attributeSize) {
+		if (s->st_size < 0)
+			@throw [OFOutOfRangeException exception];
+
+		[ret setObject: [OFNumber
+				    numberWithUnsignedLongLong: s->st_size]
+			forKey: OFFileSize];
+	}
+
+	if (attributes & attributePermissions)
+		[ret setObject: [OFNumber numberWithUnsignedLong: s->st_mode]
+			forKey: OFFilePOSIXPermissions];
+
+	if (attributes & attributeOwner)
+		setOwnerAndGroupAttributes(ret, s);
+
+	if (attributes & attributeDates)
+		setDateAttributes(ret, s);
+
+# ifdef OF_FILE_MANAGER_SUPPORTS_SYMLINKS
+	if ((attributes & attributeSymbolicLinkDestination) &&
+	    S_ISLNK(s->st_mode))
+		setSymbolicLinkDestinationAttribute(ret, IRI);
+# endif
+
+# ifdef OF_FILE_MANAGER_SUPPORTS_EXTENDED_ATTRIBUTES
+	if (attributes & attributeExtendedAttributes)
+		setExtendedAttributes(ret, IRI);
+# endif
+
+	[ret makeImmutable];
+
+	return ret;
+}
+
+# ifdef USE_PARALLEL_ENUMERATION
+static void
+freeParallelDirectory(ParallelDirectory *directory)
+{
+	for (size_t i = 0; i < directory->numEntries; i++)
+		free(directory->entries[i].name);
+
+	free(directory->entries);
+	free(directory->path);
+	free(directory);
+}
+
+static char *
+joinPath(const char *path, const char *name)
+{
+	size_t pathLength, nameLength = strlen(name);
+	char *ret;
+
+	if (path == NULL)
+		return strdup(name);
+
+	pathLength = strlen(path);
+
+	if ((ret = malloc(pathLength + 1 + nameLength + 1)) == NULL)
+		return NULL;
+
+	memcpy(ret, path, pathLength);
+	ret[pathLength] = '/';
+	memcpy(ret + pathLength + 1, name, nameLength + 1);
+
+	return ret;
+}
+
+/*
+ * Reads all entries of the directory of the job and creates jobs for its
+ * subdirectories. As this runs on a worker thread, it must not throw.
+ */
+static int
+readParallelDirectory(ParallelEnumeration *parallel,
+    ParallelDirectory *directory, ParallelDirectory **firstSubdirectory,
+    ParallelDirectory **lastSubdirectory, ParallelError *error,
+    char **errorPath)
+{
+	size_t capacity = 0;
+	int fd, errNo = 0;
+	DIR *dir;
+
+	if ((fd = openat(parallel->rootFD,
+	    (directory->path != NULL ? directory->path : "."),
+	    O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC)) == -1) {
+		*error = ParallelErrorOpen;
+		return errno;
+	}
+
+	if ((dir = fdopendir(fd)) == NULL) {
+		errNo = errno;
+		close(fd);
+		*error = ParallelErrorOpen;
+		return errNo;
+	}
+
+	for (;;) {
+		struct dirent *dirent;
+		DirectoryEntry *entry;
+		ParallelDirectory *subdirectory;
+
+#  if !defined(__GLIBC__)
+		[readdirMutex lock];
+#  endif
+		errno = 0;
+		dirent = readdir(dir);
+		errNo = errno;
+#  if !defined(__GLIBC__)
+		[readdirMutex unlock];
+#  endif
+
+		if (dirent == NULL) {
+			if (errNo != 0)
+				*error = ParallelErrorRead;
+
+			break;
+		}
+
+		if (strcmp(dirent->d_name, ".") == 0 ||
+		    strcmp(dirent->d_name, "..") == 0)
+			continue;
+
+		if (directory->numEntries == capacity) {
+			size_t newCapacity = (capacity > 0 ? capacity * 2 : 64);
+			DirectoryEntry *newEntries = realloc(directory->entries,
+			    newCapacity * sizeof(*newEntries));
+
+			if (newEntries == NULL) {
+				errNo = ENOMEM;
+				*error = ParallelErrorRead;
+				break;
+			}
+
+			directory->entries = newEntries;
+			capacity = newCapacity;
+		}
+
+		entry = &directory->entries[directory->numEntries];
+
+		if ((errNo = statDirectoryEntry(dirfd(dir), dirent,
+		    parallel->attributes, &entry->stat)) != 0) {
+			/* It has been removed since reading the directory. */
+			if (errNo == ENOENT) {
+				errNo = 0;
+				continue;
+			}
+
+			*error = ParallelErrorStat;
+			*errorPath = joinPath(directory->path, dirent->d_name);
+			break;
+		}
+
+		if ((entry->name = strdup(dirent->d_name)) == NULL) {
+			errNo = ENOMEM;
+			*error = ParallelErrorRead;
+			break;
+		}
+
+		directory->numEntries++;
+
+		if (!S_ISDIR(entry->stat.st_mode))
+			continue;
+
+		if ((subdirectory = calloc(1, sizeof(*subdirectory))) == NULL ||
+		    (subdirectory->path = joinPath(directory->path,
+		    dirent->d_name)) == NULL) {
+			free(subdirectory);
+			errNo = ENOMEM;
+			*error = ParallelErrorRead;
+			break;
+		}
+
+		subdirectory->level = directory->level + 1;
+
+		if (*lastSubdirectory != NULL)
+			(*lastSubdirectory)->next = subdirectory;
+		else
+			*firstSubdirectory = subdirectory;
+
+		*lastSubdirectory = subdirectory;
+	}
+
+	closedir(dir);
+
+	return errNo;
+}
+# endif
+
+@implementation OFFileDirectoryEnumerator
+# ifdef USE_PARALLEL_ENUMERATION
+static void
+parallelWorkerMain(id object)
+{
+	ParallelEnumeration *parallel =
+	    ((OFFileDirectoryEnumerator *)object)->_parallel;
+
+	OFEnsure(OFPlainMutexLock(&parallel->mutex) == 0);
+
+	for (;;) {
+		ParallelDirectory *directory;
+		ParallelDirectory *firstSubdirectory = NULL;
+		ParallelDirectory *lastSubdirectory = NULL;
+		ParallelError error = ParallelErrorRead;
+		char *errorPath = NULL;
+		int errNo;
+
+		while (!parallel->cancelled && parallel->errNo == 0 &&
+		    (parallel->firstJob == NULL ||
+		    parallel->numQueuedEntries >= maxQueuedEntries)) {
+			/* Nothing is left to do if no one can add more jobs. */
+			if (parallel->firstJob == NULL &&
+			    parallel->numBusyThreads == 0)
+				break;
+
+			OFEnsure(OFPlainConditionWait(&parallel->condition,
+			    &parallel->mutex) == 0);
+		}
+
+		if (parallel->cancelled || parallel->errNo != 0 ||
+		    parallel->firstJob == NULL)
+			break;
+
+		directory = parallel->firstJob;
+		if ((parallel->firstJob = directory->next) == NULL)
+			parallel->lastJob = NULL;
+		directory->next = NULL;
+		parallel->numBusyThreads++;
+
+		OFEnsure(OFPlainMutexUnlock(&parallel->mutex) == 0);
+		errNo = readParallelDirectory(parallel, directory,
+		    &firstSubdirectory, &lastSubdirectory, &error, &errorPath);
+		OFEnsure(OFPlainMutexLock(&parallel->mutex) == 0);
+
+		parallel->numBusyThreads--;
+
+		if (errNo != 0) {
+			if (parallel->errNo == 0) {
+				parallel->errNo = errNo;
+				parallel->error = error;
+
+				if (errorPath != NULL)
+					parallel->errorPath = errorPath;
+				else {
+					parallel->errorPath = directory->path;
+					directory->path = NULL;
+				}
+			} else
+				free(errorPath);
+
+			freeParallelDirectory(directory);
+
+			while (firstSubdirectory != NULL) {
+				ParallelDirectory *next =
+				    firstSubdirectory->next;
+				freeParallelDirectory(firstSubdirectory);
+				firstSubdirectory = next;
+			}
+		} else {
+			/*
+			 * The directory needs to be queued before its
+			 * subdirectories can be read, so that it is returned
+			 * before its contents.
+			 */
+			if (parallel->lastDone != NULL)
+				parallel->lastDone->next = directory;
+			else
+				parallel->firstDone = directory;
+			parallel->lastDone = directory;
+			parallel->numQueuedEntries += directory->numEntries;
+
+			if (firstSubdirectory != NULL) {
+				if (parallel->lastJob != NULL)
+					parallel->lastJob->next =
+					    firstSubdirectory;
+				else
+					parallel->firstJob = firstSubdirectory;
+				parallel->lastJob = lastSubdirectory;
+			}
+		}
+
+		OFEnsure(OFPlainConditionBroadcast(&parallel->condition) == 0);
+	}
+
+	OFEnsure(OFPlainConditionBroadcast(&parallel->condition) == 0);
+	OFEnsure(OFPlainMutexUnlock(&parallel->mutex) == 0);
+}
+# endif
+
+- (instancetype)
+    initWithIRI: (OFIRI *)IRI
+	options: (OFDirectoryEnumeratorOptions)options
+  attributeKeys: (OFArray OF_GENERIC(OFFileAttributeKey) *)attributeKeys
+{
+	self = [super initWithIRI: IRI
+			  options: options
+		    attributeKeys: attributeKeys];
+
+	@try {
+		void *pool = objc_autoreleasePoolPush();
+		const char *path = [IRI.fileSystemRepresentation
+		    cStringWithEncoding: [OFLocale encoding]];
+
+		for (OFFileAttributeKey key in attributeKeys) {
+			if ([key isEqual: OFFileSize])
+				_attributes |= attributeSize;
+			else if ([key isEqual: OFFilePOSIXPermissions])
+				_attributes |= attributePermissions;
+			else if ([key isEqual: OFFileOwnerAccountID] ||
+			    [key isEqual: OFFileGroupOwnerAccountID] ||
+			    [key isEqual: OFFileOwnerAccountName] ||
+			    [key isEqual: OFFileGroupOwnerAccountName])
+				_attributes |= attributeOwner;
+			else if ([key isEqual: OFFileLastAccessDate] ||
+			    [key isEqual: OFFileModificationDate] ||
+			    [key isEqual: OFFileStatusChangeDate] ||
+			    [key isEqual: OFFileCreationDate])
+				_attributes |= attributeDates;
+			else if ([key isEqual: OFFileSymbolicLinkDestination])
+				_attributes |= attributeSymbolicLinkDestination;
+			else if ([key isEqual: OFFileExtendedAttributesNames])
+				_attributes |= attributeExtendedAttributes;
+		}
+
+# ifdef USE_PARALLEL_ENUMERATION
+		if ((options & OFDirectoryEnumeratorOptionRecursive) &&
+		    (options & OFDirectoryEnumeratorOptionParallel))
+			[self of_startParallelEnumerationAtPath: path];
+		else
+# endif
+		{
+			DIR *dir;
+
+			if ((dir = opendir(path)) == NULL)
+				@throw [OFOpenItemFailedException
+				    exceptionWithIRI: IRI
+						mode: nil
+					       errNo: errno];
+
+			@try {
+				_directories = [[OFMutableData alloc]
+				    initWithItemSize: sizeof(DIR *)];
+				_directoryIRIs = [[OFMutableArray alloc]
+				    initWithObject: _IRI];
+				[_directories addItem: &dir];
+			} @catch (id e) {
+				closedir(dir);
+				@throw e;
+			}
+		}
+
+		objc_autoreleasePoolPop(pool);
+	} @catch (id e) {
+		objc_release(self);
+		@throw e;
+	}
+
+	return self;
+}
+
+# ifdef USE_PARALLEL_ENUMERATION
+- (void)of_startParallelEnumerationAtPath: (const char *)path
+{
+	size_t numThreads = [OFSystemInfo numberOfCPUs];
+	ParallelDirectory *root;
+	int errNo;
+
+	if (numThreads < 1)
+		numThreads = 1;
+	if (numThreads > maxParallelThreads)
+		numThreads = maxParallelThreads;
+
+	_parallel = OFAllocZeroedMemory(1, sizeof(*_parallel));
+	_parallel->attributes = _attributes;
+
+	if ((_parallel->rootFD = open(path,
+	    O_RDONLY | O_DIRECTORY | O_CLOEXEC)) == -1) {
+		errNo = errno;
+		OFFreeMemory(_parallel);
+		_parallel = NULL;
+		@throw [OFOpenItemFailedException exceptionWithIRI: _IRI
+							      mode: nil
+							     errNo: errNo];
+	}
+
+	if ((errNo = OFPlainMutexNew(&_parallel->mutex)) != 0) {
+		close(_parallel->rootFD);
+		OFFreeMemory(_parallel);
+		_parallel = NULL;
+		@throw [OFInitializationFailedException
+		    exceptionWithClass: self.class];
+	}
+
+	if ((errNo = OFPlainConditionNew(&_parallel->condition)) != 0) {
+		OFPlainMutexFree(&_parallel->mutex);
+		close(_parallel->rootFD);
+		OFFreeMemory(_parallel);
+		_parallel = NULL;
+		@throw [OFInitializationFailedException
+		    exceptionWithClass: self.class];
+	}
+
+	/* From here on, -[dealloc] cleans up. */
+	if ((root = calloc(1, sizeof(*root))) == NULL)
+		@throw [OFOutOfMemoryException
+		    exceptionWithRequestedSize: sizeof(*root)];
+
+	root->level = 1;
+	_parallel->firstJob = _parallel->lastJob = root;
+
+	for (size_t i = 0; i < numThreads; i++) {
+		if (OFPlainThreadNew(
+		    &_parallel->threads[_parallel->numThreads],
+		    "OFDirectoryEnumerator", parallelWorkerMain, self,
+		    NULL) != 0)
+			break;
+
+		_parallel->numThreads++;
+	}
+
+	if (_parallel->numThreads == 0)
+		@throw [OFInitializationFailedException
+		    exceptionWithClass: self.class];
+}
+# endif
+
+- (void)dealloc
+{
+	if (_directories != nil) {
+		DIR *const *directories = _directories.items;
+		size_t count = _directories.count;
+
+		for (size_t i = 0; i < count; i++)
+			closedir(directories[i]);
+	}
+
+	objc_release(_directories);
+	objc_release(_directoryIRIs);
+
+# ifdef USE_PARALLEL_ENUMERATION
+	if (_parallel != NULL) {
+		OFEnsure(OFPlainMutexLock(&_parallel->mutex) == 0);
+		_parallel->cancelled = true;
+		OFEnsure(OFPlainConditionBroadcast(
+		    &_parallel->condition) == 0);
+		OFEnsure(OFPlainMutexUnlock(&_parallel->mutex) == 0);
+
+		for (size_t i = 0; i < _parallel->numThreads; i++)
+			OFEnsure(OFPlainThreadJoin(_parallel->threads[i]) == 0);
+
+		if (_parallel->current != NULL)
+			freeParallelDirectory(_parallel->current);
+
+		while (_parallel->firstJob != NULL) {
+			ParallelDirectory *next = _parallel->firstJob->next;
+			freeParallelDirectory(_parallel->firstJob);
+			_parallel->firstJob = next;
+		}
+
+		while (_parallel->firstDone != NULL) {
+			ParallelDirectory *next = _parallel->firstDone->next;
+			freeParallelDirectory(_parallel->firstDone);
+			_parallel->firstDone = next;
+		}
+
+		free(_parallel->errorPath);
+		OFPlainConditionFree(&_parallel->condition);
+		OFPlainMutexFree(&_parallel->mutex);
+		close(_parallel->rootFD);
+		OFFreeMemory(_parallel);
+	}
+
+	objc_release(_currentDirectoryIRI);
+# endif
+
+	[super dealloc];
+}
+
+- (void)of_openPendingDirectory
+{
+	void *pool = objc_autoreleasePoolPush();
+	DIR *parent = *(DIR *const *)_directories.lastItem;
+	const char *name = [_pendingDirectoryIRI.lastPathComponent
+	    cStringWithEncoding: [OFLocale encoding]];
+	int fd;
+	DIR *dir;
+
+	if ((fd = openat(dirfd(parent), name,
+	    O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC)) == -1)
+		@throw [OFOpenItemFailedException
+		    exceptionWithIRI: _pendingDirectoryIRI
+				mode: nil
+			       errNo: errno];
+
+	if ((dir = fdopendir(fd)) == NULL) {
+		int errNo = errno;
+
+		close(fd);
+
+		@throw [OFOpenItemFailedException
+		    exceptionWithIRI: _pendingDirectoryIRI
+				mode: nil
+			       errNo: errNo];
+	}
+
+	@try {
+		[_directoryIRIs addObject: _pendingDirectoryIRI];
+	} @catch (id e) {
+		closedir(dir);
+		@throw e;
+	}
+
+	[_directories addItem: &dir];
+
+	objc_release(_pendingDirectoryIRI);
+	_pendingDirectoryIRI = nil;
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (OFIRI *)nextObject
+{
+	OFStringEncoding encoding = [OFLocale encoding];
+	void *pool;
+	OFIRI *IRI;
+	Stat s;
+
+# ifdef USE_PARALLEL_ENUMERATION
+	if (_parallel != NULL)
+		return [self of_nextParallelObject];
+# endif
+
+	pool = objc_autoreleasePoolPush();
+
+	if (_pendingDirectoryIRI != nil)
+		[self of_openPendingDirectory];
+
+	objc_release(_currentAttributes);
+	_currentAttributes = nil;
+
+	for (;;) {
+		DIR *dir;
+		struct dirent *dirent;
+		OFString *name;
+		int errNo;
+
+		if (_directories.count == 0) {
+			_currentLevel = 0;
+			objc_autoreleasePoolPop(pool);
+			return nil;
+		}
+
+		dir = *(DIR *const *)_directories.lastItem;
+
+# if defined(OF_HAVE_THREADS) && !defined(__GLIBC__)
+		[readdirMutex lock];
+# endif
+		errno = 0;
+		dirent = readdir(dir);
+		errNo = errno;
+# if defined(OF_HAVE_THREADS) && !defined(__GLIBC__)
+		[readdirMutex unlock];
+# endif
+
+		if (dirent == NULL) {
+			if (errNo != 0)
+				@throw [OFReadFailedException
+				    exceptionWithObject: self
+					requestedLength: 0
+						  errNo: errNo];
+
+			closedir(dir);
+			[_directories removeLastItem];
+			[_directoryIRIs removeLastObject];
+			continue;
+		}
+
+		if (strcmp(dirent->d_name, ".") == 0 ||
+		    strcmp(dirent->d_name, "..") == 0)
+			continue;
+
+		name = [OFString stringWithCString: dirent->d_name
+					  encoding: encoding];
+
+		if ((errNo = statDirectoryEntry(dirfd(dir), dirent,
+		    _attributes, &s)) != 0) {
+			/* It has been removed since reading the directory. */
+			if (errNo == ENOENT)
+				continue;
+
+			@throw [OFGetItemAttributesFailedException
+			    exceptionWithIRI: [_directoryIRIs.lastObject
+						  IRIByAppendingPathComponent:
+						  name]
+				       errNo: errNo];
+		}
+
+		IRI = [_directoryIRIs.lastObject
+		    IRIByAppendingPathComponent: name
+				    isDirectory: S_ISDIR(s.st_mode)];
+		break;
+	}
+
+	_currentLevel = _directories.count;
+	_currentAttributes = objc_retain(
+	    attributesOfDirectoryEntry(&s, IRI, _attributes));
+
+	if ((_options & OFDirectoryEnumeratorOptionRecursive) &&
+	    S_ISDIR(s.st_mode))
+		_pendingDirectoryIRI = objc_retain(IRI);
+
+	objc_retain(IRI);
+	objc_autoreleasePoolPop(pool);
+
+	return objc_autoreleaseReturnValue(IRI);
+}
+
+# ifdef USE_PARALLEL_ENUMERATION
+- (void)of_throwParallelError
+{
+	OFIRI *IRI = _IRI;
+	int errNo = _parallel->errNo;
+
+	if (_parallel->errorPath != NULL)
+		IRI = [_IRI IRIByAppendingPathComponent:
+		    [OFString stringWithCString: _parallel->errorPath
+				       encoding: [OFLocale encoding]]];
+
+	switch (_parallel->error) {
+	case ParallelErrorOpen:
+		@throw [OFOpenItemFailedException exceptionWithIRI: IRI
+							      mode: nil
+							     errNo: errNo];
+	case ParallelErrorStat:
+		@throw [OFGetItemAttributesFailedException
+		    exceptionWithIRI: IRI
+			       errNo: errNo];
+	default:
+		@throw [OFReadFailedException exceptionWithObject: self
+						  requestedLength: 0
+							    errNo: errNo];
+	}
+}
+
+- (OFIRI *)of_nextParallelObject
+{
+	ParallelEnumeration *parallel = _parallel;
+	void *pool = objc_autoreleasePoolPush();
+	ParallelDirectory *directory;
+	DirectoryEntry *entry;
+	OFString *name;
+	OFIRI *IRI;
+
+	objc_release(_currentAttributes);
+	_currentAttributes = nil;
+
+	while ((directory = parallel->current) == NULL ||
+	    directory->consumed == directory->numEntries) {
+		if (directory != NULL) {
+			parallel->current = NULL;
+			freeParallelDirectory(directory);
+			objc_release(_currentDirectoryIRI);
+			_currentDirectoryIRI = nil;
+		}
+
+		OFEnsure(OFPlainMutexLock(&parallel->mutex) == 0);
+
+		while (parallel->firstDone == NULL && parallel->errNo == 0 &&
+		    (parallel->firstJob != NULL ||
+		    parallel->numBusyThreads > 0))
+			OFEnsure(OFPlainConditionWait(&parallel->condition,
+			    &parallel->mutex) == 0);
+
+		if (parallel->errNo != 0) {
+			OFEnsure(OFPlainMutexUnlock(&parallel->mutex) == 0);
+			[self of_throwParallelError];
+		}
+
+		if ((directory = parallel->firstDone) == NULL) {
+			OFEnsure(OFPlainMutexUnlock(&parallel->mutex) == 0);
+			_currentLevel = 0;
+			objc_autoreleasePoolPop(pool);
+			return nil;
+		}
+
+		if ((parallel->firstDone = directory->next) == NULL)
+			parallel->lastDone = NULL;
+		directory->next = NULL;
+		parallel->numQueuedEntries -= directory->numEntries;
+		parallel->current = directory;
+
+		OFEnsure(OFPlainConditionBroadcast(&parallel->condition) == 0);
+		OFEnsure(OFPlainMutexUnlock(&parallel->mutex) == 0);
+
+		if (directory->path != NULL)
+			_currentDirectoryIRI = objc_retain([_IRI
+			    IRIByAppendingPathComponent: [OFString
+			    stringWithCString: directory->path
+				     encoding: [OFLocale encoding]]
+					    isDirectory: true]);
+		else
+			_currentDirectoryIRI = objc_retain(_IRI);
+	}
+
+	entry = &directory->entries[directory->consumed++];
+	name = [OFString stringWithCString: entry->name
+				  encoding: [OFLocale encoding]];
+	IRI = [_currentDirectoryIRI
+	    IRIByAppendingPathComponent: name
+			    isDirectory: S_ISDIR(entry->stat.st_mode)];
+
+	_currentLevel = directory->level;
+	_currentAttributes = objc_retain(
+	    attributesOfDirectoryEntry(&entry->stat, IRI, _attributes));
+
+	objc_retain(IRI);
+	objc_autoreleasePoolPop(pool);
+
+	return objc_autoreleaseReturnValue(IRI);
+}
+# endif
+@end
+#endif
+
 @implementation OFFileIRIHandler
 + (void)initialize
 {
@@ -2029,6 +3158,25 @@ setExtendedAttributes(OFMutableFileAttributes attributes, OFIRI *IRI)
 	return IRIs;
 }
 
+#ifdef USE_FILE_DIRECTORY_ENUMERATOR
+- (OFDirectoryEnumerator *)
+    enumeratorAtIRI: (OFIRI *)IRI
+	    options: (OFDirectoryEnumeratorOptions)options
+      attributeKeys: (OFArray OF_GENERIC(OFFileAttributeKey) *)attributeKeys
+{
+	if (IRI == nil)
+		@throw [OFInvalidArgumentException exception];
+
+	if (![IRI.scheme isEqual: _scheme])
+		@throw [OFInvalidArgumentException exception];
+
+	return objc_autoreleaseReturnValue(
+	    [[OFFileDirectoryEnumerator alloc] initWithIRI: IRI
+						    options: options
+					      attributeKeys: attributeKeys]);
+}
+#endif
+
 - (void)removeItemAtIRI: (OFIRI *)IRI
 {
 	void *pool = objc_autoreleasePoolPush();
@@ -2203,6 +3351,81 @@ setExtendedAttributes(OFMutableFileAttributes attributes, OFIRI *IRI)
 }
 #endif
 
+#ifdef OF_LINUX
+- (bool)copyItemAtIRI: (OFIRI *)source toIRI: (OFIRI *)destination
+{
+	void *pool;
+	OFStringEncoding encoding;
+	Stat s;
+	int errNo, inFD, outFD;
+
+	if (![source.scheme isEqual: _scheme] ||
+	    ![destination.scheme isEqual: _scheme])
+		return false;
+
+	pool = objc_autoreleasePoolPush();
+
+	if ((errNo = lstatWrapper(source.fileSystemRepresentation, &s)) != 0)
+		@throw [OFCopyItemFailedException
+		    exceptionWithSourceIRI: source
+			    destinationIRI: destination
+				     errNo: errNo];
+
+	/* Directories and special files are handled by OFFileManager. */
+	if (!S_ISREG(s.st_mode)) {
+		objc_autoreleasePoolPop(pool);
+		return false;
+	}
+
+	encoding = [OFLocale encoding];
+
+	if ((inFD = open([source.fileSystemRepresentation
+	    cStringWithEncoding: encoding], O_RDONLY | O_CLOEXEC)) == -1)
+		@throw [OFCopyItemFailedException
+		    exceptionWithSourceIRI: source
+			    destinationIRI: destination
+				     errNo: errno];
+
+	@try {
+		if ((outFD = open([destination.fileSystemRepresentation
+		    cStringWithEncoding: encoding],
+		    O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600)) == -1)
+			@throw [OFCopyItemFailedException
+			    exceptionWithSourceIRI: source
+				    destinationIRI: destination
+					     errNo: errno];
+
+		@try {
+			if ((errNo = copyFile(inFD, outFD, s.st_size)) != 0)
+				@throw [OFCopyItemFailedException
+				    exceptionWithSourceIRI: source
+					    destinationIRI: destination
+						     errNo: errNo];
+
+			/* Like OFFileManager, only copy the permissions. */
+			if (fchmod(outFD, s.st_mode & 07777) != 0)
+				@throw [OFCopyItemFailedException
+				    exceptionWithSourceIRI: source
+					    destinationIRI: destination
+						     errNo: errno];
+		} @catch (id e) {
+			/* Don't leave a partial copy behind. */
+			unlink([destination.fileSystemRepresentation
+			    cStringWithEncoding: encoding]);
+			@throw e;
+		} @finally {
+			close(outFD);
+		}
+	} @finally {
+		close(inFD);
+	}
+
+	objc_autoreleasePoolPop(pool);
+
+	return true;
+}
+#endif
+
 - (bool)moveItemAtIRI: (OFIRI *)source toIRI: (OFIRI *)destination
 {
 	void *pool;
@@ -49,6 +49,7 @@ OF_ASSUME_NONNULL_BEGIN
 @class OFArray OF_GENERIC(ObjectType);
 @class OFConstantString;
 @class OFDate;
+@class OFDirectoryEnumerator;
 @class OFIRI;
 @class OFNumber;
 @class OFString;
@@ -166,6 +167,49 @@ typedef OFDictionary OF_GENERIC(OFFileAttributeKey, id) *OFFileAttributes;
 typedef OFMutableDictionary OF_GENERIC(OFFileAttributeKey, id)
     *OFMutableFileAttributes;
 
+/**
+ * @brief Options for an @ref OFDirectoryEnumerator.
+ */
+typedef enum {
+	/** Enumerate the contents of subdirectories as well. */
+	OFDirectoryEnumeratorOptionRecursive = 0x01,
+	/**
+	 * Read subdirectories in parallel if supported. The items are returned
+	 * in no particular order then, other than that a directory is always
+	 * returned before its contents, and
+	 * @ref OFDirectoryEnumerator#skipDescendants has no effect.
+	 */
+	OFDirectoryEnumeratorOptionParallel  = 0x02
+} OFDirectoryEnumeratorOptions;
+
+/**
+ * @brief Options for copying or removing a directory tree.
+ */
+typedef enum {
+	/**
+	 * Copy or remove the files on a pool of worker threads if supported.
+	 * Directories are still created before and removed after their
+	 * contents.
+	 */
+	OFFileManagerTreeOptionParallel = 0x01
+} OFFileManagerTreeOptions;
+
+#ifdef OF_HAVE_BLOCKS
+/**
+ * @brief A handler which is called for each item of a directory tree that has
+ *	  been copied or removed.
+ *
+ * The handler is always called on the thread that started the operation.
+ *
+ * @param IRI The IRI of the item, which is the source for a copy
+ * @param exception An exception which occurred for the item or `nil` on
+ *		    success
+ * @return Whether the operation should continue with the remaining items
+ */
+typedef bool (^OFFileManagerTreeItemHandler)(OFIRI *IRI,
+    id _Nullable exception);
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -603,6 +647,29 @@ OF_SUBCLASSING_RESTRICTED
  */
 - (OFArray OF_GENERIC(OFIRI *) *)contentsOfDirectoryAtIRI: (OFIRI *)IRI;
 
+/**
+ * @brief Returns an enumerator for the items in the specified directory.
+ *
+ * Unlike @ref contentsOfDirectoryAtIRI:, this reads the directory as it is
+ * being enumerated and only retrieves the requested attributes of each item.
+ *
+ * @note `.` and `..` are not enumerated.
+ *
+ * @param IRI The IRI to the directory whose items should be enumerated
+ * @param options The options for the enumeration
+ * @param attributeKeys The keys of the attributes to retrieve for each item,
+ *			or `nil` if only the type should be retrieved
+ * @return An enumerator for the items in the specified directory
+ * @throw OFOpenItemFailedException Opening the directory failed
+ * @throw OFUnsupportedProtocolException No handler is registered for the IRI's
+ *					 scheme
+ */
+- (OFDirectoryEnumerator *)
+    enumeratorAtIRI: (OFIRI *)IRI
+	    options: (OFDirectoryEnumeratorOptions)options
+      attributeKeys: (nullable OFArray OF_GENERIC(OFFileAttributeKey) *)
+			 attributeKeys;
+
 #ifdef OF_HAVE_FILES
 /**
  * @brief Returns an array with all subpaths of the specified directory.
@@ -668,6 +735,50 @@ OF_SUBCLASSING_RESTRICTED
  */
 - (void)copyItemAtIRI: (OFIRI *)source toIRI: (OFIRI *)destination;
 
+/**
+ * @brief Copies a file, directory or symbolic link (if supported by the OS)
+ *	  using the specified options.
+ *
+ * This behaves like @ref copyItemAtIRI:toIRI:, but the files of a directory
+ * are copied in parallel if @ref OFFileManagerTreeOptionParallel is specified.
+ * The permissions of the copied directories are set after their contents have
+ * been copied.
+ *
+ * @param source The file, directory or symbolic link to copy
+ * @param destination The destination IRI
+ * @param options The options for the copy
+ * @throw OFCopyItemFailedException Copying failed
+ * @throw OFUnsupportedProtocolException No handler is registered for either of
+ *					 the IRI's scheme
+ */
+- (void)copyItemAtIRI: (OFIRI *)source
+		toIRI: (OFIRI *)destination
+	      options: (OFFileManagerTreeOptions)options;
+
+#ifdef OF_HAVE_BLOCKS
+/**
+ * @brief Copies a file, directory or symbolic link (if supported by the OS)
+ *	  using the specified options and calls the specified handler for each
+ *	  item.
+ *
+ * Unlike @ref copyItemAtIRI:toIRI:options:, this does not stop at the first
+ * item that fails to be copied, but passes the exception to the handler, which
+ * decides whether to continue.
+ *
+ * @param source The file, directory or symbolic link to copy
+ * @param destination The destination IRI
+ * @param options The options for the copy
+ * @param itemHandler The handler to call for each item that has been copied
+ * @throw OFCopyItemFailedException Copying the source itself failed
+ * @throw OFUnsupportedProtocolException No handler is registered for either of
+ *					 the IRI's scheme
+ */
+- (void)copyItemAtIRI: (OFIRI *)source
+		toIRI: (OFIRI *)destination
+	      options: (OFFileManagerTreeOptions)options
+	  itemHandler: (OFFileManagerTreeItemHandler)itemHandler;
+#endif
+
 #ifdef OF_HAVE_FILES
 /**
  * @brief Moves an item.
@@ -771,6 +882,42 @@ OF_SUBCLASSING_RESTRICTED
  */
 - (void)removeItemAtIRI: (OFIRI *)IRI;
 
+/**
+ * @brief Removes the item at the specified IRI using the specified options.
+ *
+ * This behaves like @ref removeItemAtIRI:, but the files of a directory are
+ * removed in parallel if @ref OFFileManagerTreeOptionParallel is specified.
+ *
+ * @param IRI The IRI to the item which should be removed
+ * @param options The options for the removal
+ * @throw OFRemoveItemFailedException Removing the item failed
+ * @throw OFUnsupportedProtocolException No handler is registered for the IRI's
+ *					 scheme
+ */
+- (void)removeItemAtIRI: (OFIRI *)IRI
+		options: (OFFileManagerTreeOptions)options;
+
+#ifdef OF_HAVE_BLOCKS
+/**
+ * @brief Removes the item at the specified IRI using the specified options and
+ *	  calls the specified handler for each item.
+ *
+ * Unlike @ref removeItemAtIRI:options:, this does not stop at the first item
+ * that fails to be removed, but passes the exception to the handler, which
+ * decides whether to continue.
+ *
+ * @param IRI The IRI to the item which should be removed
+ * @param options The options for the removal
+ * @param itemHandler The handler to call for each item that has been removed
+ * @throw OFRemoveItemFailedException Retrieving the type of the item failed
+ * @throw OFUnsupportedProtocolException No handler is registered for the IRI's
+ *					 scheme
+ */
+- (void)removeItemAtIRI: (OFIRI *)IRI
+		options: (OFFileManagerTreeOptions)options
+	    itemHandler: (OFFileManagerTreeItemHandler)itemHandler;
+#endif
+
 #ifdef OF_FILE_MANAGER_SUPPORTS_LINKS
 /**
  * @brief Creates a hard link for the specified item.
@@ -38,6 +38,7 @@
 #import "OFData.h"
 #import "OFDate.h"
 #import "OFDictionary.h"
+#import "OFDirectoryEnumerator.h"
 #ifdef OF_HAVE_FILES
 # import "OFFile.h"
 #endif
@@ -49,6 +50,10 @@
 #import "OFStream.h"
 #import "OFString.h"
 #import "OFSystemInfo.h"
+#ifdef OF_HAVE_THREADS
+# import "OFCondition.h"
+# import "OFThread.h"
+#endif
 
 #import "OFChangeCurrentDirectoryFailedException.h"
 #import "OFCopyItemFailedException.h"
@@ -86,6 +91,86 @@
 @interface OFDefaultFileManager: OFFileManager
 @end
 
+#ifdef OF_HAVE_THREADS
+@class OFFileManagerTreeOperation;
+
+OF_DIRECT_MEMBERS
+@interface OFFileManagerTreeWorker: OFThread
+{
+@public
+	/* Not retained, as the operation joins its workers. */
+	OFFileManagerTreeOperation *_operation;
+}
+@end
+#endif
+
+/*
+ * Copies or removes the items of a directory tree, either on the calling
+ * thread or on a pool of workers, and reports the result for each item on the
+ * calling thread.
+ */
+OF_DIRECT_MEMBERS
+@interface OFFileManagerTreeOperation: OFObject
+{
+	OFFileManager *_fileManager;
+	bool _copy, _stopped;
+	id _Nullable _exception;
+#ifdef OF_HAVE_BLOCKS
+	OFFileManagerTreeItemHandler _Nullable _itemHandler;
+#endif
+#ifdef OF_HAVE_THREADS
+	OFCondition *_Nullable _condition;
+	OFMutableArray OF_GENERIC(OFFileManagerTreeWorker *) *_Nullable
+	    _workers;
+	OFMutableArray OF_GENERIC(OFArray *) *_Nullable _queue, *_results;
+	size_t _numBusyWorkers;
+	bool _done;
+#endif
+}
+
+#ifdef OF_HAVE_BLOCKS
+@property OF_NULLABLE_PROPERTY (copy, nonatomic)
+    OFFileManagerTreeItemHandler itemHandler;
+#endif
+@property (readonly, nonatomic, getter=isStopped) bool stopped;
+
+- (instancetype)initWithFileManager: (OFFileManager *)fileManager
+			       copy: (bool)copy
+			    options: (OFFileManagerTreeOptions)options;
+- (void)addItemAtIRI: (OFIRI *)IRI
+      destinationIRI: (nullable OFIRI *)destinationIRI;
+- (void)reportItemAtIRI: (OFIRI *)IRI exception: (nullable id)exception;
+- (void)waitUntilDone;
+- (void)stopWorkers;
+- (void)finish;
+- (void)performItem: (OFArray OF_GENERIC(OFIRI *) *)item;
+#ifdef OF_HAVE_THREADS
+- (void)reportResults: (OFArray OF_GENERIC(OFArray *) *)results;
+- (OFArray OF_GENERIC(OFArray *) *)takeResults;
+- (void)runWorker;
+#endif
+@end
+
+static const size_t maxTreeWorkers = 8;
+static const size_t maxQueuedTreeItems = 256;
+
+static id
+copyFailedException(id exception, OFIRI *source, OFIRI *destination)
+{
+	/*
+	 * Only convert exceptions to OFCopyItemFailedException that have an
+	 * errNo property, all others should be left as is.
+	 */
+	if ([exception isKindOfClass: [OFCopyItemFailedException class]] ||
+	    ![exception respondsToSelector: @selector(errNo)])
+		return exception;
+
+	return [OFCopyItemFailedException
+	    exceptionWithSourceIRI: source
+		    destinationIRI: destination
+			     errNo: [exception errNo]];
+}
+
 #ifdef OF_AMIGAOS4
 # define CurrentDir(lock) SetCurrentDir(lock)
 #endif
@@ -690,6 +775,24 @@ attributeForKeyOrException(OFFileAttributes attributes, OFFileAttributeKey key)
 	return [IRIHandler contentsOfDirectoryAtIRI: IRI];
 }
 
+- (OFDirectoryEnumerator *)
+    enumeratorAtIRI: (OFIRI *)IRI
+	    options: (OFDirectoryEnumeratorOptions)options
+      attributeKeys: (OFArray OF_GENERIC(OFFileAttributeKey) *)attributeKeys
+{
+	OFIRIHandler *IRIHandler;
+
+	if (IRI == nil)
+		@throw [OFInvalidArgumentException exception];
+
+	if ((IRIHandler = [OFIRIHandler handlerForIRI: IRI]) == nil)
+		@throw [OFUnsupportedProtocolException exceptionWithIRI: IRI];
+
+	return [IRIHandler enumeratorAtIRI: IRI
+				   options: options
+			     attributeKeys: attributeKeys];
+}
+
 #ifdef OF_HAVE_FILES
 - (OFArray OF_GENERIC(OFString *) *)contentsOfDirectoryAtPath: (OFString *)path
 {
@@ -717,19 +820,28 @@ attributeForKeyOrException(OFFileAttributes attributes, OFFileAttributeKey key)
 	void *pool = objc_autoreleasePoolPush();
 	OFMutableArray OF_GENERIC(OFString *) *ret =
 	    [OFMutableArray arrayWithObject: path];
+	/* The path of the directory each level is in. */
+	OFMutableArray OF_GENERIC(OFString *) *parents =
+	    [OFMutableArray arrayWithObject: path];
+	OFDirectoryEnumerator *enumerator = [self
+	    enumeratorAtIRI: [OFIRI fileIRIWithPath: path isDirectory: true]
+		    options: OFDirectoryEnumeratorOptionRecursive
+	      attributeKeys: nil];
 
-	for (OFString *subpath in [self contentsOfDirectoryAtPath: path]) {
+	for (OFIRI *IRI in enumerator) {
 		void *pool2 = objc_autoreleasePoolPush();
-		OFString *fullSubpath =
-		    [path stringByAppendingPathComponent: subpath];
-		OFFileAttributes attributes =
-		    [self attributesOfItemAtPath: fullSubpath];
+		size_t level = enumerator.currentLevel;
+		OFString *subpath = [[parents objectAtIndex: level - 1]
+		    stringByAppendingPathComponent: IRI.lastPathComponent];
 
-		if ([attributes.fileType isEqual: OFFileTypeDirectory])
-			[ret addObjectsFromArray:
-			    [self subpathsOfDirectoryAtPath: fullSubpath]];
-		else
-			[ret addObject: fullSubpath];
+		[ret addObject: subpath];
+
+		if ([enumerator.currentAttributes.fileType
+		    isEqual: OFFileTypeDirectory]) {
+			[parents removeObjectsInRange:
+			    OFMakeRange(level, parents.count - level)];
+			[parents addObject: subpath];
+		}
 
 		objc_autoreleasePoolPop(pool2);
 	}
@@ -996,6 +1108,195 @@ attributeForKeyOrException(OFFileAttributes attributes, OFFileAttributeKey key)
 	objc_autoreleasePoolPop(pool);
 }
 
+- (void)copyItemAtIRI: (OFIRI *)source
+		toIRI: (OFIRI *)destination
+	      options: (OFFileManagerTreeOptions)options
+{
+	OFFileManagerTreeOperation *operation =
+	    [[OFFileManagerTreeOperation alloc] initWithFileManager: self
+							       copy: true
+							    options: options];
+
+	@try {
+		[self of_copyItemAtIRI: source
+				 toIRI: destination
+			     operation: operation];
+	} @finally {
+		objc_release(operation);
+	}
+}
+
+#ifdef OF_HAVE_BLOCKS
+- (void)copyItemAtIRI: (OFIRI *)source
+		toIRI: (OFIRI *)destination
+	      options: (OFFileManagerTreeOptions)options
+	  itemHandler: (OFFileManagerTreeItemHandler)itemHandler
+{
+	OFFileManagerTreeOperation *operation =
+	    [[OFFileManagerTreeOperation alloc] initWithFileManager: self
+							       copy: true
+							    options: options];
+
+	@try {
+		operation.itemHandler = itemHandler;
+
+		[self of_copyItemAtIRI: source
+				 toIRI: destination
+			     operation: operation];
+	} @finally {
+		objc_release(operation);
+	}
+}
+#endif
+
+- (void)of_copyItemAtIRI: (OFIRI *)source
+		   toIRI: (OFIRI *)destination
+	       operation: (OFFileManagerTreeOperation *)operation
+{
+	void *pool;
+	OFFileAttributes attributes;
+	OFMutableArray OF_GENERIC(OFArray *) *directories;
+	OFMutableArray OF_GENERIC(OFIRI *) *destinations;
+	OFDirectoryEnumerator *enumerator;
+
+	if (source == nil || destination == nil)
+		@throw [OFInvalidArgumentException exception];
+
+	pool = objc_autoreleasePoolPush();
+
+	@try {
+		attributes = [self attributesOfItemAtIRI: source];
+	} @catch (OFGetItemAttributesFailedException *e) {
+		@throw [OFCopyItemFailedException
+		    exceptionWithSourceIRI: source
+			    destinationIRI: destination
+				     errNo: e.errNo];
+	}
+
+	if (![attributes.fileType isEqual: OFFileTypeDirectory]) {
+		[self copyItemAtIRI: source toIRI: destination];
+		[operation reportItemAtIRI: source exception: nil];
+		objc_autoreleasePoolPop(pool);
+		return;
+	}
+
+	if ([self fileExistsAtIRI: destination])
+		@throw [OFCopyItemFailedException
+		    exceptionWithSourceIRI: source
+			    destinationIRI: destination
+				     errNo: EEXIST];
+
+	@try {
+		[self createDirectoryAtIRI: destination];
+		enumerator = [self
+		    enumeratorAtIRI: source
+			    options: OFDirectoryEnumeratorOptionRecursive
+		      attributeKeys: [OFArray arrayWithObject:
+					 OFFilePOSIXPermissions]];
+	} @catch (id e) {
+		@throw copyFailedException(e, source, destination);
+	}
+
+	/* Each entry is the destination IRI and the permissions to set. */
+	directories = [OFMutableArray arrayWithObject:
+	    [OFArray arrayWithObjects: destination,
+	    [attributes objectForKey: OFFilePOSIXPermissions], nil]];
+	destinations = [OFMutableArray arrayWithObject: destination];
+
+	@try {
+		for (OFIRI *item in enumerator) {
+			void *pool2 = objc_autoreleasePoolPush();
+			OFFileAttributes itemAttributes =
+			    enumerator.currentAttributes;
+			size_t level = enumerator.currentLevel;
+			OFIRI *itemDestination = [[destinations
+			    objectAtIndex: level - 1]
+			    IRIByAppendingPathComponent:
+			    item.lastPathComponent];
+
+			if (![itemAttributes.fileType
+			    isEqual: OFFileTypeDirectory]) {
+				[operation addItemAtIRI: item
+					 destinationIRI: itemDestination];
+			} else {
+				id exception = nil;
+
+				@try {
+					[self createDirectoryAtIRI:
+					    itemDestination];
+				} @catch (id e) {
+					exception = copyFailedException(e,
+					    item, itemDestination);
+				}
+
+				if (exception == nil) {
+					[directories addObject:
+					    [OFArray arrayWithObjects:
+					    itemDestination, [itemAttributes
+					    objectForKey:
+					    OFFilePOSIXPermissions], nil]];
+					[destinations removeObjectsInRange:
+					    OFMakeRange(level,
+					    destinations.count - level)];
+					[destinations addObject:
+					    itemDestination];
+				} else
+					[enumerator skipDescendants];
+
+				[operation reportItemAtIRI: item
+						 exception: exception];
+			}
+
+			objc_autoreleasePoolPop(pool2);
+
+			if (operation.stopped)
+				break;
+		}
+
+		[operation waitUntilDone];
+	} @catch (id e) {
+		@throw copyFailedException(e, source, destination);
+	} @finally {
+		[operation stopWorkers];
+	}
+
+	/*
+	 * The permissions of the directories are set last, innermost first,
+	 * as they might not allow creating the contents.
+	 */
+	for (OFArray *directory in directories.reverseObjectEnumerator) {
+		void *pool2 = objc_autoreleasePoolPush();
+		OFNumber *permissions;
+		id exception = nil;
+
+		if (directory.count < 2)
+			continue;
+
+		permissions = [directory objectAtIndex: 1];
+
+		@try {
+			[self setAttributes: [OFDictionary
+			    dictionaryWithObject: permissions
+					  forKey: OFFilePOSIXPermissions]
+				ofItemAtIRI: directory.firstObject];
+		} @catch (OFNotImplementedException *e) {
+		} @catch (id e) {
+			exception = copyFailedException(e, source,
+			    directory.firstObject);
+		}
+
+		if (exception != nil)
+			[operation reportItemAtIRI: directory.firstObject
+					 exception: exception];
+
+		objc_autoreleasePoolPop(pool2);
+	}
+
+	[operation finish];
+
+	objc_autoreleasePoolPop(pool);
+}
+
 #ifdef OF_HAVE_FILES
 - (void)moveItemAtPath: (OFString *)source toPath: (OFString *)destination
 {
@@ -1137,6 +1438,131 @@ attributeForKeyOrException(OFFileAttributes attributes, OFFileAttributeKey key)
 	[IRIHandler removeItemAtIRI: IRI];
 }
 
+- (void)removeItemAtIRI: (OFIRI *)IRI
+		options: (OFFileManagerTreeOptions)options
+{
+	OFFileManagerTreeOperation *operation =
+	    [[OFFileManagerTreeOperation alloc] initWithFileManager: self
+							       copy: false
+							    options: options];
+
+	@try {
+		[self of_removeItemAtIRI: IRI operation: operation];
+	} @finally {
+		objc_release(operation);
+	}
+}
+
+#ifdef OF_HAVE_BLOCKS
+- (void)removeItemAtIRI: (OFIRI *)IRI
+		options: (OFFileManagerTreeOptions)options
+	    itemHandler: (OFFileManagerTreeItemHandler)itemHandler
+{
+	OFFileManagerTreeOperation *operation =
+	    [[OFFileManagerTreeOperation alloc] initWithFileManager: self
+							       copy: false
+							    options: options];
+
+	@try {
+		operation.itemHandler = itemHandler;
+
+		[self of_removeItemAtIRI: IRI operation: operation];
+	} @finally {
+		objc_release(operation);
+	}
+}
+#endif
+
+- (void)of_removeItemAtIRI: (OFIRI *)IRI
+		 operation: (OFFileManagerTreeOperation *)operation
+{
+	void *pool;
+	OFFileAttributes attributes;
+	OFMutableArray OF_GENERIC(OFIRI *) *directories;
+	OFDirectoryEnumerator *enumerator;
+
+	if (IRI == nil)
+		@throw [OFInvalidArgumentException exception];
+
+	pool = objc_autoreleasePoolPush();
+
+	@try {
+		attributes = [self attributesOfItemAtIRI: IRI];
+	} @catch (OFGetItemAttributesFailedException *e) {
+		@throw [OFRemoveItemFailedException exceptionWithIRI: IRI
+							       errNo: e.errNo];
+	}
+
+	if (![attributes.fileType isEqual: OFFileTypeDirectory]) {
+		[self removeItemAtIRI: IRI];
+		[operation reportItemAtIRI: IRI exception: nil];
+		objc_autoreleasePoolPop(pool);
+		return;
+	}
+
+	directories = [OFMutableArray arrayWithObject: IRI];
+
+	@try {
+		enumerator = [self
+		    enumeratorAtIRI: IRI
+			    options: OFDirectoryEnumeratorOptionRecursive
+		      attributeKeys: nil];
+
+		for (OFIRI *item in enumerator) {
+			void *pool2 = objc_autoreleasePoolPush();
+
+			if ([enumerator.currentAttributes.fileType
+			    isEqual: OFFileTypeDirectory])
+				[directories addObject: item];
+			else
+				[operation addItemAtIRI: item
+					 destinationIRI: nil];
+
+			objc_autoreleasePoolPop(pool2);
+
+			if (operation.stopped)
+				break;
+		}
+
+		[operation waitUntilDone];
+	} @catch (id e) {
+		if ([e isKindOfClass: [OFRemoveItemFailedException class]] ||
+		    ![e respondsToSelector: @selector(errNo)])
+			@throw e;
+
+		@throw [OFRemoveItemFailedException
+		    exceptionWithIRI: IRI
+			       errNo: [e errNo]];
+	} @finally {
+		[operation stopWorkers];
+	}
+
+	/* Directories were found before their contents, so remove backwards. */
+	for (OFIRI *directory in directories.reverseObjectEnumerator) {
+		void *pool2;
+		id exception = nil;
+
+		if (operation.stopped)
+			break;
+
+		pool2 = objc_autoreleasePoolPush();
+
+		@try {
+			[self removeItemAtIRI: directory];
+		} @catch (id e) {
+			exception = e;
+		}
+
+		[operation reportItemAtIRI: directory exception: exception];
+
+		objc_autoreleasePoolPop(pool2);
+	}
+
+	[operation finish];
+
+	objc_autoreleasePoolPop(pool);
+}
+
 #ifdef OF_HAVE_FILES
 - (void)removeItemAtPath: (OFString *)path
 {
@@ -1382,6 +1808,302 @@ attributeForKeyOrException(OFFileAttributes attributes, OFFileAttributeKey key)
 OF_SINGLETON_METHODS
 @end
 
+#ifdef OF_HAVE_THREADS
+@implementation OFFileManagerTreeWorker
+- (id)main
+{
+	[_operation runWorker];
+
+	return nil;
+}
+@end
+#endif
+
+@implementation OFFileManagerTreeOperation
+#ifdef OF_HAVE_BLOCKS
+@synthesize itemHandler = _itemHandler;
+#endif
+@synthesize stopped = _stopped;
+
+- (instancetype)initWithFileManager: (OFFileManager *)fileManager
+			       copy: (bool)copy
+			    options: (OFFileManagerTreeOptions)options
+{
+	self = [super init];
+
+	@try {
+		_fileManager = objc_retain(fileManager);
+		_copy = copy;
+
+#ifdef OF_HAVE_THREADS
+		if (options & OFFileManagerTreeOptionParallel) {
+			size_t numWorkers = [OFSystemInfo numberOfCPUs];
+
+			if (numWorkers < 2)
+				numWorkers = 2;
+			if (numWorkers > maxTreeWorkers)
+				numWorkers = maxTreeWorkers;
+
+			_condition = [[OFCondition alloc] init];
+			_queue = [[OFMutableArray alloc] init];
+			_results = [[OFMutableArray alloc] init];
+			_workers = [[OFMutableArray alloc] init];
+
+			for (size_t i = 0; i < numWorkers; i++) {
+				OFFileManagerTreeWorker *worker =
+				    [OFFileManagerTreeWorker thread];
+
+				worker->_operation = self;
+				worker.name = @"OFFileManager worker";
+				[_workers addObject: worker];
+				[worker start];
+			}
+		}
+#endif
+	} @catch (id e) {
+		[self stopWorkers];
+		objc_release(self);
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[self stopWorkers];
+
+	objc_release(_fileManager);
+	objc_release(_exception);
+#ifdef OF_HAVE_BLOCKS
+	objc_release(_itemHandler);
+#endif
+#ifdef OF_HAVE_THREADS
+	objc_release(_condition);
+	objc_release(_workers);
+	objc_release(_queue);
+	objc_release(_results);
+#endif
+
+	[super dealloc];
+}
+
+- (void)performItem: (OFArray OF_GENERIC(OFIRI *) *)item
+{
+	if (_copy)
+		[_fileManager copyItemAtIRI: item.firstObject
+				      toIRI: [item objectAtIndex: 1]];
+	else
+		[_fileManager removeItemAtIRI: item.firstObject];
+}
+
+- (void)reportItemAtIRI: (OFIRI *)IRI exception: (id)exception
+{
+#ifdef OF_HAVE_BLOCKS
+	if (_itemHandler != NULL) {
+		if (!_itemHandler(IRI, exception))
+			_stopped = true;
+
+		return;
+	}
+#endif
+
+	if (exception != nil) {
+		if (_exception == nil)
+			_exception = objc_retain(exception);
+
+		_stopped = true;
+	}
+}
+
+#ifdef OF_HAVE_THREADS
+- (void)reportResults: (OFArray OF_GENERIC(OFArray *) *)results
+{
+	for (OFArray *result in results) {
+		id exception = (result.count > 1
+		    ? [result objectAtIndex: 1] : nil);
+
+		[self reportItemAtIRI: result.firstObject exception: exception];
+	}
+
+	/* Don't start any more items once the operation has been stopped. */
+	if (_stopped) {
+		[_condition lock];
+		[_queue removeAllObjects];
+		[_condition unlock];
+	}
+}
+
+- (OFArray OF_GENERIC(OFArray *) *)takeResults
+{
+	OFArray *results = objc_autorelease([_results copy]);
+
+	[_results removeAllObjects];
+
+	return results;
+}
+#endif
+
+- (void)addItemAtIRI: (OFIRI *)IRI destinationIRI: (OFIRI *)destinationIRI
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFArray *item = [OFArray arrayWithObjects: IRI, destinationIRI, nil];
+
+	if (_stopped) {
+		objc_autoreleasePoolPop(pool);
+		return;
+	}
+
+#ifdef OF_HAVE_THREADS
+	if (_workers != nil) {
+		bool queued = false;
+
+		while (!queued && !_stopped) {
+			OFArray *results;
+
+			[_condition lock];
+			@try {
+				/*
+				 * Keep the queue bounded so that the tree is
+				 * not read entirely into memory if items are
+				 * slow to process.
+				 */
+				if (_queue.count < maxQueuedTreeItems) {
+					[_queue addObject: item];
+					[_condition signal];
+					queued = true;
+				} else if (_results.count == 0)
+					[_condition wait];
+
+				results = [self takeResults];
+			} @finally {
+				[_condition unlock];
+			}
+
+			[self reportResults: results];
+		}
+
+		objc_autoreleasePoolPop(pool);
+		return;
+	}
+#endif
+
+	@try {
+		[self performItem: item];
+		[self reportItemAtIRI: IRI exception: nil];
+	} @catch (id e) {
+		[self reportItemAtIRI: IRI exception: e];
+	}
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (void)waitUntilDone
+{
+#ifdef OF_HAVE_THREADS
+	bool done = (_workers == nil);
+
+	while (!done) {
+		void *pool = objc_autoreleasePoolPush();
+		OFArray *results;
+
+		[_condition lock];
+		@try {
+			while (_results.count == 0 &&
+			    (_queue.count > 0 || _numBusyWorkers > 0))
+				[_condition wait];
+
+			results = [self takeResults];
+			done = (_queue.count == 0 && _numBusyWorkers == 0);
+		} @finally {
+			[_condition unlock];
+		}
+
+		[self reportResults: results];
+
+		objc_autoreleasePoolPop(pool);
+	}
+#endif
+}
+
+- (void)stopWorkers
+{
+#ifdef OF_HAVE_THREADS
+	if (_workers == nil)
+		return;
+
+	[_condition lock];
+	[_queue removeAllObjects];
+	_done = true;
+	[_condition broadcast];
+	[_condition unlock];
+
+	for (OFFileManagerTreeWorker *worker in _workers)
+		[worker join];
+
+	objc_release(_workers);
+	_workers = nil;
+#endif
+}
+
+- (void)finish
+{
+	if (_exception != nil)
+		@throw objc_autorelease(objc_retain(_exception));
+}
+
+#ifdef OF_HAVE_THREADS
+- (void)runWorker
+{
+	for (;;) {
+		void *pool = objc_autoreleasePoolPush();
+		OFArray *item = nil, *result;
+		id exception = nil;
+
+		[_condition lock];
+		@try {
+			while (_queue.count == 0 && !_done)
+				[_condition wait];
+
+			if (_queue.count > 0) {
+				item = objc_autorelease(
+				    objc_retain(_queue.firstObject));
+				[_queue removeObjectAtIndex: 0];
+				_numBusyWorkers++;
+			}
+		} @finally {
+			[_condition unlock];
+		}
+
+		if (item == nil) {
+			objc_autoreleasePoolPop(pool);
+			break;
+		}
+
+		@try {
+			[self performItem: item];
+		} @catch (id e) {
+			exception = e;
+		}
+
+		result = [OFArray arrayWithObjects: item.firstObject,
+		    exception, nil];
+
+		[_condition lock];
+		@try {
+			[_results addObject: result];
+			_numBusyWorkers--;
+			[_condition broadcast];
+		} @finally {
+			[_condition unlock];
+		}
+
+		objc_autoreleasePoolPop(pool);
+	}
+}
+#endif
+@end
+
 @implementation OFDictionary (FileAttributes)
 - (unsigned long long)fileSize
 {
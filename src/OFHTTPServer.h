@@ -43,6 +43,14 @@ OF_ASSUME_NONNULL_BEGIN
  * @brief This method is called when the HTTP server received a request from a
  *	  client.
  *
+ * By default, writing to the response blocks until the client accepted the
+ * data, so a slow client can stall all connections handled by the same thread.
+ * To avoid this, set @ref OFStream#canBlock of the response to `false` and
+ * write the body asynchronously. The server then queues at most 64 KiB per
+ * response and only calls the write handler or delegate once the data has
+ * been queued, which makes it wait for slow clients without blocking. Note
+ * that this also makes reading the `requestBody` non-blocking.
+ *
  * @param server The HTTP server which received the request
  * @param request The request the HTTP server received. The request will always
  *		  have its @ref OFHTTPRequest#body set to `nil` and instead the
@@ -143,6 +151,7 @@ OF_SUBCLASSING_RESTRICTED
 #ifdef OF_HAVE_THREADS
 	size_t _numberOfThreads, _nextThreadIndex;
 	OFArray *_threadPool;
+	bool _listensOnAllThreads;
 #endif
 }
 
@@ -196,6 +205,28 @@ OF_SUBCLASSING_RESTRICTED
  *				 @ref start had already been called
  */
 @property (nonatomic) size_t numberOfThreads;
+
+/**
+ * @brief Whether every thread of the OFHTTPServer accepts connections on its
+ *	  own listening socket.
+ *
+ * If this is true and @ref numberOfThreads is larger than 1, each thread binds
+ * its own listening socket to the same host and port using `SO_REUSEPORT` and
+ * handles the connections it accepted itself. This lets the kernel balance
+ * incoming connections between the threads instead of accepting all of them
+ * on a single thread.
+ *
+ * @note As each thread then accepts its own connections, accepting happens on
+ *	 the worker threads and so do all delegate callbacks, including those
+ *	 for exceptions while accepting. The delegate therefore needs to be
+ *	 thread-safe.
+ *
+ * @throw OFAlreadyOpenException The option could not be set because
+ *				 @ref start had already been called
+ * @throw OFNotImplementedException `SO_REUSEPORT` is not supported on this
+ *				    platform
+ */
+@property (nonatomic) bool listensOnAllThreads;
 #endif
 
 /**
@@ -203,6 +234,8 @@ OF_SUBCLASSING_RESTRICTED
  *
  * Setting it to `nil` means no `Server` header will be sent, unless one is
  * specified in the response headers.
+ *
+ * @throw OFInvalidArgumentException The name contains a newline
  */
 @property OF_NULLABLE_PROPERTY (copy, nonatomic) OFString *name;
 
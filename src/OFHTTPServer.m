@@ -24,6 +24,7 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #import "OFHTTPServer.h"
 #import "OFArray.h"
@@ -34,6 +35,7 @@
 #import "OFHTTPResponse.h"
 #import "OFIRI.h"
 #import "OFIRI+Private.h"
+#import "OFMutableData.h"
 #import "OFNumber.h"
 #import "OFSocket.h"
 #import "OFSocket+Private.h"
@@ -49,6 +51,7 @@
 #import "OFInvalidArgumentException.h"
 #import "OFInvalidEncodingException.h"
 #import "OFInvalidFormatException.h"
+#import "OFNotImplementedException.h"
 #import "OFNotOpenException.h"
 #import "OFOutOfMemoryException.h"
 #import "OFOutOfRangeException.h"
@@ -71,13 +74,16 @@ OF_DIRECT_MEMBERS
 	OFHTTPServer *_server;
 	OFHTTPRequest *_request;
 	bool _chunked, _headersSent;
+	char *_headerBuffer;
+	size_t _headerLength;
+	OFMutableData *_queuedData;
 }
 
 - (instancetype)
     of_initWithStream: (OFStream <OFReadyForWritingObserving> *)stream
 	       server: (OFHTTPServer *)server
 	      request: (OFHTTPRequest *)request;
-- (void)of_sendHeaders;
+- (void)of_serializeHeaders;
 @end
 
 OF_DIRECT_MEMBERS
@@ -88,11 +94,9 @@ OF_DIRECT_MEMBERS
 	    *_stream;
 	OFHTTPServer *_server;
 	OFTimer *_timer;
-	enum {
-		stateAwaitingProlog,
-		stateParsingHeaders,
-		stateSendResponse
-	} _state;
+	char *_buffer;
+	size_t _bufferSize, _bufferLength, _scannedLength, _lineStart;
+	size_t _numLines;
 	uint8_t _HTTPMinorVersion;
 	OFHTTPRequestMethod _method;
 	OFString *_host, *_path;
@@ -105,8 +109,12 @@ OF_DIRECT_MEMBERS
 - (instancetype)initWithStream: (OFStream <OFReadyForReadingObserving,
 				    OFReadyForWritingObserving> *)stream
 			server: (OFHTTPServer *)server;
-- (bool)parseProlog: (OFString *)line;
-- (bool)parseHeaders: (OFString *)line;
+- (bool)readRequestHeader;
+- (bool)findEndOfRequestHeader: (size_t *)length;
+- (bool)parseRequestHeaderWithLength: (size_t)length;
+- (bool)parseProlog: (const char *)line length: (size_t)length;
+- (bool)parseHeader: (const char *)line length: (size_t)length;
+- (bool)parseHost: (OFString *)value;
 - (bool)sendErrorAndClose: (unsigned short)statusCode;
 - (void)createResponse;
 @end
@@ -128,36 +136,135 @@ OF_DIRECT_MEMBERS
 #ifdef OF_HAVE_THREADS
 OF_DIRECT_MEMBERS
 @interface OFHTTPServerThread: OFThread
+{
+@public
+	OFTCPSocket *_Nullable _listeningSocket;
+}
+
 - (void)stop;
 @end
 #endif
 
 static const size_t maxStringReadLength = 10240;
+static const size_t initialHeaderBufferSize = 1024;
+static const size_t maxQueuedResponseLength = 65536;
+static const size_t maxHeaderBufferSize = 65536;
+
+/*
+ * The Date header only changes once per second, so it is only formatted once
+ * per second and thread. Without compiler support for thread-local storage,
+ * it is formatted for every response if there are threads.
+ */
+#if defined(OF_HAVE_COMPILER_TLS)
+static thread_local char cachedDate[32];
+static thread_local size_t cachedDateLength;
+static thread_local time_t cachedDateTime;
+#elif !defined(OF_HAVE_THREADS)
+static char cachedDate[32];
+static size_t cachedDateLength;
+static time_t cachedDateTime;
+#endif
+
+static const struct {
+	const char *name;
+	OFHTTPRequestMethod method;
+} methods[] = {
+	{ "GET", OFHTTPRequestMethodGet },
+	{ "HEAD", OFHTTPRequestMethodHead },
+	{ "POST", OFHTTPRequestMethodPost },
+	{ "PUT", OFHTTPRequestMethodPut },
+	{ "DELETE", OFHTTPRequestMethodDelete },
+	{ "OPTIONS", OFHTTPRequestMethodOptions },
+	{ "TRACE", OFHTTPRequestMethodTrace },
+	{ "CONNECT", OFHTTPRequestMethodConnect }
+};
+
+/*
+ * Keys of common headers in their normalized form. Using these avoids creating
+ * a new string for every header of every request.
+ */
+static const struct {
+	const char *name;
+	OFString *key;
+} commonHeaders[] = {
+	{ "Host", @"Host" },
+	{ "User-Agent", @"User-Agent" },
+	{ "Accept", @"Accept" },
+	{ "Accept-Encoding", @"Accept-Encoding" },
+	{ "Accept-Language", @"Accept-Language" },
+	{ "Connection", @"Connection" },
+	{ "Content-Length", @"Content-Length" },
+	{ "Content-Type", @"Content-Type" },
+	{ "Transfer-Encoding", @"Transfer-Encoding" },
+	{ "Cookie", @"Cookie" },
+	{ "Referer", @"Referer" },
+	{ "Authorization", @"Authorization" },
+	{ "Cache-Control", @"Cache-Control" },
+	{ "If-Modified-Since", @"If-Modified-Since" },
+	{ "If-None-Match", @"If-None-Match" },
+	{ "Range", @"Range" },
+	{ "Origin", @"Origin" },
+	{ "Upgrade", @"Upgrade" },
+	{ "Pragma", @"Pragma" },
+	{ "Expect", @"Expect" }
+};
+
+static bool
+parseMethod(const char *string, size_t length, OFHTTPRequestMethod *method)
+{
+	for (size_t i = 0; i < sizeof(methods) / sizeof(*methods); i++) {
+		if (strlen(methods[i].name) == length &&
+		    memcmp(methods[i].name, string, length) == 0) {
+			*method = methods[i].method;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool
+isEqualCaseInsensitive(const char *string, size_t length, const char *name)
+{
+	for (size_t i = 0; i < length; i++)
+		if (name[i] == '\0' ||
+		    OFASCIIToLower(string[i]) != OFASCIIToLower(name[i]))
+			return false;
+
+	return (name[length] == '\0');
+}
 
 static OFString *
-normalizedKey(OFString *key)
+normalizedKey(const char *key, size_t length)
 {
-	char *cString = _OFStrDup(key.UTF8String);
-	unsigned char *tmp = (unsigned char *)cString;
+	char *cString;
 	bool firstLetter = true;
 	OFString *ret;
 
-	while (*tmp != '\0') {
-		if (!OFASCIIIsAlpha(*tmp)) {
+	for (size_t i = 0; i < sizeof(commonHeaders) / sizeof(*commonHeaders);
+	    i++)
+		if (isEqualCaseInsensitive(key, length, commonHeaders[i].name))
+			return commonHeaders[i].key;
+
+	cString = OFAllocMemory(length + 1, 1);
+
+	for (size_t i = 0; i < length; i++) {
+		if (!OFASCIIIsAlpha(key[i])) {
+			cString[i] = key[i];
 			firstLetter = true;
-			tmp++;
 			continue;
 		}
 
-		*tmp = (firstLetter
-		    ? OFASCIIToUpper(*tmp) : OFASCIIToLower(*tmp));
+		cString[i] = (firstLetter
+		    ? OFASCIIToUpper(key[i]) : OFASCIIToLower(key[i]));
 
 		firstLetter = false;
-		tmp++;
 	}
+	cString[length] = '\0';
 
 	@try {
 		ret = [OFString stringWithUTF8StringNoCopy: cString
+						    length: length
 					      freeWhenDone: true];
 	} @catch (id e) {
 		OFFreeMemory(cString);
@@ -167,6 +274,46 @@ normalizedKey(OFString *key)
 	return ret;
 }
 
+/* Writes the current date into the buffer and returns its length. */
+static size_t
+currentDate(char buffer[32])
+{
+	time_t now = time(NULL);
+	void *pool;
+	OFString *date;
+	size_t length;
+
+#if defined(OF_HAVE_COMPILER_TLS) || !defined(OF_HAVE_THREADS)
+	if (now == cachedDateTime && cachedDateLength > 0) {
+		memcpy(buffer, cachedDate, cachedDateLength + 1);
+		return cachedDateLength;
+	}
+#endif
+
+	pool = objc_autoreleasePoolPush();
+
+	date = [[OFDate dateWithTimeIntervalSince1970: now]
+	    dateStringWithFormat: @"%a, %d %b %Y %H:%M:%S GMT"];
+	length = date.UTF8StringLength;
+
+	if (length > 31) {
+		objc_autoreleasePoolPop(pool);
+		@throw [OFOutOfRangeException exception];
+	}
+
+	memcpy(buffer, date.UTF8String, length + 1);
+
+	objc_autoreleasePoolPop(pool);
+
+#if defined(OF_HAVE_COMPILER_TLS) || !defined(OF_HAVE_THREADS)
+	memcpy(cachedDate, buffer, length + 1);
+	cachedDateLength = length;
+	cachedDateTime = now;
+#endif
+
+	return length;
+}
+
 static OFArray OF_GENERIC(OFString *) *
 parseTransferEncoding(OFDictionary OF_GENERIC(OFString *, OFString *) *headers)
 {
@@ -208,107 +355,349 @@ parseTransferEncoding(OFDictionary OF_GENERIC(OFString *, OFString *) *headers)
 
 	objc_release(_server);
 	objc_release(_request);
+	objc_release(_queuedData);
+
+	OFFreeMemory(_headerBuffer);
 
 	[super dealloc];
 }
 
-- (void)of_sendHeaders
+/*
+ * Writes as much of the queued data as the client accepts without blocking.
+ *
+ * The queue is only written when the response is written to, as the response
+ * is what is observed for writing when writing to it asynchronously. The
+ * connection has the same file descriptor, so it cannot be observed for
+ * writing at the same time.
+ */
+static void
+flushQueuedData(OFHTTPServerResponse *self)
 {
-	void *pool = objc_autoreleasePoolPush();
-	OFMutableDictionary OF_GENERIC(OFString *, OFString *) *headers;
-	OFCharacterSet *newlineCharacterSet;
-	OFEnumerator *keyEnumerator, *valueEnumerator;
-	OFString *key, *value;
+	size_t length = self->_queuedData.count, bytesWritten = length;
 
-	[_stream writeFormat: @"HTTP/%@ %hu %@\r\n",
-			      self.protocolVersionString, _statusCode,
-			      OFHTTPStatusCodeString(_statusCode)];
+	if (length == 0)
+		return;
 
-	headers = objc_autorelease([_headers mutableCopy]);
+	@try {
+		[self->_stream writeBuffer: self->_queuedData.items
+				    length: length];
+	} @catch (OFWriteFailedException *e) {
+		if (e.errNo != 0 && e.errNo != EWOULDBLOCK && e.errNo != EAGAIN)
+			@throw e;
 
-	if ([headers objectForKey: @"Date"] == nil) {
-		OFString *date = [[OFDate date]
-		    dateStringWithFormat: @"%a, %d %b %Y %H:%M:%S GMT"];
-		[headers setObject: date forKey: @"Date"];
+		bytesWritten = e.bytesWritten;
 	}
 
-	if ([headers objectForKey: @"Server"] == nil) {
-		OFString *name = _server.name;
+	[self->_queuedData removeItemsInRange: OFMakeRange(0, bytesWritten)];
+}
+
+/*
+ * Writes the buffers without blocking and queues whatever the client did not
+ * accept yet. Once something is queued, everything after it is queued as well
+ * to keep the order.
+ */
+static void
+writeOrQueueBuffers(OFHTTPServerResponse *self, const OFStreamBuffer *buffers,
+    size_t count)
+{
+	size_t bytesWritten = 0;
+
+	flushQueuedData(self);
+
+	if (self->_queuedData.count == 0) {
+		@try {
+			[self->_stream writeBuffers: buffers count: count];
+			return;
+		} @catch (OFWriteFailedException *e) {
+			if (e.errNo != 0 && e.errNo != EWOULDBLOCK &&
+			    e.errNo != EAGAIN)
+				@throw e;
 
-		if (name != nil)
-			[headers setObject: name forKey: @"Server"];
+			bytesWritten = e.bytesWritten;
+		}
 	}
 
-	newlineCharacterSet = [OFCharacterSet newlineCharacterSet];
+	if (self->_queuedData == nil)
+		self->_queuedData = [[OFMutableData alloc] init];
 
-	keyEnumerator = [headers keyEnumerator];
-	valueEnumerator = [headers objectEnumerator];
+	for (size_t i = 0; i < count; i++) {
+		if (bytesWritten >= buffers[i].length) {
+			bytesWritten -= buffers[i].length;
+			continue;
+		}
 
+		[self->_queuedData
+		    addItems: (const char *)buffers[i].buffer + bytesWritten
+		       count: buffers[i].length - bytesWritten];
+		bytesWritten = 0;
+	}
+}
+
+/*
+ * Sends the buffers, preceded by the serialized headers if they have not been
+ * sent yet, so that the headers go out together with the first data.
+ */
+static void
+sendBuffers(OFHTTPServerResponse *self, const OFStreamBuffer *buffers,
+    size_t count)
+{
+	OFStreamBuffer allBuffers[4];
+	size_t allCount = 0;
+
+	OFEnsure(count < 4);
+
+	if (self->_headerBuffer != NULL) {
+		allBuffers[allCount].buffer = self->_headerBuffer;
+		allBuffers[allCount++].length = self->_headerLength;
+	}
+
+	for (size_t i = 0; i < count; i++)
+		allBuffers[allCount++] = buffers[i];
+
+	if (allCount == 0)
+		return;
+
+	@try {
+		if (self->_canBlock && self->_queuedData.count == 0)
+			[self->_stream writeBuffers: allBuffers
+					      count: allCount];
+		else
+			writeOrQueueBuffers(self, allBuffers, allCount);
+	} @finally {
+		OFFreeMemory(self->_headerBuffer);
+		self->_headerBuffer = NULL;
+	}
+}
+
+- (void)setHeaders: (OFDictionary OF_GENERIC(OFString *, OFString *) *)headers
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFCharacterSet *newlineCharacterSet =
+	    [OFCharacterSet newlineCharacterSet];
+	OFEnumerator *keyEnumerator = [headers keyEnumerator];
+	OFEnumerator *objectEnumerator = [headers objectEnumerator];
+	OFString *key, *value;
+
+	/* Validated here so that sending the headers does not need to. */
 	while ((key = [keyEnumerator nextObject]) != nil &&
-	    (value = [valueEnumerator nextObject]) != nil) {
+	    (value = [objectEnumerator nextObject]) != nil)
 		if ([key rangeOfCharacterFromSet:
 		    newlineCharacterSet].location != OFNotFound ||
 		    [value rangeOfCharacterFromSet:
 		    newlineCharacterSet].location != OFNotFound)
 			@throw [OFInvalidArgumentException exception];
 
-		[_stream writeFormat: @"%@: %@\r\n", key, value];
+	objc_autoreleasePoolPop(pool);
+
+	[super setHeaders: headers];
+}
+
+- (void)of_serializeHeaders
+{
+	const char *reason = OFHTTPStatusCodeString(_statusCode).UTF8String;
+	size_t reasonLength = strlen(reason);
+	OFString *name = nil;
+	char date[32];
+	size_t dateLength = 0, length, i = 0;
+	OFEnumerator *keyEnumerator, *objectEnumerator;
+	OFString *key, *value;
+
+	if (_statusCode < 100 || _statusCode > 999)
+		@throw [OFInvalidArgumentException exception];
+
+	/* "HTTP/1.x 200 " + reason + CRLF + final CRLF */
+	length = 13 + reasonLength + 4;
+
+	if ([_headers objectForKey: @"Date"] == nil) {
+		dateLength = currentDate(date);
+		length += 8 + dateLength;
 	}
 
-	[_stream writeString: @"\r\n"];
+	if ([_headers objectForKey: @"Server"] == nil &&
+	    (name = _server.name) != nil)
+		length += 10 + name.UTF8StringLength;
 
-	_headersSent = true;
-	_chunked = [parseTransferEncoding(headers) containsObject: @"chunked"];
+	keyEnumerator = [_headers keyEnumerator];
+	objectEnumerator = [_headers objectEnumerator];
+	while ((key = [keyEnumerator nextObject]) != nil &&
+	    (value = [objectEnumerator nextObject]) != nil)
+		length += key.UTF8StringLength + value.UTF8StringLength + 4;
+
+	_headerBuffer = OFAllocMemory(length, 1);
+
+	memcpy(_headerBuffer, "HTTP/1.", 7);
+	_headerBuffer[7] = '0' + _protocolVersion.minor;
+	_headerBuffer[8] = ' ';
+	_headerBuffer[9] = '0' + _statusCode / 100;
+	_headerBuffer[10] = '0' + _statusCode / 10 % 10;
+	_headerBuffer[11] = '0' + _statusCode % 10;
+	_headerBuffer[12] = ' ';
+	i = 13;
+	memcpy(_headerBuffer + i, reason, reasonLength);
+	i += reasonLength;
+	memcpy(_headerBuffer + i, "\r\n", 2);
+	i += 2;
+
+#define APPEND_HEADER(keyString, keyLength, valueString, valueLength)	\
+	memcpy(_headerBuffer + i, keyString, keyLength);		\
+	i += keyLength;							\
+	memcpy(_headerBuffer + i, ": ", 2);				\
+	i += 2;								\
+	memcpy(_headerBuffer + i, valueString, valueLength);		\
+	i += valueLength;						\
+	memcpy(_headerBuffer + i, "\r\n", 2);				\
+	i += 2;
+
+	if (dateLength > 0) {
+		APPEND_HEADER("Date", 4, date, dateLength)
+	}
 
-	objc_autoreleasePoolPop(pool);
+	if (name != nil) {
+		APPEND_HEADER("Server", 6, name.UTF8String,
+		    name.UTF8StringLength)
+	}
+
+	keyEnumerator = [_headers keyEnumerator];
+	objectEnumerator = [_headers objectEnumerator];
+	while ((key = [keyEnumerator nextObject]) != nil &&
+	    (value = [objectEnumerator nextObject]) != nil) {
+		APPEND_HEADER(key.UTF8String, key.UTF8StringLength,
+		    value.UTF8String, value.UTF8StringLength)
+	}
+
+#undef APPEND_HEADER
+
+	memcpy(_headerBuffer + i, "\r\n", 2);
+	i += 2;
+
+	OFEnsure(i == length);
+
+	_headerLength = length;
+	_headersSent = true;
+	_chunked = [parseTransferEncoding(_headers) containsObject: @"chunked"];
 }
 
 - (size_t)lowlevelWriteBuffer: (const void *)buffer length: (size_t)length
 {
-	/* TODO: Use non-blocking writes */
-
-	void *pool;
+	char prefix[sizeof(size_t) * 2 + 2];
+	size_t i, chunkLength;
+	OFStreamBuffer buffers[3];
 
 	if (_stream == nil)
 		@throw [OFNotOpenException exceptionWithObject: self];
 
 	if (!_headersSent)
-		[self of_sendHeaders];
+		[self of_serializeHeaders];
+
+	if (!_canBlock) {
+		/*
+		 * Only accept as much as can be queued, so that a slow client
+		 * cannot make the server buffer unlimited data. The caller is
+		 * asked to try again once the client has read more.
+		 */
+		size_t queuedLength, space = 0;
+
+		flushQueuedData(self);
+		queuedLength = _queuedData.count;
+
+		if (queuedLength < maxQueuedResponseLength)
+			space = maxQueuedResponseLength - queuedLength;
+
+		if (space == 0)
+			@throw [OFWriteFailedException
+			    exceptionWithObject: self
+				requestedLength: length
+				   bytesWritten: 0
+					  errNo: EWOULDBLOCK];
+
+		if (length > space)
+			length = space;
+	}
 
 	if (!_chunked) {
-		@try {
-			[_stream writeBuffer: buffer length: length];
-		} @catch (OFWriteFailedException *e) {
-			if (e.errNo == EWOULDBLOCK || e.errNo == EAGAIN)
-				return e.bytesWritten;
-
-			@throw e;
-		}
+		buffers[0].buffer = buffer;
+		buffers[0].length = length;
+		sendBuffers(self, buffers, 1);
 
 		return length;
 	}
 
-	pool = objc_autoreleasePoolPush();
-	[_stream writeString: [OFString stringWithFormat: @"%zX\r\n", length]];
-	objc_autoreleasePoolPop(pool);
-
-	[_stream writeBuffer: buffer length: length];
-	[_stream writeString: @"\r\n"];
+	/* Write chunk size, data and CRLF at once without copying the data. */
+	i = sizeof(prefix);
+	prefix[--i] = '\n';
+	prefix[--i] = '\r';
+	chunkLength = length;
+	do {
+		prefix[--i] = "0123456789ABCDEF"[chunkLength & 0xF];
+		chunkLength >>= 4;
+	} while (chunkLength > 0);
+
+	buffers[0].buffer = prefix + i;
+	buffers[0].length = sizeof(prefix) - i;
+	buffers[1].buffer = buffer;
+	buffers[1].length = length;
+	buffers[2].buffer = "\r\n";
+	buffers[2].length = 2;
+
+	sendBuffers(self, buffers, 3);
 
 	return length;
 }
 
+- (unsigned long long)writeContentsOfStream: (OFStream *)stream
+				     length: (unsigned long long)length
+{
+	if (_stream == nil)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	if (!_headersSent)
+		[self of_serializeHeaders];
+
+	/*
+	 * Unless the body needs to be framed or queued, write the headers and
+	 * then let the underlying stream transfer the data, so that a socket
+	 * can use sendfile.
+	 */
+	if (_chunked || !_canBlock || _queuedData.count > 0)
+		return [super writeContentsOfStream: stream length: length];
+
+	sendBuffers(self, NULL, 0);
+
+	return [_stream writeContentsOfStream: stream length: length];
+}
+
+- (void)setCanBlock: (bool)canBlock
+{
+	if (_stream == nil)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	_stream.canBlock = canBlock;
+	_canBlock = canBlock;
+}
+
 - (void)close
 {
 	if (_stream == nil)
 		@throw [OFNotOpenException exceptionWithObject: self];
 
 	@try {
-		if (!_headersSent)
-			[self of_sendHeaders];
+		OFStreamBuffer trailer = { "0\r\n\r\n", 5 };
 
-		if (_chunked)
-			[_stream writeString: @"0\r\n\r\n"];
+		if (!_headersSent)
+			[self of_serializeHeaders];
+
+		/* Also sends the headers if nothing was written. */
+		sendBuffers(self, &trailer, (_chunked ? 1 : 0));
+
+		/*
+		 * Nothing writes to the response anymore, so the connection
+		 * takes over what is still queued. This keeps the connection
+		 * open until everything has been written.
+		 */
+		if (_queuedData.count > 0) {
+			[_queuedData makeImmutable];
+			[_stream asyncWriteData: _queuedData];
+		}
 	} @catch (OFWriteFailedException *e) {
 		id <OFHTTPServerDelegate> delegate = _server.delegate;
 		SEL deprecatedSelector = @selector(server:
@@ -367,7 +756,6 @@ parseTransferEncoding(OFDictionary OF_GENERIC(OFString *, OFString *) *headers)
 					  selector: @selector(
 							cancelAsyncRequests)
 					   repeats: false]);
-		_state = stateAwaitingProlog;
 	} @catch (id e) {
 		objc_release(self);
 		@throw e;
@@ -384,6 +772,8 @@ parseTransferEncoding(OFDictionary OF_GENERIC(OFString *, OFString *) *headers)
 	[_timer invalidate];
 	objc_release(_timer);
 
+	OFFreeMemory(_buffer);
+
 	objc_release(_host);
 	objc_release(_path);
 	objc_release(_headers);
@@ -392,11 +782,31 @@ parseTransferEncoding(OFDictionary OF_GENERIC(OFString *, OFString *) *headers)
 	[super dealloc];
 }
 
-- (bool)stream: (OFStream *)stream
-   didReadLine: (OFString *)line
-     exception: (id)exception
+- (bool)readRequestHeader
 {
-	if (line == nil || exception != nil) {
+	if (_bufferLength == _bufferSize) {
+		if (_bufferSize >= maxHeaderBufferSize)
+			return [self sendErrorAndClose: 400];
+
+		_bufferSize = (_bufferSize > 0
+		    ? _bufferSize * 2 : initialHeaderBufferSize);
+		_buffer = OFResizeMemory(_buffer, _bufferSize, 1);
+	}
+
+	[_stream asyncReadIntoBuffer: _buffer + _bufferLength
+			      length: _bufferSize - _bufferLength];
+
+	return false;
+}
+
+-      (bool)stream: (OFStream *)stream
+  didReadIntoBuffer: (void *)buffer
+	     length: (size_t)length
+	  exception: (id)exception
+{
+	size_t headerLength;
+
+	if (exception != nil || (length == 0 && stream.atEndOfStream)) {
 		if ([_server.delegate respondsToSelector:
 		    @selector(server:didEncounterException:request:response:)])
 			[_server.delegate  server: _server
@@ -407,15 +817,13 @@ parseTransferEncoding(OFDictionary OF_GENERIC(OFString *, OFString *) *headers)
 		return false;
 	}
 
+	_bufferLength += length;
+
 	@try {
-		switch (_state) {
-		case stateAwaitingProlog:
-			return [self parseProlog: line];
-		case stateParsingHeaders:
-			return [self parseHeaders: line];
-		default:
-			return false;
-		}
+		if (![self findEndOfRequestHeader: &headerLength])
+			return [self readRequestHeader];
+
+		return [self parseRequestHeaderWithLength: headerLength];
 	} @catch (id e) {
 		if ([_server.delegate respondsToSelector:
 		    @selector(server:didEncounterException:request:response:)])
@@ -426,124 +834,184 @@ parseTransferEncoding(OFDictionary OF_GENERIC(OFString *, OFString *) *headers)
 
 		return false;
 	}
+}
+
+- (bool)findEndOfRequestHeader: (size_t *)length
+{
+	/*
+	 * Only the data that was not scanned before is searched for the end of
+	 * a line, so that each byte is only looked at once no matter how the
+	 * request header is split into reads.
+	 */
+	while (_scannedLength < _bufferLength) {
+		const char *LF = memchr(_buffer + _scannedLength, '\n',
+		    _bufferLength - _scannedLength);
+		size_t lineLength;
+
+		if (LF == NULL) {
+			_scannedLength = _bufferLength;
+			return false;
+		}
+
+		lineLength = LF - _buffer - _lineStart;
+		_scannedLength = _lineStart = LF - _buffer + 1;
+
+		if (lineLength == 0 || (lineLength == 1 && LF[-1] == '\r')) {
+			*length = _scannedLength;
+			return true;
+		}
+
+		_numLines++;
+	}
 
-	OFEnsure(0);
+	return false;
 }
 
-- (bool)parseProlog: (OFString *)line
+- (bool)parseRequestHeaderWithLength: (size_t)length
 {
-	OFString *method;
-	OFMutableString *path;
-	size_t pos;
+	const char *line = _buffer;
+	bool chunked;
+	OFString *contentLengthString;
+	unsigned long long contentLength = 0;
 
-	@try {
-		OFString *version = [line
-		    substringWithRange: OFMakeRange(line.length - 9, 9)];
-		OFUnichar tmp;
+	/* Everything after the header belongs to the body. */
+	[_stream unreadFromBuffer: _buffer + length
+			   length: _bufferLength - length];
 
-		if (![version hasPrefix: @" HTTP/1."])
-			return [self sendErrorAndClose: 505];
+	_headers = [[OFMutableDictionary alloc] initWithCapacity:
+	    (_numLines > 0 ? _numLines - 1 : 0)];
 
-		tmp = [version characterAtIndex: 8];
-		if (tmp < '0' || tmp > '9')
-			return [self sendErrorAndClose: 400];
+	for (size_t i = 0; i < _numLines; i++) {
+		const char *LF = memchr(line, '\n', _buffer + length - line);
+		size_t lineLength = LF - line;
 
-		_HTTPMinorVersion = (uint8_t)(tmp - '0');
-	} @catch (OFOutOfRangeException *e) {
-		return [self sendErrorAndClose: 400];
+		if (lineLength > 0 && line[lineLength - 1] == '\r')
+			lineLength--;
+
+		if (i == 0) {
+			if (![self parseProlog: line length: lineLength])
+				return false;
+		} else if (![self parseHeader: line length: lineLength])
+			return false;
+
+		line = LF + 1;
 	}
 
-	pos = [line rangeOfString: @" "].location;
-	if (pos == OFNotFound)
+	if (_path == nil)
 		return [self sendErrorAndClose: 400];
 
-	method = [line substringToIndex: pos];
-	@try {
-		_method = OFHTTPRequestMethodParseString(method);
-	} @catch (OFInvalidArgumentException *e) {
-		return [self sendErrorAndClose: 405];
-	}
+	OFFreeMemory(_buffer);
+	_buffer = NULL;
+	_bufferSize = _bufferLength = 0;
 
-	@try {
-		OFRange range = OFMakeRange(pos + 1, line.length - pos - 10);
+	chunked = [parseTransferEncoding(_headers) containsObject: @"chunked"];
+	contentLengthString = [_headers objectForKey: @"Content-Length"];
 
-		path = objc_autorelease(
-		    [[line substringWithRange: range] mutableCopy]);
-	} @catch (OFOutOfRangeException *e) {
-		return [self sendErrorAndClose: 400];
+	if (contentLengthString != nil) {
+		if (chunked)
+			return [self sendErrorAndClose: 400];
+
+		@try {
+			contentLength =
+			    contentLengthString.unsignedLongLongValue;
+		} @catch (OFInvalidFormatException *e) {
+			return [self sendErrorAndClose: 400];
+		} @catch (OFOutOfRangeException *e) {
+			return [self sendErrorAndClose: 400];
+		}
 	}
 
-	[path deleteEnclosingWhitespaces];
-	[path makeImmutable];
+	if (chunked || contentLengthString != nil) {
+		objc_release(_requestBody);
+		_requestBody = nil;
 
-	if (![path hasPrefix: @"/"])
-		return [self sendErrorAndClose: 400];
+		@try {
+			_requestBody = [[OFHTTPServerRequestBodyStream alloc]
+			    initWithStream: _stream
+				   chunked: chunked
+			     contentLength: contentLength];
+		} @catch (OFInvalidArgumentException *e) {
+			return [self sendErrorAndClose: 400];
+		} @catch (OFOutOfRangeException *e) {
+			return [self sendErrorAndClose: 400];
+		}
+	}
 
-	_headers = [[OFMutableDictionary alloc] init];
-	_path = [path copy];
-	_state = stateParsingHeaders;
+	[_headers makeImmutable];
+	[self createResponse];
 
-	return true;
+	return false;
 }
 
-- (bool)parseHeaders: (OFString *)line
+- (bool)parseProlog: (const char *)line length: (size_t)length
 {
-	OFString *key, *value, *old;
-	size_t pos;
+	const char *version, *space;
+	size_t pathStart, pathEnd;
 
-	if (line.length == 0) {
-		bool chunked = [parseTransferEncoding(_headers)
-		    containsObject: @"chunked"];
-		OFString *contentLengthString =
-		    [_headers objectForKey: @"Content-Length"];
-		unsigned long long contentLength = 0;
+	if (length < 9)
+		return [self sendErrorAndClose: 400];
 
-		if (contentLengthString != nil) {
-			if (chunked)
-				return [self sendErrorAndClose: 400];
+	version = line + length - 9;
+	if (memcmp(version, " HTTP/1.", 8) != 0)
+		return [self sendErrorAndClose: 505];
 
-			@try {
-				contentLength =
-				    contentLengthString.unsignedLongLongValue;
-			} @catch (OFInvalidFormatException *e) {
-				return [self sendErrorAndClose: 400];
-			} @catch (OFOutOfRangeException *e) {
-				return [self sendErrorAndClose: 400];
-			}
-		}
+	if (version[8] < '0' || version[8] > '9')
+		return [self sendErrorAndClose: 400];
 
-		if (chunked || contentLengthString != nil) {
-			objc_release(_requestBody);
-			_requestBody = nil;
-
-			@try {
-				_requestBody =
-				    [[OFHTTPServerRequestBodyStream alloc]
-				    initWithStream: _stream
-					   chunked: chunked
-				     contentLength: contentLength];
-			} @catch (OFInvalidArgumentException *e) {
-				return [self sendErrorAndClose: 400];
-			} @catch (OFOutOfRangeException *e) {
-				return [self sendErrorAndClose: 400];
-			}
-		}
+	_HTTPMinorVersion = (uint8_t)(version[8] - '0');
+
+	if ((space = memchr(line, ' ', length - 9)) == NULL)
+		return [self sendErrorAndClose: 400];
 
-		_state = stateSendResponse;
-		[self createResponse];
+	if (!parseMethod(line, space - line, &_method))
+		return [self sendErrorAndClose: 405];
 
-		return false;
+	pathStart = space - line + 1;
+	pathEnd = length - 9;
+
+	while (pathStart < pathEnd && OFASCIIIsSpace(line[pathStart]))
+		pathStart++;
+	while (pathEnd > pathStart && OFASCIIIsSpace(line[pathEnd - 1]))
+		pathEnd--;
+
+	if (pathStart == pathEnd || line[pathStart] != '/')
+		return [self sendErrorAndClose: 400];
+
+	@try {
+		_path = [[OFString alloc]
+		    initWithUTF8String: line + pathStart
+				length: pathEnd - pathStart];
+	} @catch (OFInvalidEncodingException *e) {
+		return [self sendErrorAndClose: 400];
 	}
 
-	pos = [line rangeOfString: @":"].location;
-	if (pos == OFNotFound)
+	return true;
+}
+
+- (bool)parseHeader: (const char *)line length: (size_t)length
+{
+	const char *colon = memchr(line, ':', length);
+	size_t keyLength, valueStart;
+	OFString *key, *value, *old;
+
+	if (colon == NULL)
 		return [self sendErrorAndClose: 400];
 
-	key = [line substringToIndex: pos];
-	value = [line substringFromIndex: pos + 1];
+	keyLength = colon - line;
+	while (keyLength > 0 && OFASCIIIsSpace(line[keyLength - 1]))
+		keyLength--;
+
+	valueStart = colon - line + 1;
+	while (valueStart < length && OFASCIIIsSpace(line[valueStart]))
+		valueStart++;
 
-	key = normalizedKey(key.stringByDeletingTrailingWhitespaces);
-	value = value.stringByDeletingLeadingWhitespaces;
+	@try {
+		key = normalizedKey(line, keyLength);
+		value = [OFString stringWithUTF8String: line + valueStart
+						length: length - valueStart];
+	} @catch (OFInvalidEncodingException *e) {
+		return [self sendErrorAndClose: 400];
+	}
 
 	old = [_headers objectForKey: key];
 	if (old != nil)
@@ -551,46 +1019,52 @@ parseTransferEncoding(OFDictionary OF_GENERIC(OFString *, OFString *) *headers)
 
 	[_headers setObject: value forKey: key];
 
-	if ([key isEqual: @"Host"]) {
-		pos = [value rangeOfString: @":"
-				   options: OFStringSearchBackwards].location;
+	if ([key isEqual: @"Host"])
+		return [self parseHost: value];
 
-		if (pos != OFNotFound) {
-			OFString *host = [value substringToIndex: pos];
+	return true;
+}
 
-			if ([host hasPrefix: @"["] && [host hasSuffix: @"]"]) {
-				OFString *IPv6 = [host substringWithRange:
-				    OFMakeRange(1, host.length - 2)];
+- (bool)parseHost: (OFString *)value
+{
+	size_t pos = [value rangeOfString: @":"
+				  options: OFStringSearchBackwards].location;
 
-				if (_OFIRIIsIPv6Host(IPv6))
-					host = IPv6;
+	if (pos != OFNotFound) {
+		OFString *host = [value substringToIndex: pos];
 
-			}
+		if ([host hasPrefix: @"["] && [host hasSuffix: @"]"]) {
+			OFString *IPv6 = [host substringWithRange:
+			    OFMakeRange(1, host.length - 2)];
 
-			objc_release(_host);
-			_host = objc_retain(host);
+			if (_OFIRIIsIPv6Host(IPv6))
+				host = IPv6;
 
-			@try {
-				unsigned short portTmp =
-				    [value substringFromIndex: pos + 1]
-				    .unsignedShortValue;
+		}
+
+		objc_release(_host);
+		_host = objc_retain(host);
+
+		@try {
+			unsigned short portTmp =
+			    [value substringFromIndex: pos + 1]
+			    .unsignedShortValue;
 
 #if USHRT_MAX != 65535
-				if (portTmp > 65535)
-					return [self sendErrorAndClose: 400];
+			if (portTmp > 65535)
+				return [self sendErrorAndClose: 400];
 #endif
 
-				_port = portTmp;
-			} @catch (OFInvalidFormatException *e) {
-				return [self sendErrorAndClose: 400];
-			} @catch (OFOutOfRangeException *e) {
-				return [self sendErrorAndClose: 400];
-			}
-		} else {
-			objc_release(_host);
-			_host = objc_retain(value);
-			_port = 80;
+			_port = portTmp;
+		} @catch (OFInvalidFormatException *e) {
+			return [self sendErrorAndClose: 400];
+		} @catch (OFOutOfRangeException *e) {
+			return [self sendErrorAndClose: 400];
 		}
+	} else {
+		objc_release(_host);
+		_host = objc_retain(value);
+		_port = 80;
 	}
 
 	return true;
@@ -598,10 +1072,12 @@ parseTransferEncoding(OFDictionary OF_GENERIC(OFString *, OFString *) *headers)
 
 - (bool)sendErrorAndClose: (unsigned short)statusCode
 {
-	OFString *date = [[OFDate date]
-	    dateStringWithFormat: @"%a, %d %b %Y %H:%M:%S GMT"];
+	char date[32];
+
+	currentDate(date);
+
 	[_stream writeFormat: @"HTTP/1.1 %hu %@\r\n"
-			      @"Date: %@\r\n"
+			      @"Date: %s\r\n"
 			      @"Server: %@\r\n"
 			      @"\r\n",
 			      statusCode, OFHTTPStatusCodeString(statusCode),
@@ -872,9 +1348,30 @@ parseTransferEncoding(OFDictionary OF_GENERIC(OFString *, OFString *) *headers)
 
 #ifdef OF_HAVE_THREADS
 @implementation OFHTTPServerThread
+- (void)dealloc
+{
+	objc_release(_listeningSocket);
+
+	[super dealloc];
+}
+
 - (void)stop
 {
-	[[OFRunLoop currentRunLoop] stop];
+	if (_listeningSocket != nil) {
+		/*
+		 * The async accept was scheduled in this thread's run loop, so
+		 * it needs to be cancelled from there.
+		 */
+		[_listeningSocket
+		    performSelector: @selector(cancelAsyncRequests)
+			   onThread: self
+		      waitUntilDone: true];
+		[_listeningSocket close];
+		objc_release(_listeningSocket);
+		_listeningSocket = nil;
+	}
+
+	[self.runLoop stop];
 	[self join];
 }
 @end
@@ -959,6 +1456,25 @@ parseTransferEncoding(OFDictionary OF_GENERIC(OFString *, OFString *) *headers)
 {
 	return _numberOfThreads;
 }
+
+- (void)setListensOnAllThreads: (bool)listensOnAllThreads
+{
+	if (_listeningSocket != nil)
+		@throw [OFAlreadyOpenException exceptionWithObject: self];
+
+# ifndef SO_REUSEPORT
+	if (listensOnAllThreads)
+		@throw [OFNotImplementedException exceptionWithSelector: _cmd
+								 object: self];
+# endif
+
+	_listensOnAllThreads = listensOnAllThreads;
+}
+
+- (bool)listensOnAllThreads
+{
+	return _listensOnAllThreads;
+}
 #endif
 
 - (void)setName: (OFString *)name
@@ -979,10 +1495,27 @@ parseTransferEncoding(OFDictionary OF_GENERIC(OFString *, OFString *) *headers)
 	return _name;
 }
 
+- (OFTCPSocket *)of_listeningSocket
+{
+	OFTCPSocket *sock = objc_autorelease([[OFTCPSocket alloc] init]);
+	OFSocketAddress address;
+
+	sock.allowsMPTCP = true;
+#ifdef OF_HAVE_THREADS
+	if (_listensOnAllThreads && _numberOfThreads > 1)
+		sock.reusesPort = true;
+#endif
+
+	address = [sock bindToHost: _host port: _port];
+	_port = OFSocketAddressIPPort(&address);
+	[sock listen];
+
+	return sock;
+}
+
 - (void)start
 {
 	void *pool = objc_autoreleasePoolPush();
-	OFSocketAddress address;
 
 	if (_host == nil)
 		@throw [OFInvalidArgumentException exception];
@@ -990,24 +1523,46 @@ parseTransferEncoding(OFDictionary OF_GENERIC(OFString *, OFString *) *headers)
 	if (_listeningSocket != nil)
 		@throw [OFAlreadyOpenException exceptionWithObject: self];
 
-	_listeningSocket = [[OFTCPSocket alloc] init];
-	_listeningSocket.allowsMPTCP = true;
-	address = [_listeningSocket bindToHost: _host port: _port];
-	_port = OFSocketAddressIPPort(&address);
-	[_listeningSocket listen];
+	_listeningSocket = objc_retain([self of_listeningSocket]);
 
 #ifdef OF_HAVE_THREADS
 	if (_numberOfThreads > 1) {
 		OFMutableArray *threads =
 		    [OFMutableArray arrayWithCapacity: _numberOfThreads - 1];
 
-		for (size_t i = 1; i < _numberOfThreads; i++) {
-			OFHTTPServerThread *thread =
-			    [OFHTTPServerThread thread];
-			thread.supportsSockets = true;
+		/*
+		 * Bind all sockets before starting any thread, so that errors
+		 * are reported to the caller and nothing needs to be stopped.
+		 */
+		@try {
+			for (size_t i = 1; i < _numberOfThreads; i++) {
+				OFHTTPServerThread *thread =
+				    [OFHTTPServerThread thread];
+				thread.supportsSockets = true;
+
+				if (_listensOnAllThreads)
+					thread->_listeningSocket = objc_retain(
+					    [self of_listeningSocket]);
+
+				[threads addObject: thread];
+			}
+		} @catch (id e) {
+			objc_release(_listeningSocket);
+			_listeningSocket = nil;
+
+			@throw e;
+		}
+
+		for (OFHTTPServerThread *thread in threads) {
+			SEL selector = @selector(of_acceptWithSocket:);
 
 			[thread start];
-			[threads addObject: thread];
+
+			if (_listensOnAllThreads)
+				[self performSelector: selector
+					     onThread: thread
+					   withObject: thread->_listeningSocket
+					waitUntilDone: false];
 		}
 
 		[threads makeImmutable];
@@ -1015,8 +1570,7 @@ parseTransferEncoding(OFDictionary OF_GENERIC(OFString *, OFString *) *headers)
 	}
 #endif
 
-	_listeningSocket.delegate = self;
-	[_listeningSocket asyncAccept];
+	[self of_acceptWithSocket: _listeningSocket];
 
 	objc_autoreleasePoolPop(pool);
 }
@@ -1024,6 +1578,7 @@ parseTransferEncoding(OFDictionary OF_GENERIC(OFString *, OFString *) *headers)
 - (void)stop
 {
 	[_listeningSocket cancelAsyncRequests];
+	[_listeningSocket close];
 	objc_release(_listeningSocket);
 	_listeningSocket = nil;
 
@@ -1036,6 +1591,12 @@ parseTransferEncoding(OFDictionary OF_GENERIC(OFString *, OFString *) *headers)
 #endif
 }
 
+- (void)of_acceptWithSocket: (OFTCPSocket *)sock
+{
+	sock.delegate = self;
+	[sock asyncAccept];
+}
+
 - (void)of_startTLSWithSocket: (OFStreamSocket *)sock
 {
 	OFTLSStream *TLSStream = [OFTLSStream streamWithStream: sock];
@@ -1047,11 +1608,13 @@ parseTransferEncoding(OFDictionary OF_GENERIC(OFString *, OFString *) *headers)
 - (void)of_handleStream: (OFStream <OFReadyForReadingObserving,
 			     OFReadyForWritingObserving> *)stream
 {
-	stream.delegate = objc_autorelease(
+	OFHTTPServerConnection *connection = objc_autorelease(
 	    [[OFHTTPServerConnection alloc] initWithStream: stream
 						    server: self]);
+
+	stream.delegate = connection;
 	[stream setMaxStringReadLength: maxStringReadLength];
-	[stream asyncReadLine];
+	[connection readRequestHeader];
 }
 
 -    (bool)socket: (OFStreamSocket *)sock
@@ -1088,7 +1651,7 @@ parseTransferEncoding(OFDictionary OF_GENERIC(OFString *, OFString *) *headers)
 	}
 
 #ifdef OF_HAVE_THREADS
-	if (_numberOfThreads > 1) {
+	if (_numberOfThreads > 1 && !_listensOnAllThreads) {
 		SEL selector = (_usesTLS ? @selector(of_startTLSWithSocket:) :
 		    @selector(of_handleStream:));
 		OFHTTPServerThread *thread =
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2008-2026 Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3.0 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * version 3.0 along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#import "OFObject.h"
+#import "OFHTTPServer.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFHTTPRequest;
+@class OFHTTPResponse;
+@class OFIRI;
+@class OFMutableDictionary OF_GENERIC(KeyType, ObjectType);
+#ifdef OF_HAVE_THREADS
+@class OFMutex;
+#endif
+
+/**
+ * @class OFHTTPStaticFileHandler OFHTTPStaticFileHandler.h ObjFW/ObjFW.h
+ *
+ * @brief A handler for OFHTTPServer that serves the files below a root IRI.
+ *
+ * It can either be used as the delegate of an @ref OFHTTPServer directly or be
+ * called by the delegate for some of the requests using
+ * @ref handleRequest:response:.
+ *
+ * Only `GET` and `HEAD` requests are supported. Conditional requests using
+ * `If-None-Match` and `If-Modified-Since` are answered with 304 Not Modified
+ * and range requests using `Range` and `If-Range` are supported, including
+ * multiple ranges. The attributes of the served files are cached for
+ * @ref attributesCacheTimeout seconds.
+ *
+ * The body is written using @ref OFStream#writeContentsOfStream:length:, which
+ * means that files are sent by the kernel using `sendfile` where possible, as
+ * long as the response can block.
+ */
+OF_SUBCLASSING_RESTRICTED
+@interface OFHTTPStaticFileHandler: OFObject <OFHTTPServerDelegate>
+{
+	OFIRI *_rootIRI;
+	OFTimeInterval _attributesCacheTimeout;
+	OFMutableDictionary *_attributesCache;
+#ifdef OF_HAVE_THREADS
+	OFMutex *_attributesCacheMutex;
+#endif
+}
+
+/**
+ * @brief The IRI of the directory whose files are served.
+ */
+@property (readonly, nonatomic) OFIRI *rootIRI;
+
+/**
+ * @brief The number of seconds the attributes of a file are cached.
+ *
+ * The default is 1 second. Setting this to 0 disables the cache.
+ */
+@property (nonatomic) OFTimeInterval attributesCacheTimeout;
+
+/**
+ * @brief Creates a new static file handler serving the files below the
+ *	  specified IRI.
+ *
+ * @param rootIRI The IRI of the directory whose files should be served
+ * @return A new, autoreleased OFHTTPStaticFileHandler
+ */
++ (instancetype)handlerWithRootIRI: (OFIRI *)rootIRI;
+
+- (instancetype)init OF_UNAVAILABLE;
+
+/**
+ * @brief Initializes an already allocated static file handler to serve the
+ *	  files below the specified IRI.
+ *
+ * @param rootIRI The IRI of the directory whose files should be served
+ * @return An initialized OFHTTPStaticFileHandler
+ */
+- (instancetype)initWithRootIRI: (OFIRI *)rootIRI OF_DESIGNATED_INITIALIZER;
+
+/**
+ * @brief Answers the specified request with the file the path of the request
+ *	  refers to and closes the response.
+ *
+ * @param request The request to answer
+ * @param response The response to write the file to
+ */
+- (void)handleRequest: (OFHTTPRequest *)request
+	     response: (OFHTTPResponse *)response;
+@end
+
+OF_ASSUME_NONNULL_END
@@ -0,0 +1,633 @@
+/*
+ * Copyright (c) 2008-2026 Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3.0 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * version 3.0 along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <limits.h>
+#include <string.h>
+
+#import "OFHTTPStaticFileHandler.h"
+#import "OFArray.h"
+#import "OFDate.h"
+#import "OFDictionary.h"
+#import "OFFileManager.h"
+#import "OFHTTPRequest.h"
+#import "OFHTTPResponse.h"
+#import "OFIRI.h"
+#import "OFIRIHandler.h"
+#import "OFPair.h"
+#import "OFSeekableStream.h"
+#import "OFString.h"
+#ifdef OF_HAVE_THREADS
+# import "OFMutex.h"
+#endif
+
+#import "OFGetItemAttributesFailedException.h"
+#import "OFInvalidFormatException.h"
+#import "OFOpenItemFailedException.h"
+
+#define maxRanges 16
+#define maxAttributesCacheEntries 1024
+
+static OFConstantString *const dateFormat = @"%a, %d %b %Y %H:%M:%S GMT";
+
+struct Range {
+	unsigned long long first, last;
+};
+
+static const struct {
+	const char *extension;
+	OFString *contentType;
+} contentTypes[] = {
+	{ "css",   @"text/css; charset=UTF-8" },
+	{ "gif",   @"image/gif" },
+	{ "htm",   @"text/html; charset=UTF-8" },
+	{ "html",  @"text/html; charset=UTF-8" },
+	{ "ico",   @"image/vnd.microsoft.icon" },
+	{ "jpeg",  @"image/jpeg" },
+	{ "jpg",   @"image/jpeg" },
+	{ "js",    @"text/javascript; charset=UTF-8" },
+	{ "json",  @"application/json" },
+	{ "mp4",   @"video/mp4" },
+	{ "pdf",   @"application/pdf" },
+	{ "png",   @"image/png" },
+	{ "svg",   @"image/svg+xml" },
+	{ "txt",   @"text/plain; charset=UTF-8" },
+	{ "wasm",  @"application/wasm" },
+	{ "webp",  @"image/webp" },
+	{ "woff2", @"font/woff2" },
+	{ "xml",   @"application/xml" }
+};
+
+static OFString *
+contentTypeForIRI(OFIRI *IRI)
+{
+	const char *extension =
+	    IRI.pathExtension.lowercaseString.UTF8String;
+
+	for (size_t i = 0; i < sizeof(contentTypes) / sizeof(*contentTypes);
+	    i++)
+		if (strcmp(extension, contentTypes[i].extension) == 0)
+			return contentTypes[i].contentType;
+
+	return @"application/octet-stream";
+}
+
+static bool
+parseNumber(const char **cursor, unsigned long long *number)
+{
+	const char *string = *cursor;
+	unsigned long long value = 0;
+
+	if (*string < '0' || *string > '9')
+		return false;
+
+	while (*string >= '0' && *string <= '9') {
+		unsigned char digit = *string++ - '0';
+
+		if (value > (ULLONG_MAX - digit) / 10)
+			return false;
+
+		value = value * 10 + digit;
+	}
+
+	*cursor = string;
+	*number = value;
+
+	return true;
+}
+
+/*
+ * Returns the number of satisfiable ranges or 0 if the header should be
+ * ignored, in which case unsatisfiable is set if the header was valid but none
+ * of the ranges could be satisfied.
+ */
+static size_t
+parseRanges(OFString *header, unsigned long long size, struct Range *ranges,
+    bool *unsatisfiable)
+{
+	const char *cursor = header.UTF8String;
+	size_t count = 0;
+
+	*unsatisfiable = false;
+
+	if (strncmp(cursor, "bytes=", 6) != 0)
+		return 0;
+	cursor += 6;
+
+	for (;;) {
+		unsigned long long first, last;
+		bool hasFirst, hasLast;
+
+		while (*cursor == ' ' || *cursor == '\t')
+			cursor++;
+
+		hasFirst = parseNumber(&cursor, &first);
+		if (*cursor != '-')
+			return 0;
+		cursor++;
+		hasLast = parseNumber(&cursor, &last);
+
+		while (*cursor == ' ' || *cursor == '\t')
+			cursor++;
+
+		if (*cursor != ',' && *cursor != '\0')
+			return 0;
+
+		if (!hasFirst) {
+			/* Suffix range: The last bytes of the file. */
+			if (!hasLast)
+				return 0;
+
+			if (last > size)
+				last = size;
+
+			first = size - last;
+			last = size - 1;
+		} else {
+			if (hasLast && last < first)
+				return 0;
+
+			if (!hasLast || last >= size)
+				last = size - 1;
+		}
+
+		/* Otherwise, the range is unsatisfiable and skipped. */
+		if (size > 0 && first < size) {
+			if (count == maxRanges)
+				return 0;
+
+			ranges[count].first = first;
+			ranges[count].last = last;
+			count++;
+		}
+
+		if (*cursor == '\0')
+			break;
+
+		cursor++;
+	}
+
+	if (count == 0)
+		*unsatisfiable = true;
+
+	return count;
+}
+
+static bool
+matchesETag(OFString *header, OFString *ETag)
+{
+	void *pool;
+	bool matches = false;
+
+	if ([header isEqual: @"*"])
+		return true;
+
+	pool = objc_autoreleasePoolPush();
+
+	for (OFString *tag in [header componentsSeparatedByString: @","]) {
+		tag = tag.stringByDeletingEnclosingWhitespaces;
+
+		/* If-None-Match uses the weak comparison. */
+		if ([tag hasPrefix: @"W/"])
+			tag = [tag substringFromIndex: 2];
+
+		if ([tag isEqual: ETag]) {
+			matches = true;
+			break;
+		}
+	}
+
+	objc_autoreleasePoolPop(pool);
+
+	return matches;
+}
+
+static bool
+isNotModified(OFHTTPRequest *request, OFString *ETag, OFDate *modificationDate)
+{
+	OFDictionary OF_GENERIC(OFString *, OFString *) *headers =
+	    request.headers;
+	OFString *header;
+	OFDate *date;
+
+	if ((header = [headers objectForKey: @"If-None-Match"]) != nil)
+		return matchesETag(header, ETag);
+
+	if ((header = [headers objectForKey: @"If-Modified-Since"]) == nil)
+		return false;
+
+	@try {
+		date = [OFDate dateWithDateString: header format: dateFormat];
+	} @catch (OFInvalidFormatException *e) {
+		return false;
+	}
+
+	/* HTTP dates only have a resolution of seconds. */
+	return ((long long)modificationDate.timeIntervalSince1970 <=
+	    (long long)date.timeIntervalSince1970);
+}
+
+static void
+closeWithStatusCode(OFHTTPResponse *response, unsigned short statusCode,
+    OFMutableDictionary *headers)
+{
+	if ([headers objectForKey: @"Content-Length"] == nil)
+		[headers setObject: @"0" forKey: @"Content-Length"];
+
+	response.statusCode = statusCode;
+	response.headers = headers;
+	[response close];
+}
+
+static OFString *
+ETagForFile(unsigned long long size, OFDate *modificationDate)
+{
+	return [OFString stringWithFormat: @"\"%llx-%llx\"", size,
+	    (unsigned long long)
+	    (modificationDate.timeIntervalSince1970 * 1000000)];
+}
+
+/* Returns whether the whole range could be written. */
+static bool
+writeRange(OFHTTPResponse *response, OFStream *file, struct Range range)
+{
+	unsigned long long length = range.last - range.first + 1;
+
+	[(OFSeekableStream *)file seekToOffset: (OFStreamOffset)range.first
+					whence: OFSeekSet];
+
+	return ([response writeContentsOfStream: file
+					 length: length] == length);
+}
+
+@implementation OFHTTPStaticFileHandler
+@synthesize rootIRI = _rootIRI;
+@synthesize attributesCacheTimeout = _attributesCacheTimeout;
+
++ (instancetype)handlerWithRootIRI: (OFIRI *)rootIRI
+{
+	return objc_autoreleaseReturnValue(
+	    [[self alloc] initWithRootIRI: rootIRI]);
+}
+
+- (instancetype)init
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithRootIRI: (OFIRI *)rootIRI
+{
+	self = [super init];
+
+	@try {
+		_rootIRI = [rootIRI copy];
+		_attributesCacheTimeout = 1;
+		_attributesCache = [[OFMutableDictionary alloc] init];
+#ifdef OF_HAVE_THREADS
+		_attributesCacheMutex = [[OFMutex alloc] init];
+#endif
+	} @catch (id e) {
+		objc_release(self);
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	objc_release(_rootIRI);
+	objc_release(_attributesCache);
+#ifdef OF_HAVE_THREADS
+	objc_release(_attributesCacheMutex);
+#endif
+
+	[super dealloc];
+}
+
+static OFIRI *
+IRIForRequest(OFHTTPStaticFileHandler *self, OFHTTPRequest *request)
+{
+	OFIRI *IRI = self->_rootIRI;
+
+	for (OFString *component in request.IRI.pathComponents) {
+		if ([component isEqual: @"/"] || component.length == 0 ||
+		    [component isEqual: @"."])
+			continue;
+
+		/* Never leave the root. */
+		if ([component isEqual: @".."] ||
+		    [component containsString: @"/"] ||
+		    [component containsString: @"\\"])
+			return nil;
+
+		IRI = [IRI IRIByAppendingPathComponent: component];
+	}
+
+	return IRI;
+}
+
+static OFFileAttributes
+attributesOfItemAtIRI(OFHTTPStaticFileHandler *self, OFIRI *IRI)
+{
+	OFTimeInterval timeout = self->_attributesCacheTimeout;
+	OFFileAttributes attributes = nil;
+	OFPair *entry;
+
+	if (timeout > 0) {
+#ifdef OF_HAVE_THREADS
+		[self->_attributesCacheMutex lock];
+		@try {
+#endif
+			entry = [self->_attributesCache objectForKey: IRI];
+
+			if (entry != nil &&
+			    -[entry.secondObject timeIntervalSinceNow] <
+			    timeout)
+				attributes = objc_autorelease(
+				    objc_retain(entry.firstObject));
+#ifdef OF_HAVE_THREADS
+		} @finally {
+			[self->_attributesCacheMutex unlock];
+		}
+#endif
+
+		if (attributes != nil)
+			return attributes;
+	}
+
+	attributes = [[OFFileManager defaultManager]
+	    attributesOfItemAtIRI: IRI];
+
+	if (timeout > 0) {
+		entry = [OFPair pairWithFirstObject: attributes
+				       secondObject: [OFDate date]];
+
+#ifdef OF_HAVE_THREADS
+		[self->_attributesCacheMutex lock];
+		@try {
+#endif
+			/* Keep the cache bounded when serving many files. */
+			if (self->_attributesCache.count >=
+			    maxAttributesCacheEntries)
+				[self->_attributesCache removeAllObjects];
+
+			[self->_attributesCache setObject: entry forKey: IRI];
+#ifdef OF_HAVE_THREADS
+		} @finally {
+			[self->_attributesCacheMutex unlock];
+		}
+#endif
+	}
+
+	return attributes;
+}
+
+- (void)handleRequest: (OFHTTPRequest *)request
+	     response: (OFHTTPResponse *)response
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFMutableDictionary *headers = [OFMutableDictionary dictionary];
+	OFHTTPRequestMethod method = request.method;
+	OFIRI *IRI;
+	OFFileAttributes attributes;
+	unsigned long long size;
+	OFDate *modificationDate;
+	OFString *ETag, *lastModified, *contentType, *header;
+	struct Range ranges[maxRanges];
+	size_t rangesCount = 0;
+	OFStream *file;
+	bool complete = true;
+
+	if (method != OFHTTPRequestMethodGet &&
+	    method != OFHTTPRequestMethodHead) {
+		[headers setObject: @"GET, HEAD" forKey: @"Allow"];
+		closeWithStatusCode(response, 405, headers);
+		objc_autoreleasePoolPop(pool);
+		return;
+	}
+
+	if ((IRI = IRIForRequest(self, request)) == nil) {
+		closeWithStatusCode(response, 404, headers);
+		objc_autoreleasePoolPop(pool);
+		return;
+	}
+
+	/*
+	 * For GET, the size is refreshed from the opened file below. A HEAD
+	 * response only consists of the attributes, so it bypasses the cache.
+	 */
+	@try {
+		if (method == OFHTTPRequestMethodHead)
+			attributes = [[OFFileManager defaultManager]
+			    attributesOfItemAtIRI: IRI];
+		else
+			attributes = attributesOfItemAtIRI(self, IRI);
+	} @catch (OFGetItemAttributesFailedException *e) {
+		attributes = nil;
+	}
+
+	if (attributes == nil ||
+	    ![attributes.fileType isEqual: OFFileTypeRegular]) {
+		closeWithStatusCode(response, 404, headers);
+		objc_autoreleasePoolPop(pool);
+		return;
+	}
+
+	size = attributes.fileSize;
+	modificationDate = attributes.fileModificationDate;
+	ETag = ETagForFile(size, modificationDate);
+	lastModified = [modificationDate dateStringWithFormat: dateFormat];
+
+	[headers setObject: ETag forKey: @"ETag"];
+	[headers setObject: lastModified forKey: @"Last-Modified"];
+	[headers setObject: @"bytes" forKey: @"Accept-Ranges"];
+
+	if (isNotModified(request, ETag, modificationDate)) {
+		response.statusCode = 304;
+		response.headers = headers;
+		[response close];
+		objc_autoreleasePoolPop(pool);
+		return;
+	}
+
+	if (method == OFHTTPRequestMethodHead) {
+		[headers setObject: contentTypeForIRI(IRI)
+			    forKey: @"Content-Type"];
+		[headers setObject: [OFString stringWithFormat: @"%llu", size]
+			    forKey: @"Content-Length"];
+		closeWithStatusCode(response, 200, headers);
+		objc_autoreleasePoolPop(pool);
+		return;
+	}
+
+	@try {
+		file = [OFIRIHandler openItemAtIRI: IRI mode: @"r"];
+	} @catch (OFOpenItemFailedException *e) {
+		closeWithStatusCode(response, 404, headers);
+		objc_autoreleasePoolPop(pool);
+		return;
+	}
+
+	/*
+	 * The attributes might be cached and the file might have changed
+	 * since, so the size is taken from the opened file.
+	 */
+	if ([file isKindOfClass: [OFSeekableStream class]]) {
+		OFSeekableStream *seekableFile = (OFSeekableStream *)file;
+		unsigned long long fileSize;
+
+		@try {
+			fileSize = [seekableFile seekToOffset: 0
+						       whence: OFSeekEnd];
+			[seekableFile seekToOffset: 0 whence: OFSeekSet];
+		} @catch (id e) {
+			[file close];
+			@throw e;
+		}
+
+		if (fileSize != size) {
+			size = fileSize;
+			ETag = ETagForFile(size, modificationDate);
+			[headers setObject: ETag forKey: @"ETag"];
+		}
+	}
+
+	/* A stale If-Range means the whole file has to be sent. */
+	if ((header = [request.headers objectForKey: @"Range"]) != nil &&
+	    [file isKindOfClass: [OFSeekableStream class]]) {
+		OFString *ifRange =
+		    [request.headers objectForKey: @"If-Range"];
+
+		if (ifRange == nil || [ifRange isEqual: ETag] ||
+		    [ifRange isEqual: lastModified]) {
+			bool unsatisfiable;
+
+			rangesCount = parseRanges(header, size, ranges,
+			    &unsatisfiable);
+
+			if (unsatisfiable) {
+				[headers setObject: [OFString stringWithFormat:
+				    @"bytes */%llu", size]
+					    forKey: @"Content-Range"];
+				closeWithStatusCode(response, 416, headers);
+				[file close];
+				objc_autoreleasePoolPop(pool);
+				return;
+			}
+		}
+	}
+
+	contentType = contentTypeForIRI(IRI);
+
+	@try {
+		if (rangesCount == 0) {
+			[headers setObject: contentType
+				    forKey: @"Content-Type"];
+			[headers setObject: [OFString stringWithFormat:
+			    @"%llu", size]
+				    forKey: @"Content-Length"];
+
+			response.statusCode = 200;
+			response.headers = headers;
+			complete = ([response
+			    writeContentsOfStream: file
+					   length: size] == size);
+		} else if (rangesCount == 1) {
+			[headers setObject: contentType
+				    forKey: @"Content-Type"];
+			[headers setObject: [OFString stringWithFormat:
+			    @"%llu", ranges[0].last - ranges[0].first + 1]
+				    forKey: @"Content-Length"];
+			[headers setObject: [OFString stringWithFormat:
+			    @"bytes %llu-%llu/%llu",
+			    ranges[0].first, ranges[0].last, size]
+				    forKey: @"Content-Range"];
+
+			response.statusCode = 206;
+			response.headers = headers;
+			complete = writeRange(response, file, ranges[0]);
+		} else {
+			OFString *boundary = [OFString stringWithFormat:
+			    @"%016llx", (unsigned long long)OFRandom64()];
+			OFMutableArray *partHeaders = [OFMutableArray array];
+			unsigned long long length;
+
+			/* The length has to be known before writing. */
+			length = boundary.UTF8StringLength + 8;
+			for (size_t i = 0; i < rangesCount; i++) {
+				OFString *partHeader = [OFString
+				    stringWithFormat: @"\r\n--%@\r\n"
+						      @"Content-Type: %@\r\n"
+						      @"Content-Range: bytes "
+						      @"%llu-%llu/%llu\r\n\r\n",
+						      boundary, contentType,
+						      ranges[i].first,
+						      ranges[i].last, size];
+
+				[partHeaders addObject: partHeader];
+				length += partHeader.UTF8StringLength;
+				length += ranges[i].last - ranges[i].first + 1;
+			}
+
+			[headers setObject: [OFString stringWithFormat:
+			    @"multipart/byteranges; boundary=%@", boundary]
+				    forKey: @"Content-Type"];
+			[headers setObject: [OFString stringWithFormat:
+			    @"%llu", length]
+				    forKey: @"Content-Length"];
+
+			response.statusCode = 206;
+			response.headers = headers;
+
+			for (size_t i = 0; i < rangesCount && complete; i++) {
+				[response writeString:
+				    [partHeaders objectAtIndex: i]];
+				complete = writeRange(response, file,
+				    ranges[i]);
+			}
+
+			if (complete)
+				[response writeFormat: @"\r\n--%@--\r\n",
+						       boundary];
+		}
+	} @finally {
+		[file close];
+	}
+
+	/*
+	 * If the file was truncated while it was sent, nothing more is
+	 * written. Connections are not reused, so closing the response closes
+	 * the connection before the announced Content-Length was reached,
+	 * which tells the client that the body is incomplete.
+	 */
+	[response close];
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (void)server: (OFHTTPServer *)server
+    didReceiveRequest: (OFHTTPRequest *)request
+	  requestBody: (OFStream *)requestBody
+	     response: (OFHTTPResponse *)response
+{
+	[self handleRequest: request response: response];
+}
+@end
@@ -27,6 +27,7 @@ OF_ASSUME_NONNULL_BEGIN
 @class OFArray OF_GENERIC(ObjectType);
 @class OFData;
 @class OFDate;
+@class OFDirectoryEnumerator;
 @class OFIRI;
 @class OFIRIHandler;
 @class OFStream;
@@ -342,6 +343,31 @@ OF_ASSUME_NONNULL_BEGIN
  */
 - (OFArray OF_GENERIC(OFIRI *) *)contentsOfDirectoryAtIRI: (OFIRI *)IRI;
 
+/**
+ * @brief Returns an enumerator for the items in the specified directory.
+ *
+ * The default implementation returns an @ref OFDirectoryEnumerator that uses
+ * @ref contentsOfDirectoryAtIRI: and @ref attributesOfItemAtIRI:. Handlers can
+ * override this to return an enumerator that reads the directory as it is
+ * being enumerated.
+ *
+ * @note `.` and `..` are not enumerated.
+ *
+ * @param IRI The IRI to the directory whose items should be enumerated
+ * @param options The options for the enumeration
+ * @param attributeKeys The keys of the attributes to retrieve for each item,
+ *			or `nil` if only the type should be retrieved
+ * @return An enumerator for the items in the specified directory
+ * @throw OFOpenItemFailedException Opening the directory failed
+ * @throw OFUnsupportedProtocolException The handler cannot handle the IRI's
+ *					 scheme
+ */
+- (OFDirectoryEnumerator *)
+    enumeratorAtIRI: (OFIRI *)IRI
+	    options: (OFDirectoryEnumeratorOptions)options
+      attributeKeys: (nullable OFArray OF_GENERIC(OFFileAttributeKey) *)
+			 attributeKeys;
+
 /**
  * @brief Removes the item at the specified IRI.
  *
@@ -21,6 +21,7 @@
 
 #import "OFIRIHandler.h"
 #import "OFDictionary.h"
+#import "OFDirectoryEnumerator.h"
 #import "OFIRI.h"
 #import "OFNumber.h"
 
@@ -202,6 +203,16 @@ static OFMutableDictionary OF_GENERIC(OFString *, OFIRIHandler *) *handlers;
 	OF_UNRECOGNIZED_SELECTOR
 }
 
+- (OFDirectoryEnumerator *)
+    enumeratorAtIRI: (OFIRI *)IRI
+	    options: (OFDirectoryEnumeratorOptions)options
+      attributeKeys: (OFArray OF_GENERIC(OFFileAttributeKey) *)attributeKeys
+{
+	return [OFDirectoryEnumerator enumeratorWithIRI: IRI
+						options: options
+					  attributeKeys: attributeKeys];
+}
+
 - (void)removeItemAtIRI: (OFIRI *)IRI
 {
 	OF_UNRECOGNIZED_SELECTOR
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2008-2026 Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3.0 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * version 3.0 along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#import "OFKernelEventObserver.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+OF_DIRECT_MEMBERS
+@interface OFKernelEventObserver ()
+- (void)of_scheduleReadBufferCheckForStream: (OFStream *)stream;
+
+/*
+ * Only do the read buffer bookkeeping for an object. Used by subclasses that
+ * keep their own tables of observed objects instead of calling super.
+ */
+- (void)of_observeReadBufferOfObject: (id)object;
+- (void)of_stopObservingReadBufferOfObject: (id)object;
+@end
+
+OF_ASSUME_NONNULL_END
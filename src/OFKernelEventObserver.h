@@ -33,6 +33,7 @@ OF_ASSUME_NONNULL_BEGIN
 @class OFMutableArray OF_GENERIC(ObjectType);
 @class OFDate;
 @class OFMutableData;
+@class OFStream;
 
 /**
  * @protocol OFKernelEventObserverDelegate OFKernelEventObserver.h ObjFW/ObjFW.h
@@ -119,6 +120,10 @@ OF_ASSUME_NONNULL_BEGIN
 	OFMutableArray OF_GENERIC(id <OFReadyForWritingObserving>)
 	    *_writeObjects;
 	id <OFKernelEventObserverDelegate> _Nullable _delegate;
+	OFMutableArray OF_GENERIC(OFStream *) *_readBufferStreams;
+	OFMutableArray OF_GENERIC(OFStream *) *_Nullable
+	    _spareReadBufferStreams;
+	OFMutableArray OF_GENERIC(OFStream *) *_sharedReadStreams;
 # if defined(OF_AMIGAOS)
 	struct Task *_waitingTask;
 	ULONG _cancelSignal;
@@ -131,7 +136,7 @@ OF_ASSUME_NONNULL_BEGIN
 # ifdef OF_AMIGAOS
 	ULONG _execSignalMask;
 # endif
-	OF_RESERVE_IVARS(OFKernelEventObserver, 4)
+	OF_RESERVE_IVARS(OFKernelEventObserver, 1)
 }
 
 /**
@@ -22,6 +22,7 @@
 #include <errno.h>
 
 #import "OFKernelEventObserver.h"
+#import "OFKernelEventObserver+Private.h"
 #import "OFArray.h"
 #import "OFData.h"
 #import "OFDate.h"
@@ -110,6 +111,9 @@
 
 		_readObjects = [[OFMutableArray alloc] init];
 		_writeObjects = [[OFMutableArray alloc] init];
+		_readBufferStreams = [[OFMutableArray alloc] init];
+		_spareReadBufferStreams = [[OFMutableArray alloc] init];
+		_sharedReadStreams = [[OFMutableArray alloc] init];
 
 #if defined(OF_HAVE_PIPE) && !defined(OF_AMIGAOS)
 		if (pipe(_cancelFD))
@@ -182,8 +186,24 @@
 		closesocket(_cancelFD[1]);
 #endif
 
+	for (id object in _readObjects) {
+		OFStream *stream;
+
+		if (![object isKindOfClass: [OFStream class]])
+			continue;
+
+		stream = object;
+		if (stream.of_readBufferObserver == self) {
+			stream.of_readBufferObserver = nil;
+			stream.of_readBufferCheckPending = false;
+		}
+	}
+
 	objc_release(_readObjects);
 	objc_release(_writeObjects);
+	objc_release(_readBufferStreams);
+	objc_release(_spareReadBufferStreams);
+	objc_release(_sharedReadStreams);
 
 	[super dealloc];
 }
@@ -191,6 +211,7 @@
 - (void)addObjectForReading: (id <OFReadyForReadingObserving>)object
 {
 	[_readObjects addObject: object];
+	[self of_observeReadBufferOfObject: object];
 }
 
 - (void)addObjectForWriting: (id <OFReadyForWritingObserving>)object
@@ -201,6 +222,7 @@
 - (void)removeObjectForReading: (id <OFReadyForReadingObserving>)object
 {
 	[_readObjects removeObjectIdenticalTo: object];
+	[self of_stopObservingReadBufferOfObject: object];
 }
 
 - (void)removeObjectForWriting: (id <OFReadyForWritingObserving>)object
@@ -208,33 +230,142 @@
 	[_writeObjects removeObjectIdenticalTo: object];
 }
 
+- (void)of_observeReadBufferOfObject: (id)object
+{
+	OFStream *stream;
+
+	if (![object isKindOfClass: [OFStream class]])
+		return;
+
+	stream = object;
+
+	if (stream.of_readBufferObserver == nil) {
+		stream.of_readBufferObserver = self;
+		/* It might already have data in its read buffer. */
+		[self of_scheduleReadBufferCheckForStream: stream];
+	} else if (stream.of_readBufferObserver != self)
+		/*
+		 * Another observer is already notified about the read buffer
+		 * of this stream, so we need to check it on every iteration.
+		 */
+		[_sharedReadStreams addObject: stream];
+}
+
+- (void)of_stopObservingReadBufferOfObject: (id)object
+{
+	OFStream *stream;
+
+	if (![object isKindOfClass: [OFStream class]])
+		return;
+
+	stream = object;
+
+	if (stream.of_readBufferObserver == self) {
+		if (stream.of_readBufferCheckPending) {
+			[_readBufferStreams removeObjectIdenticalTo: stream];
+			stream.of_readBufferCheckPending = false;
+		}
+
+		stream.of_readBufferObserver = nil;
+	} else
+		[_sharedReadStreams removeObjectIdenticalTo: stream];
+}
+
+- (void)of_scheduleReadBufferCheckForStream: (OFStream *)stream
+{
+	if (stream.of_readBufferCheckPending)
+		return;
+
+	[_readBufferStreams addObject: stream];
+	stream.of_readBufferCheckPending = true;
+}
+
+static bool
+processReadBuffer(OFKernelEventObserver *self, OFStream *stream)
+{
+	void *pool;
+
+	if (!stream.hasDataInReadBuffer || (stream.of_waitingForDelimiter &&
+	    ![stream lowlevelHasDataInReadBuffer]))
+		return false;
+
+	pool = objc_autoreleasePoolPush();
+
+	if ([self->_delegate respondsToSelector:
+	    @selector(objectIsReadyForReading:)])
+		[self->_delegate objectIsReadyForReading: stream];
+
+	objc_autoreleasePoolPop(pool);
+
+	return true;
+}
+
 - (bool)processReadBuffers
 {
-	void *pool = objc_autoreleasePoolPush();
+	OFMutableArray *streams;
 	bool foundInReadBuffer = false;
 
-	for (OFStream *stream in objc_autorelease([_readObjects copy])) {
-		void *pool2;
+	if (_readBufferStreams.count == 0 && _sharedReadStreams.count == 0)
+		return false;
 
-		if (![stream isKindOfClass: [OFStream class]])
-			continue;
+	/*
+	 * Swap the list, as the delegate might read from the streams and thus
+	 * schedule them for the next check again. If this is a nested call,
+	 * the spare list is in use and a new one is needed.
+	 */
+	streams = _readBufferStreams;
+	if (_spareReadBufferStreams != nil) {
+		_readBufferStreams = _spareReadBufferStreams;
+		_spareReadBufferStreams = nil;
+	} else
+		_readBufferStreams = [[OFMutableArray alloc] init];
+
+	for (OFStream *stream in streams)
+		stream.of_readBufferCheckPending = false;
+
+	@try {
+		for (OFStream *stream in streams) {
+			/* Might have been removed by the delegate. */
+			if (stream.of_readBufferObserver != self)
+				continue;
+
+			if (processReadBuffer(self, stream)) {
+				/*
+				 * Check again in the next iteration, in case
+				 * the delegate did not consume everything.
+				 */
+				[self of_scheduleReadBufferCheckForStream:
+				    stream];
+				foundInReadBuffer = true;
+			}
+		}
 
-		pool2 = objc_autoreleasePoolPush();
+		if (_sharedReadStreams.count > 0) {
+			void *pool = objc_autoreleasePoolPush();
 
-		if (stream.hasDataInReadBuffer &&
-		    (!stream.of_waitingForDelimiter ||
-		    [stream lowlevelHasDataInReadBuffer])) {
-			if ([_delegate respondsToSelector:
-			    @selector(objectIsReadyForReading:)])
-				[_delegate objectIsReadyForReading: stream];
+			for (OFStream *stream in
+			    objc_autorelease([_sharedReadStreams copy]))
+				if (processReadBuffer(self, stream))
+					foundInReadBuffer = true;
 
-			foundInReadBuffer = true;
+			objc_autoreleasePoolPop(pool);
 		}
+	} @catch (id e) {
+		/* Don't lose the streams that have not been checked yet. */
+		for (OFStream *stream in streams)
+			if (stream.of_readBufferObserver == self)
+				[self of_scheduleReadBufferCheckForStream:
+				    stream];
 
-		objc_autoreleasePoolPop(pool2);
-	}
+		@throw e;
+	} @finally {
+		[streams removeAllObjects];
 
-	objc_autoreleasePoolPop(pool);
+		if (_spareReadBufferStreams == nil)
+			_spareReadBufferStreams = streams;
+		else
+			objc_release(streams);
+	}
 
 	/*
 	 * As long as we have data in the read buffer for any stream, we don't
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2008-2026 Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3.0 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * version 3.0 along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#import "OFData.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+/** @file */
+
+/**
+ * @brief How the items of an @ref OFMappedData are going to be accessed.
+ */
+typedef enum {
+	/** No particular access pattern. */
+	OFMappedDataAccessNormal,
+	/** The items are going to be accessed in sequential order. */
+	OFMappedDataAccessSequential,
+	/** The items are going to be accessed in random order. */
+	OFMappedDataAccessRandom,
+	/** The items are going to be accessed soon. */
+	OFMappedDataAccessWillNeed,
+	/** The items are not going to be accessed soon. */
+	OFMappedDataAccessDontNeed
+} OFMappedDataAccess;
+
+/**
+ * @class OFMappedData OFMappedData.h ObjFW/ObjFW.h
+ *
+ * @brief A class for accessing the contents of a file without reading it into
+ *	  memory first.
+ *
+ * If possible, the file is mapped into memory read-only, so that only the
+ * parts that are actually accessed are read from the file. If the file cannot
+ * be mapped, e.g. because it is not a local regular file, this falls back to
+ * reading the entire file into memory. Check the @ref mapped property to see
+ * whether a particular OFMappedData is mapped.
+ *
+ * Subdata created from an OFMappedData keeps the file mapped until the subdata
+ * is deallocated as well.
+ *
+ * @warning If a mapped file gets truncated by someone else, accessing the items
+ *	    beyond the new end of the file crashes the process.
+ */
+OF_SUBCLASSING_RESTRICTED
+@interface OFMappedData: OFData
+{
+	const unsigned char *_Nullable _items;
+	size_t _count;
+	OFData *_Nullable _data;
+	bool _mapped;
+}
+
+/**
+ * @brief Whether the file is mapped into memory.
+ */
+@property (readonly, nonatomic, getter=isMapped) bool mapped;
+
+/**
+ * @brief Creates a new OFMappedData with the contents of the specified file.
+ *
+ * @param path The path of the file
+ * @return A new autoreleased OFMappedData
+ * @throw OFOpenItemFailedException The file could not be opened
+ */
++ (instancetype)dataWithContentsOfFile: (OFString *)path;
+
+/**
+ * @brief Creates a new OFMappedData with the contents of the specified IRI.
+ *
+ * Only IRIs with the `file` scheme can be mapped.
+ *
+ * @param IRI The IRI to the contents for the OFMappedData
+ * @return A new autoreleased OFMappedData
+ * @throw OFOpenItemFailedException The IRI could not be opened
+ */
++ (instancetype)dataWithContentsOfIRI: (OFIRI *)IRI;
+
++ (instancetype)dataWithItems: (const void *)items
+			count: (size_t)count OF_UNAVAILABLE;
++ (instancetype)dataWithItems: (const void *)items
+			count: (size_t)count
+		     itemSize: (size_t)itemSize OF_UNAVAILABLE;
++ (instancetype)dataWithItemsNoCopy: (void *)items
+			      count: (size_t)count
+		       freeWhenDone: (bool)freeWhenDone OF_UNAVAILABLE;
++ (instancetype)dataWithItemsNoCopy: (void *)items
+			      count: (size_t)count
+			   itemSize: (size_t)itemSize
+		       freeWhenDone: (bool)freeWhenDone OF_UNAVAILABLE;
++ (instancetype)dataWithStringRepresentation: (OFString *)string OF_UNAVAILABLE;
++ (instancetype)dataWithBase64EncodedString: (OFString *)string OF_UNAVAILABLE;
+
+- (instancetype)init OF_UNAVAILABLE;
+- (instancetype)initWithItemSize: (size_t)itemSize OF_UNAVAILABLE;
+- (instancetype)initWithItems: (const void *)items
+			count: (size_t)count OF_UNAVAILABLE;
+- (instancetype)initWithItems: (const void *)items
+			count: (size_t)count
+		     itemSize: (size_t)itemSize OF_UNAVAILABLE;
+- (instancetype)initWithItemsNoCopy: (void *)items
+			      count: (size_t)count
+		       freeWhenDone: (bool)freeWhenDone OF_UNAVAILABLE;
+- (instancetype)initWithItemsNoCopy: (void *)items
+			      count: (size_t)count
+			   itemSize: (size_t)itemSize
+		       freeWhenDone: (bool)freeWhenDone OF_UNAVAILABLE;
+- (instancetype)initWithStringRepresentation: (OFString *)string OF_UNAVAILABLE;
+- (instancetype)initWithBase64EncodedString: (OFString *)string OF_UNAVAILABLE;
+
+/**
+ * @brief Initializes an already allocated OFMappedData with the contents of
+ *	  the specified file.
+ *
+ * @param path The path of the file
+ * @return An initialized OFMappedData
+ * @throw OFOpenItemFailedException The file could not be opened
+ */
+- (instancetype)initWithContentsOfFile: (OFString *)path;
+
+/**
+ * @brief Initializes an already allocated OFMappedData with the contents of
+ *	  the specified IRI.
+ *
+ * Only IRIs with the `file` scheme can be mapped.
+ *
+ * @param IRI The IRI to the contents for the OFMappedData
+ * @return An initialized OFMappedData
+ * @throw OFOpenItemFailedException The IRI could not be opened
+ */
+- (instancetype)initWithContentsOfIRI: (OFIRI *)IRI OF_DESIGNATED_INITIALIZER;
+
+/**
+ * @brief Tells the system how the items are going to be accessed, so that it
+ *	  can read ahead or free memory accordingly.
+ *
+ * This is only a hint and does nothing if the file is not mapped.
+ *
+ * @param access How the items are going to be accessed
+ */
+- (void)adviseAccess: (OFMappedDataAccess)access;
+
+/**
+ * @brief Tells the system how the items in the specified range are going to
+ *	  be accessed, so that it can read ahead or free memory accordingly.
+ *
+ * This is only a hint and does nothing if the file is not mapped.
+ *
+ * @param access How the items are going to be accessed
+ * @param range The range of the items to which the hint applies
+ * @throw OFOutOfRangeException The range is out of bounds
+ */
+- (void)adviseAccess: (OFMappedDataAccess)access range: (OFRange)range;
+@end
+
+OF_ASSUME_NONNULL_END
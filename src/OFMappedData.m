@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2008-2026 Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3.0 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * version 3.0 along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+
+#ifdef HAVE_FCNTL_H
+# include <fcntl.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#include "unistd_wrapper.h"
+
+#import "OFMappedData.h"
+#import "OFIRI.h"
+#import "OFLocale.h"
+#import "OFString.h"
+#import "OFSystemInfo.h"
+
+#import "OFOpenItemFailedException.h"
+#import "OFOutOfRangeException.h"
+
+#ifndef O_CLOEXEC
+# define O_CLOEXEC 0
+#endif
+
+@implementation OFMappedData
+@synthesize mapped = _mapped;
+
+#ifdef HAVE_MMAP
+/*
+ * Maps the file at the specified IRI into memory. Returns false if the IRI
+ * does not refer to a local regular file that can be mapped.
+ */
+static bool
+mapFile(OFMappedData *self, OFIRI *IRI)
+{
+	int fd;
+	struct stat s;
+	void *items;
+
+	if (![IRI.scheme isEqual: @"file"])
+		return false;
+
+	if ((fd = open([IRI.fileSystemRepresentation
+	    cStringWithEncoding: [OFLocale encoding]],
+	    O_RDONLY | O_CLOEXEC)) == -1)
+		@throw [OFOpenItemFailedException exceptionWithIRI: IRI
+							      mode: @"r"
+							     errNo: errno];
+
+	@try {
+		/* Other files might not have a size or be mappable at all. */
+		if (fstat(fd, &s) != 0 || !S_ISREG(s.st_mode) ||
+		    s.st_size == 0)
+			return false;
+
+		if ((unsigned long long)s.st_size > SIZE_MAX)
+			@throw [OFOutOfRangeException exception];
+
+		items = mmap(NULL, (size_t)s.st_size, PROT_READ, MAP_PRIVATE,
+		    fd, 0);
+		if (items == MAP_FAILED)
+			return false;
+	} @finally {
+		close(fd);
+	}
+
+	self->_items = items;
+	self->_count = (size_t)s.st_size;
+	self->_mapped = true;
+
+	return true;
+}
+#endif
+
++ (instancetype)dataWithItems: (const void *)items count: (size_t)count
+{
+	OF_UNRECOGNIZED_SELECTOR
+}
+
++ (instancetype)dataWithItems: (const void *)items
+			count: (size_t)count
+		     itemSize: (size_t)itemSize
+{
+	OF_UNRECOGNIZED_SELECTOR
+}
+
++ (instancetype)dataWithItemsNoCopy: (void *)items
+			      count: (size_t)count
+		       freeWhenDone: (bool)freeWhenDone
+{
+	OF_UNRECOGNIZED_SELECTOR
+}
+
++ (instancetype)dataWithItemsNoCopy: (void *)items
+			      count: (size_t)count
+			   itemSize: (size_t)itemSize
+		       freeWhenDone: (bool)freeWhenDone
+{
+	OF_UNRECOGNIZED_SELECTOR
+}
+
++ (instancetype)dataWithStringRepresentation: (OFString *)string
+{
+	OF_UNRECOGNIZED_SELECTOR
+}
+
++ (instancetype)dataWithBase64EncodedString: (OFString *)string
+{
+	OF_UNRECOGNIZED_SELECTOR
+}
+
+- (instancetype)init
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithItemSize: (size_t)itemSize
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithItems: (const void *)items count: (size_t)count
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithItems: (const void *)items
+			count: (size_t)count
+		     itemSize: (size_t)itemSize
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithItemsNoCopy: (void *)items
+			      count: (size_t)count
+		       freeWhenDone: (bool)freeWhenDone
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithItemsNoCopy: (void *)items
+			      count: (size_t)count
+			   itemSize: (size_t)itemSize
+		       freeWhenDone: (bool)freeWhenDone
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithStringRepresentation: (OFString *)string
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithBase64EncodedString: (OFString *)string
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithContentsOfIRI: (OFIRI *)IRI
+{
+	self = [super init];
+
+	@try {
+		void *pool = objc_autoreleasePoolPush();
+
+#ifdef HAVE_MMAP
+		if (!mapFile(self, IRI)) {
+#endif
+			_data = [[OFData alloc] initWithContentsOfIRI: IRI];
+			_items = _data.items;
+			_count = _data.count;
+#ifdef HAVE_MMAP
+		}
+#endif
+
+		objc_autoreleasePoolPop(pool);
+	} @catch (id e) {
+		objc_release(self);
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+#ifdef HAVE_MMAP
+	if (_mapped)
+		munmap((void *)_items, _count);
+#endif
+
+	objc_release(_data);
+
+	[super dealloc];
+}
+
+- (size_t)count
+{
+	return _count;
+}
+
+- (size_t)itemSize
+{
+	return 1;
+}
+
+- (const void *)items
+{
+	return _items;
+}
+
+- (void)adviseAccess: (OFMappedDataAccess)access
+{
+	[self adviseAccess: access range: OFMakeRange(0, _count)];
+}
+
+- (void)adviseAccess: (OFMappedDataAccess)access range: (OFRange)range
+{
+#if defined(HAVE_MMAP) && defined(HAVE_MADVISE)
+	uintptr_t start, pageStart;
+	size_t pageSize;
+	int advice;
+#endif
+
+	if (OFEndOfRange(range) > _count)
+		@throw [OFOutOfRangeException exception];
+
+#if defined(HAVE_MMAP) && defined(HAVE_MADVISE)
+	if (!_mapped || range.length == 0)
+		return;
+
+	switch (access) {
+	case OFMappedDataAccessSequential:
+		advice = MADV_SEQUENTIAL;
+		break;
+	case OFMappedDataAccessRandom:
+		advice = MADV_RANDOM;
+		break;
+	case OFMappedDataAccessWillNeed:
+		advice = MADV_WILLNEED;
+		break;
+	case OFMappedDataAccessDontNeed:
+		advice = MADV_DONTNEED;
+		break;
+	default:
+		advice = MADV_NORMAL;
+		break;
+	}
+
+	/* madvise() requires the address to be aligned to the page size. */
+	pageSize = [OFSystemInfo pageSize];
+	start = (uintptr_t)_items + range.location;
+	pageStart = start & ~(uintptr_t)(pageSize - 1);
+
+	/* This is only a hint, so failing is not an error. */
+	madvise((void *)pageStart, start - pageStart + range.length, advice);
+#endif
+}
+@end
@@ -21,13 +21,12 @@
 
 OF_ASSUME_NONNULL_BEGIN
 
-@class OFMutableArray OF_GENERIC(ObjectType);
 @class OFMutableData;
 
 @interface OFPollKernelEventObserver: OFKernelEventObserver
 {
-	OFMutableData *_FDs;
-	OFMutableArray *_objects;
+	OFMutableData *_FDs, *_slots;
+	size_t *_FDIndices, _FDIndicesCount;
 }
 @end
 
@@ -20,15 +20,15 @@
 #include "config.h"
 
 #include <errno.h>
+#include <string.h>
 
 #ifdef HAVE_POLL_H
 # include <poll.h>
 #endif
 
 #import "OFPollKernelEventObserver.h"
-#import "OFArray.h"
 #import "OFData.h"
-#import "OFNull.h"
+#import "OFKernelEventObserver+Private.h"
 #import "OFSocket.h"
 #import "OFSocket+Private.h"
 
@@ -40,6 +40,14 @@
 # define fd socket
 #endif
 
+/*
+ * The objects observed for a file descriptor, stored at the same index in
+ * _slots as the descriptor is in _FDs. The objects are retained.
+ */
+struct OFPollSlot {
+	id readObject, writeObject;
+};
+
 @implementation OFPollKernelEventObserver
 - (instancetype)initWithRunLoopMode: (OFRunLoopMode)runLoopMode
 {
@@ -47,13 +55,15 @@
 
 	@try {
 		struct pollfd p = { _cancelFD[0], POLLIN, 0 };
+		struct OFPollSlot slot = { nil, nil };
 
 		_FDs = [[OFMutableData alloc] initWithItemSize:
 		    sizeof(struct pollfd)];
 		[_FDs addItem: &p];
 
-		_objects = [[OFMutableArray alloc]
-		    initWithObject: [OFNull null]];
+		_slots = [[OFMutableData alloc] initWithItemSize:
+		    sizeof(struct OFPollSlot)];
+		[_slots addItem: &slot];
 	} @catch (id e) {
 		objc_release(self);
 		@throw e;
@@ -64,118 +74,251 @@
 
 - (void)dealloc
 {
+	struct OFPollSlot *slots = _slots.mutableItems;
+	size_t count = _slots.count;
+
+	for (size_t i = 1; i < count; i++) {
+		if (slots[i].readObject != nil)
+			[self of_stopObservingReadBufferOfObject:
+			    slots[i].readObject];
+
+		objc_release(slots[i].readObject);
+		objc_release(slots[i].writeObject);
+	}
+
 	objc_release(_FDs);
-	objc_release(_objects);
+	objc_release(_slots);
+	OFFreeMemory(_FDIndices);
 
 	[super dealloc];
 }
 
+/*
+ * _FDIndices maps a file descriptor to its index in _FDs and _slots. As index
+ * 0 is always the cancel FD, 0 means that the FD is not observed.
+ *
+ * The objects are kept here instead of in the arrays of the superclass, as
+ * removing them from those would need a linear search. An entry is only ever
+ * matched by both descriptor and object.
+ */
+
+/*
+ * Drops the objects that no longer have the descriptor of the entry, e.g.
+ * because they were closed without being removed first and the descriptor was
+ * reused since. They are autoreleased, as their deallocation might call back
+ * into the observer.
+ */
+static void
+removeStaleObjects(OFPollKernelEventObserver *self, size_t idx, int fd)
+{
+	struct pollfd *FDs = self->_FDs.mutableItems;
+	struct OFPollSlot *slot =
+	    (struct OFPollSlot *)self->_slots.mutableItems + idx;
+
+	if (slot->readObject != nil &&
+	    [slot->readObject fileDescriptorForReading] != fd) {
+		[self of_stopObservingReadBufferOfObject: slot->readObject];
+		objc_autorelease(slot->readObject);
+		slot->readObject = nil;
+		FDs[idx].events &= ~POLLIN;
+	}
+
+	if (slot->writeObject != nil &&
+	    [slot->writeObject fileDescriptorForWriting] != fd) {
+		objc_autorelease(slot->writeObject);
+		slot->writeObject = nil;
+		FDs[idx].events &= ~POLLOUT;
+	}
+}
+
 static void
 addObject(OFPollKernelEventObserver *self, id object, int fd, short events)
 {
-	struct pollfd p = { fd, events, 0 };
 	struct pollfd *FDs;
-	size_t count;
+	struct OFPollSlot *slot;
+	id *objectPtr, oldObject;
+	size_t idx;
 
 	if (fd < 0)
 		@throw [OFObserveKernelEventsFailedException
 		    exceptionWithObserver: self
 				    errNo: EBADF];
 
-	FDs = self->_FDs.mutableItems;
-	count = self->_FDs.count;
+	if ((size_t)fd >= self->_FDIndicesCount) {
+		size_t count = self->_FDIndicesCount * 2;
 
-	for (size_t i = 0; i < count; i++) {
-		if (FDs[i].fd == fd) {
-			FDs[i].events |= events;
-			return;
+		if (count <= (size_t)fd)
+			count = (size_t)fd + 1;
+
+		self->_FDIndices = OFResizeMemory(self->_FDIndices, count,
+		    sizeof(*self->_FDIndices));
+		memset(self->_FDIndices + self->_FDIndicesCount, 0,
+		    (count - self->_FDIndicesCount) *
+		    sizeof(*self->_FDIndices));
+		self->_FDIndicesCount = count;
+	}
+
+	if ((idx = self->_FDIndices[fd]) == 0) {
+		struct pollfd p = { fd, 0, 0 };
+		struct OFPollSlot newSlot = { nil, nil };
+
+		[self->_FDs addItem: &p];
+		@try {
+			[self->_slots addItem: &newSlot];
+		} @catch (id e) {
+			[self->_FDs removeLastItem];
+			@throw e;
 		}
+
+		idx = self->_FDs.count - 1;
+		self->_FDIndices[fd] = idx;
+	} else
+		removeStaleObjects(self, idx, fd);
+
+	FDs = self->_FDs.mutableItems;
+	FDs[idx].events |= events;
+
+	slot = (struct OFPollSlot *)self->_slots.mutableItems + idx;
+	objectPtr = (events == POLLIN ? &slot->readObject : &slot->writeObject);
+	oldObject = *objectPtr;
+
+	if (oldObject == object)
+		return;
+
+	*objectPtr = objc_retain(object);
+
+	if (events == POLLIN) {
+		if (oldObject != nil)
+			[self of_stopObservingReadBufferOfObject: oldObject];
+
+		[self of_observeReadBufferOfObject: object];
 	}
 
-	[self->_FDs addItem: &p];
-	[self->_objects addObject: object];
+	objc_release(oldObject);
 }
 
 static void
 removeObject(OFPollKernelEventObserver *self, id object, int fd, short events)
 {
 	struct pollfd *FDs;
-	size_t nFDs;
+	struct OFPollSlot *slots;
+	id *objectPtr;
+	size_t idx, lastIdx;
 
 	if (fd < 0)
 		@throw [OFObserveKernelEventsFailedException
 		    exceptionWithObserver: self
 				    errNo: EBADF];
 
-	FDs = self->_FDs.mutableItems;
-	nFDs = self->_FDs.count;
+	if ((size_t)fd >= self->_FDIndicesCount ||
+	    (idx = self->_FDIndices[fd]) == 0)
+		return;
 
-	for (size_t i = 0; i < nFDs; i++) {
-		if (FDs[i].fd == fd) {
-			FDs[i].events &= ~events;
+	removeStaleObjects(self, idx, fd);
 
-			if (FDs[i].events == 0) {
-				[self->_FDs removeItemAtIndex: i];
-				[self->_objects removeObjectAtIndex: i];
-			}
+	slots = self->_slots.mutableItems;
+	objectPtr = (events == POLLIN
+	    ? &slots[idx].readObject : &slots[idx].writeObject);
+	FDs = self->_FDs.mutableItems;
 
-			break;
+	if (*objectPtr == object) {
+		if (events == POLLIN)
+			[self of_stopObservingReadBufferOfObject: object];
+
+		*objectPtr = nil;
+		FDs[idx].events &= ~events;
+	} else
+		object = nil;
+
+	if (FDs[idx].events == 0) {
+		/* Move the last entry into the free slot to avoid shifting. */
+		lastIdx = self->_FDs.count - 1;
+		if (idx != lastIdx) {
+			FDs[idx] = FDs[lastIdx];
+			slots[idx] = slots[lastIdx];
+			self->_FDIndices[FDs[idx].fd] = idx;
 		}
+
+		[self->_FDs removeLastItem];
+		[self->_slots removeLastItem];
+		self->_FDIndices[fd] = 0;
 	}
+
+	objc_release(object);
 }
 
 - (void)addObjectForReading: (id <OFReadyForReadingObserving>)object
 {
 	addObject(self, object, object.fileDescriptorForReading, POLLIN);
-
-	[super addObjectForReading: object];
 }
 
 - (void)addObjectForWriting: (id <OFReadyForWritingObserving>)object
 {
 	addObject(self, object, object.fileDescriptorForWriting, POLLOUT);
-
-	[super addObjectForWriting: object];
 }
 
 - (void)removeObjectForReading: (id <OFReadyForReadingObserving>)object
 {
 	removeObject(self, object, object.fileDescriptorForReading, POLLIN);
-
-	[super removeObjectForReading: object];
 }
 
 - (void)removeObjectForWriting: (id <OFReadyForWritingObserving>)object
 {
 	removeObject(self, object, object.fileDescriptorForWriting, POLLOUT);
+}
+
+static void
+notify(OFPollKernelEventObserver *self, size_t idx, int fd, bool forReading)
+{
+	struct OFPollSlot *slot;
+	id object;
+	void *pool;
+
+	/* The delegate might have removed or moved the entry. */
+	if (idx >= self->_FDs.count ||
+	    ((struct pollfd *)self->_FDs.mutableItems)[idx].fd != fd)
+		return;
+
+	slot = (struct OFPollSlot *)self->_slots.mutableItems + idx;
+	object = (forReading ? slot->readObject : slot->writeObject);
+
+	if (object == nil)
+		return;
 
-	[super removeObjectForWriting: object];
+	pool = objc_autoreleasePoolPush();
+
+	/* The delegate might remove the object, which releases it. */
+	objc_retainAutorelease(object);
+
+	if (forReading) {
+		if ([self->_delegate respondsToSelector:
+		    @selector(objectIsReadyForReading:)])
+			[self->_delegate objectIsReadyForReading: object];
+	} else {
+		if ([self->_delegate respondsToSelector:
+		    @selector(objectIsReadyForWriting:)])
+			[self->_delegate objectIsReadyForWriting: object];
+	}
+
+	objc_autoreleasePoolPop(pool);
 }
 
 - (void)observeForTimeInterval: (OFTimeInterval)timeInterval
 {
-	void *pool;
-	struct pollfd *FDs;
-	OFArray *objects;
 	size_t nFDs;
 
 	if ([self processReadBuffers])
 		return;
 
-	pool = objc_autoreleasePoolPush();
-
-	FDs = [objc_autorelease([_FDs mutableCopy]) mutableItems];
-	objects = objc_autorelease([_objects copy]);
 	nFDs = _FDs.count;
 
-	OFAssert(objects.count == nFDs);
-
 #ifdef OPEN_MAX
 	if (nFDs > OPEN_MAX)
 		@throw [OFOutOfRangeException exception];
 #endif
 
-	while (poll(FDs, (nfds_t)nFDs,
+	/* Only revents is written, so there is no need to poll on a copy. */
+	while (poll(_FDs.mutableItems, (nfds_t)nFDs,
 	    (int)(timeInterval != -1 ? timeInterval * 1000 : -1)) < 0) {
 		int errNo = _OFSocketErrNo();
 
@@ -185,11 +328,25 @@ removeObject(OFPollKernelEventObserver *self, id object, int fd, short events)
 					    errNo: errNo];
 	}
 
-	for (size_t i = 0; i < nFDs; i++) {
-		if (FDs[i].revents & POLLIN) {
-			void *pool2;
-
-			if (FDs[i].fd == _cancelFD[0]) {
+	/*
+	 * The delegate can add and remove objects while the events are
+	 * delivered. Removing only ever moves the last entry to a lower index
+	 * and new entries have no events, so no event is delivered twice. An
+	 * event that is moved to an index that was already handled is reported
+	 * by the next poll instead.
+	 */
+	for (size_t i = 0; i < _FDs.count; i++) {
+		struct pollfd *FDs = _FDs.mutableItems;
+		short revents = FDs[i].revents;
+		int fd = FDs[i].fd;
+
+		FDs[i].revents = 0;
+
+		if (revents == 0)
+			continue;
+
+		if (i == 0) {
+			if (revents & POLLIN) {
 				char buffer;
 
 #ifdef OF_HAVE_PIPE
@@ -198,33 +355,16 @@ removeObject(OFPollKernelEventObserver *self, id object, int fd, short events)
 				OFEnsure(recvfrom(_cancelFD[0], &buffer, 1, 0,
 				    NULL, NULL) == 1);
 #endif
-				FDs[i].revents = 0;
-
-				continue;
 			}
 
-			pool2 = objc_autoreleasePoolPush();
-
-			if ([_delegate respondsToSelector:
-			    @selector(objectIsReadyForReading:)])
-				[_delegate objectIsReadyForReading:
-				    [objects objectAtIndex: i]];
-
-			objc_autoreleasePoolPop(pool2);
+			continue;
 		}
 
-		if (FDs[i].revents & (POLLOUT | POLLHUP)) {
-			void *pool2 = objc_autoreleasePoolPush();
+		if (revents & POLLIN)
+			notify(self, i, fd, true);
 
-			if ([_delegate respondsToSelector:
-			    @selector(objectIsReadyForWriting:)])
-				[_delegate objectIsReadyForWriting:
-				    [objects objectAtIndex: i]];
-
-			objc_autoreleasePoolPop(pool2);
-		}
+		if (revents & (POLLOUT | POLLHUP))
+			notify(self, i, fd, false);
 	}
-
-	objc_autoreleasePoolPop(pool);
 }
 @end
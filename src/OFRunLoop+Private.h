@@ -122,6 +122,22 @@ OF_DIRECT_MEMBERS
    handler: (nullable OFDatagramSocketDataSentHandler)handler
 # endif
   delegate: (nullable id <OFDatagramSocketDelegate>)delegate;
++ (void)of_addAsyncReceiveForDatagramSocket: (OFDatagramSocket *)socket
+   packets: (OFDatagramSocketPacket *)packets
+     count: (size_t)count
+      mode: (OFRunLoopMode)mode
+# ifdef OF_HAVE_BLOCKS
+   handler: (nullable OFDatagramSocketPacketsReceivedHandler)handler
+# endif
+  delegate: (nullable id <OFDatagramSocketDelegate>)delegate;
++ (void)of_addAsyncSendForDatagramSocket: (OFDatagramSocket *)socket
+   packets: (const OFDatagramSocketPacket *)packets
+     count: (size_t)count
+      mode: (OFRunLoopMode)mode
+# ifdef OF_HAVE_BLOCKS
+   handler: (nullable OFDatagramSocketPacketsSentHandler)handler
+# endif
+  delegate: (nullable id <OFDatagramSocketDelegate>)delegate;
 + (void)of_addAsyncReceiveForSequencedPacketSocket:
 					       (OFSequencedPacketSocket *)socket
     buffer: (void *)buffer
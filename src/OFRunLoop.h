@@ -39,6 +39,7 @@ OF_ASSUME_NONNULL_BEGIN
 @class OFMutableDictionary OF_GENERIC(KeyType, ObjectType);
 @class OFTimer;
 @class OFDate;
+@class OFRunLoopStatistics;
 
 /**
  * @brief A mode for an OFRunLoop.
@@ -74,7 +75,10 @@ OF_SUBCLASSING_RESTRICTED
 	OFMutex *_statesMutex;
 #endif
 	OFRunLoopMode _Nullable _currentMode;
+	id _Nullable _currentState;
 	volatile bool _stop;
+	unsigned long long _numberOfWakeups;
+	bool _collectsStatistics;
 }
 
 #ifdef OF_HAVE_CLASS_PROPERTIES
@@ -83,6 +87,26 @@ OF_SUBCLASSING_RESTRICTED
 #endif
 @property OF_NULLABLE_PROPERTY (readonly, nonatomic) OFRunLoopMode currentMode;
 
+/**
+ * @brief The number of times the run loop woke up after waiting for events or
+ *	  timers.
+ *
+ * Sampling this twice and dividing the difference by the time elapsed in
+ * between yields the number of wakeups per second, which can be used to verify
+ * that timers with a tolerance are coalesced.
+ */
+@property (readonly, nonatomic) unsigned long long numberOfWakeups;
+
+/**
+ * @brief Whether the run loop collects statistics about the time spent in
+ *	  handlers and about late timers.
+ *
+ * Statistics are collected separately for each mode and can be retrieved
+ * using @ref statisticsForMode:. This is off by default, in which case it only
+ * costs a check per handler call.
+ */
+@property (nonatomic) bool collectsStatistics;
+
 /**
  * @brief Returns the run loop for the main thread.
  *
@@ -197,6 +221,19 @@ OF_SUBCLASSING_RESTRICTED
  */
 - (void)runMode: (OFRunLoopMode)mode beforeDate: (nullable OFDate *)deadline;
 
+/**
+ * @brief Returns a snapshot of the statistics for the specified mode.
+ *
+ * This can be called from any thread. As the run loop is not stopped to take
+ * the snapshot, the values are not necessarily consistent with each other
+ * when called from another thread.
+ *
+ * @param mode The mode to return the statistics for
+ * @return A snapshot of the statistics for the specified mode or `nil` if the
+ *	   run loop has never been used with the mode
+ */
+- (nullable OFRunLoopStatistics *)statisticsForMode: (OFRunLoopMode)mode;
+
 /**
  * @brief Stops the run loop. If there is still an operation being executed, it
  *	  is finished before the run loop stops.
@@ -20,15 +20,24 @@
 #include "config.h"
 
 #include <errno.h>
+#include <time.h>
+
+#include <sys/time.h>
 
 #import "OFRunLoop.h"
 #import "OFRunLoop+Private.h"
+#import "OFRunLoopStatistics.h"
+#import "OFRunLoopStatistics+Private.h"
 #import "OFArray.h"
 #import "OFData.h"
 #import "OFDictionary.h"
 #ifdef OF_HAVE_SOCKETS
 # import "OFKernelEventObserver.h"
 # import "OFDatagramSocket.h"
+# ifdef OF_HAVE_FILES
+#  import "OFFile.h"
+#  import "OFFile+Private.h"
+# endif
 # import "OFSequencedPacketSocket.h"
 # import "OFSequencedPacketSocket+Private.h"
 # import "OFStreamSocket.h"
@@ -39,12 +48,13 @@
 # import "OFMutex.h"
 # import "OFCondition.h"
 #endif
-#import "OFSortedList.h"
 #import "OFTimer.h"
 #import "OFTimer+Private.h"
+#import "OFTimerQueue.h"
 #import "OFDate.h"
 
 #import "OFObserveKernelEventsFailedException.h"
+#import "OFReadFailedException.h"
 #import "OFWriteFailedException.h"
 
 #ifdef OF_AMIGAOS
@@ -63,20 +73,31 @@ OFDefaultRunLoopModeRef(void)
 
 static OFRunLoop *mainRunLoop = nil;
 
+#ifdef OF_HAVE_SOCKETS
+@class OFRunLoopQueueItem;
+
+# define numRecycledReadQueueItems 4
+#endif
+
 @interface OFRunLoopState: OFObject
 #ifdef OF_HAVE_SOCKETS
     <OFKernelEventObserverDelegate>
 #endif
 {
 @public
-	OFSortedList OF_GENERIC(OFTimer *) *_timersQueue;
+	OFTimerQueue *_timersQueue;
 #ifdef OF_HAVE_THREADS
 	OFMutex *_timersQueueMutex;
 #endif
 #ifdef OF_HAVE_SOCKETS
 	OFKernelEventObserver *_kernelEventObserver;
 	OFMutableDictionary *_readQueues, *_writeQueues;
+	size_t _readQueueDepth, _writeQueueDepth;
+	OFRunLoopQueueItem *_recycledReadQueueItems[numRecycledReadQueueItems];
 #endif
+	bool _collectsStatistics;
+	struct OFRunLoopCounters _counters;
+	OFTimeInterval _iterationHandlerTime;
 #ifdef OF_HAVE_THREADS
 	OFCondition *_condition;
 # ifdef OF_AMIGAOS
@@ -105,6 +126,7 @@ static OFRunLoop *mainRunLoop = nil;
 }
 
 - (bool)handleObject: (id)object;
+- (bool)prepareForReuse;
 @end
 
 @interface OFRunLoopReadQueueItem: OFRunLoopQueueItem
@@ -208,6 +230,28 @@ static OFRunLoop *mainRunLoop = nil;
 }
 @end
 
+@interface OFRunLoopDatagramReceivePacketsQueueItem: OFRunLoopQueueItem
+{
+@public
+# ifdef OF_HAVE_BLOCKS
+	OFDatagramSocketPacketsReceivedHandler _handler;
+# endif
+	OFDatagramSocketPacket *_packets;
+	size_t _count;
+}
+@end
+
+@interface OFRunLoopDatagramSendPacketsQueueItem: OFRunLoopQueueItem
+{
+@public
+# ifdef OF_HAVE_BLOCKS
+	OFDatagramSocketPacketsSentHandler _handler;
+# endif
+	const OFDatagramSocketPacket *_packets;
+	size_t _count, _sent;
+}
+@end
+
 @interface OFRunLoopPacketReceiveQueueItem: OFRunLoopQueueItem
 {
 @public
@@ -254,6 +298,80 @@ static OFRunLoop *mainRunLoop = nil;
 # endif
 #endif
 
+/*
+ * The same clock as +[OFDate date] so that it can be compared to fire dates,
+ * but without creating an OFDate for every handler call.
+ */
+static OF_INLINE OFTimeInterval
+currentTime(void)
+{
+#if defined(HAVE_CLOCK_GETTIME)
+	struct timespec ts;
+
+	OFEnsure(clock_gettime(CLOCK_REALTIME, &ts) == 0);
+
+	return ts.tv_sec + (OFTimeInterval)ts.tv_nsec / 1000000000;
+#elif !defined(OF_MORPHOS)
+	struct timeval tv;
+
+	OFEnsure(gettimeofday(&tv, NULL) == 0);
+
+	return tv.tv_sec + (OFTimeInterval)tv.tv_usec / 1000000;
+#else
+	return [OFDate date].timeIntervalSince1970;
+#endif
+}
+
+static void
+addHandlerTime(OFRunLoopState *state, OFTimeInterval startTime,
+    unsigned long long *numberOfCalls, OFTimeInterval *handlerTime)
+{
+	OFTimeInterval elapsed = currentTime() - startTime;
+
+	/* The clock might have been set back. */
+	if (elapsed < 0)
+		elapsed = 0;
+
+	(*numberOfCalls)++;
+	*handlerTime += elapsed;
+	state->_iterationHandlerTime += elapsed;
+}
+
+static void
+addTimerLateness(OFRunLoopState *state, OFTimer *timer)
+{
+	OFTimeInterval lateness = currentTime() -
+	    timer.fireDate.timeIntervalSince1970 - timer.tolerance;
+
+	if (lateness > 0.001)
+		state->_counters.numberOfLateTimers++;
+
+	if (lateness > state->_counters.maximumTimerLateness)
+		state->_counters.maximumTimerLateness = lateness;
+}
+
+static void
+finishIteration(OFRunLoopState *state)
+{
+	OFTimeInterval handlerTime = state->_iterationHandlerTime;
+	unsigned long long microseconds = handlerTime * 1000000;
+	size_t bucket = 0;
+
+	while (microseconds > 0 &&
+	    bucket < OFRunLoopStatisticsHistogramBuckets - 1) {
+		microseconds >>= 1;
+		bucket++;
+	}
+
+	state->_counters.numberOfIterations++;
+	state->_counters.iterationHandlerTimeHistogram[bucket]++;
+
+	if (handlerTime > state->_counters.maximumIterationHandlerTime)
+		state->_counters.maximumIterationHandlerTime = handlerTime;
+
+	state->_iterationHandlerTime = 0;
+}
+
 @implementation OFRunLoopState
 - (instancetype)init
 {
@@ -265,7 +383,7 @@ static OFRunLoop *mainRunLoop = nil;
 	self = [super init];
 
 	@try {
-		_timersQueue = [[OFSortedList alloc] init];
+		_timersQueue = [[OFTimerQueue alloc] init];
 #ifdef OF_HAVE_THREADS
 		_timersQueueMutex = [[OFMutex alloc] init];
 #endif
@@ -311,6 +429,9 @@ static OFRunLoop *mainRunLoop = nil;
 	objc_release(_kernelEventObserver);
 	objc_release(_readQueues);
 	objc_release(_writeQueues);
+
+	for (size_t i = 0; i < numRecycledReadQueueItems; i++)
+		objc_release(_recycledReadQueueItems[i]);
 #endif
 #ifdef OF_HAVE_THREADS
 	objc_release(_condition);
@@ -328,14 +449,145 @@ static OFRunLoop *mainRunLoop = nil;
 }
 
 #ifdef OF_HAVE_SOCKETS
+static void
+recycleReadQueueItem(OFRunLoopState *self, OFRunLoopQueueItem *queueItem)
+{
+	for (size_t i = 0; i < numRecycledReadQueueItems; i++) {
+		if (self->_recycledReadQueueItems[i] == nil) {
+			if ([queueItem prepareForReuse])
+				self->_recycledReadQueueItems[i] =
+				    objc_retain(queueItem);
+
+			return;
+		}
+	}
+}
+
+# ifdef OF_HAVE_ASYNC_FILE_IO
+static OFAsyncFileIO *
+asyncIOForObject(id object)
+{
+	if (![object isKindOfClass: [OFFile class]])
+		return nil;
+
+	return [object of_asyncIO];
+}
+
+/* Whether a background read of a file was started or is still in progress. */
+static bool
+isWaitingForBackgroundRead(id object, int errNo)
+{
+	return ((errNo == EWOULDBLOCK || errNo == EAGAIN) &&
+	    asyncIOForObject(object) != nil);
+}
+
+static void
+asyncIOIsReady(OFRunLoopState *self, OFAsyncFileIO *asyncIO)
+{
+	OFFile *file = objc_retain(asyncIO->_file);
+
+	@try {
+		/*
+		 * Writes go first, as the result of a write needs to be
+		 * collected before a read is started. Otherwise, the result
+		 * would be discarded and the write would be repeated.
+		 */
+		OFList *writeQueue = [self->_writeQueues objectForKey: file];
+
+		if (writeQueue != nil) {
+			/* So that the result of a write finds its request. */
+			asyncIO->_currentRequest = writeQueue.firstObject;
+			[self objectIsReadyForWriting: file];
+			asyncIO->_currentRequest = nil;
+		}
+		if ([self->_readQueues objectForKey: file] != nil)
+			[self objectIsReadyForReading: file];
+	} @finally {
+		asyncIO->_currentRequest = nil;
+		objc_release(file);
+	}
+}
+# endif
+
+static void
+startObserving(OFRunLoopState *self, id object, bool forWriting)
+{
+# ifdef OF_HAVE_ASYNC_FILE_IO
+	OFAsyncFileIO *asyncIO = asyncIOForObject(object);
+
+	/*
+	 * Regular files are observed through their OFAsyncFileIO, which is
+	 * observed for reading only, no matter whether the file is read from
+	 * or written to.
+	 */
+	if (asyncIO != nil) {
+		OFList *otherQueue = [(forWriting
+		    ? self->_readQueues : self->_writeQueues)
+		    objectForKey: object];
+
+		if (otherQueue.count == 0) {
+			[self->_kernelEventObserver
+			    addObjectForReading: asyncIO];
+			[asyncIO addObserver];
+		}
+
+		return;
+	}
+# endif
+
+	if (forWriting)
+		[self->_kernelEventObserver addObjectForWriting: object];
+	else
+		[self->_kernelEventObserver addObjectForReading: object];
+}
+
+static void
+stopObserving(OFRunLoopState *self, id object, bool forWriting)
+{
+# ifdef OF_HAVE_ASYNC_FILE_IO
+	OFAsyncFileIO *asyncIO = asyncIOForObject(object);
+
+	if (asyncIO != nil) {
+		OFList *otherQueue = [(forWriting
+		    ? self->_readQueues : self->_writeQueues)
+		    objectForKey: object];
+
+		if (otherQueue.count == 0) {
+			[self->_kernelEventObserver
+			    removeObjectForReading: asyncIO];
+			[asyncIO removeObserver];
+		}
+
+		return;
+	}
+# endif
+
+	if (forWriting)
+		[self->_kernelEventObserver removeObjectForWriting: object];
+	else
+		[self->_kernelEventObserver removeObjectForReading: object];
+}
+
 - (void)objectIsReadyForReading: (id)object
 {
+	OFList OF_GENERIC(OF_KINDOF(OFRunLoopReadQueueItem *)) *queue;
+	/* The handler might change whether statistics are collected. */
+	bool collectsStatistics = _collectsStatistics;
+	OFTimeInterval startTime;
+
+# ifdef OF_HAVE_ASYNC_FILE_IO
+	if ([object isKindOfClass: [OFAsyncFileIO class]]) {
+		asyncIOIsReady(self, object);
+		return;
+	}
+# endif
+
 	/*
 	 * Retain the queue so that it doesn't disappear from us because the
 	 * handler called -[cancelAsyncRequests].
 	 */
-	OFList OF_GENERIC(OF_KINDOF(OFRunLoopReadQueueItem *)) *queue =
-	    objc_retain([_readQueues objectForKey: object]);
+	queue = objc_retain([_readQueues objectForKey: object]);
+	startTime = (collectsStatistics ? currentTime() : 0);
 
 	OFAssert(queue != nil);
 
@@ -349,27 +601,36 @@ static OFRunLoop *mainRunLoop = nil;
 			 * should do nothing.
 			 */
 			if (listItem != NULL) {
+				OFRunLoopQueueItem *queueItem =
+				    OFListItemObject(listItem);
+
 				/*
 				 * Make sure we keep the target until after we
 				 * are done removing the object. The reason for
 				 * this is that the target might call
 				 * -[cancelAsyncRequests] in its dealloc.
 				 */
-				objc_retainAutorelease(
-				    OFListItemObject(listItem));
+				objc_retainAutorelease(queueItem);
 
 				[queue removeListItem: listItem];
+				_readQueueDepth--;
 
 				if (queue.count == 0) {
-					[_kernelEventObserver
-					    removeObjectForReading: object];
+					stopObserving(self, object, false);
 					[_readQueues
 					    removeObjectForKey: object];
 				}
+
+				recycleReadQueueItem(self, queueItem);
 			}
 		}
 	} @finally {
 		objc_release(queue);
+
+		if (collectsStatistics)
+			addHandlerTime(self, startTime,
+			    &_counters.numberOfReadHandlerCalls,
+			    &_counters.readHandlerTime);
 	}
 }
 
@@ -380,6 +641,9 @@ static OFRunLoop *mainRunLoop = nil;
 	 * handler called -[cancelAsyncRequests].
 	 */
 	OFList *queue = objc_retain([_writeQueues objectForKey: object]);
+	/* The handler might change whether statistics are collected. */
+	bool collectsStatistics = _collectsStatistics;
+	OFTimeInterval startTime = (collectsStatistics ? currentTime() : 0);
 
 	OFAssert(queue != nil);
 
@@ -403,10 +667,10 @@ static OFRunLoop *mainRunLoop = nil;
 				    OFListItemObject(listItem));
 
 				[queue removeListItem: listItem];
+				_writeQueueDepth--;
 
 				if (queue.count == 0) {
-					[_kernelEventObserver
-					    removeObjectForWriting: object];
+					stopObserving(self, object, true);
 					[_writeQueues
 					    removeObjectForKey: object];
 				}
@@ -414,6 +678,11 @@ static OFRunLoop *mainRunLoop = nil;
 		}
 	} @finally {
 		objc_release(queue);
+
+		if (collectsStatistics)
+			addHandlerTime(self, startTime,
+			    &_counters.numberOfWriteHandlerCalls,
+			    &_counters.writeHandlerTime);
 	}
 }
 #endif
@@ -475,6 +744,18 @@ static OFRunLoop *mainRunLoop = nil;
 	OF_UNRECOGNIZED_SELECTOR
 }
 
+- (bool)prepareForReuse
+{
+	/*
+	 * Autorelease instead of release, as the delegate might call
+	 * -[cancelAsyncRequests] in its dealloc.
+	 */
+	objc_autorelease(_delegate);
+	_delegate = nil;
+
+	return false;
+}
+
 - (void)dealloc
 {
 	objc_release(_delegate);
@@ -491,6 +772,14 @@ static OFRunLoop *mainRunLoop = nil;
 
 	@try {
 		length = [object readIntoBuffer: _buffer length: _length];
+# ifdef OF_HAVE_ASYNC_FILE_IO
+	} @catch (OFReadFailedException *e) {
+		if (isWaitingForBackgroundRead(object, e.errNo))
+			return true;
+
+		length = 0;
+		exception = e;
+# endif
 	} @catch (id e) {
 		length = 0;
 		exception = e;
@@ -514,6 +803,18 @@ static OFRunLoop *mainRunLoop = nil;
 # endif
 }
 
+- (bool)prepareForReuse
+{
+	[super prepareForReuse];
+
+# ifdef OF_HAVE_BLOCKS
+	objc_autorelease(_handler);
+	_handler = NULL;
+# endif
+
+	return true;
+}
+
 # ifdef OF_HAVE_BLOCKS
 - (void)dealloc
 {
@@ -533,6 +834,14 @@ static OFRunLoop *mainRunLoop = nil;
 	@try {
 		length = [object readIntoBuffer: (char *)_buffer + _readLength
 					 length: _exactLength - _readLength];
+# ifdef OF_HAVE_ASYNC_FILE_IO
+	} @catch (OFReadFailedException *e) {
+		if (isWaitingForBackgroundRead(object, e.errNo))
+			return true;
+
+		length = 0;
+		exception = e;
+# endif
 	} @catch (id e) {
 		length = 0;
 		exception = e;
@@ -570,6 +879,20 @@ static OFRunLoop *mainRunLoop = nil;
 # endif
 }
 
+- (bool)prepareForReuse
+{
+	[super prepareForReuse];
+
+# ifdef OF_HAVE_BLOCKS
+	objc_autorelease(_handler);
+	_handler = NULL;
+# endif
+
+	_readLength = 0;
+
+	return true;
+}
+
 # ifdef OF_HAVE_BLOCKS
 - (void)dealloc
 {
@@ -588,6 +911,14 @@ static OFRunLoop *mainRunLoop = nil;
 
 	@try {
 		string = [object tryReadStringWithEncoding: _encoding];
+# ifdef OF_HAVE_ASYNC_FILE_IO
+	} @catch (OFReadFailedException *e) {
+		if (isWaitingForBackgroundRead(object, e.errNo))
+			return true;
+
+		string = nil;
+		exception = e;
+# endif
 	} @catch (id e) {
 		string = nil;
 		exception = e;
@@ -613,6 +944,18 @@ static OFRunLoop *mainRunLoop = nil;
 # endif
 }
 
+- (bool)prepareForReuse
+{
+	[super prepareForReuse];
+
+# ifdef OF_HAVE_BLOCKS
+	objc_autorelease(_handler);
+	_handler = NULL;
+# endif
+
+	return true;
+}
+
 # ifdef OF_HAVE_BLOCKS
 - (void)dealloc
 {
@@ -631,6 +974,14 @@ static OFRunLoop *mainRunLoop = nil;
 
 	@try {
 		line = [object tryReadLineWithEncoding: _encoding];
+# ifdef OF_HAVE_ASYNC_FILE_IO
+	} @catch (OFReadFailedException *e) {
+		if (isWaitingForBackgroundRead(object, e.errNo))
+			return true;
+
+		line = nil;
+		exception = e;
+# endif
 	} @catch (id e) {
 		line = nil;
 		exception = e;
@@ -656,6 +1007,18 @@ static OFRunLoop *mainRunLoop = nil;
 # endif
 }
 
+- (bool)prepareForReuse
+{
+	[super prepareForReuse];
+
+# ifdef OF_HAVE_BLOCKS
+	objc_autorelease(_handler);
+	_handler = NULL;
+# endif
+
+	return true;
+}
+
 # ifdef OF_HAVE_BLOCKS
 - (void)dealloc
 {
@@ -1024,6 +1387,95 @@ static OFRunLoop *mainRunLoop = nil;
 }
 @end
 
+@implementation OFRunLoopDatagramReceivePacketsQueueItem
+- (bool)handleObject: (id)object
+{
+	size_t count;
+	id exception = nil;
+
+	@try {
+		count = [object receivePackets: _packets count: _count];
+	} @catch (id e) {
+		count = 0;
+		exception = e;
+	}
+
+# ifdef OF_HAVE_BLOCKS
+	if (_handler != NULL)
+		return _handler(object, _packets, count, exception);
+	else {
+# endif
+		if (![_delegate respondsToSelector:
+		    @selector(socket:didReceivePackets:count:exception:)])
+			return false;
+
+		return [_delegate socket: object
+		       didReceivePackets: _packets
+				   count: count
+			       exception: exception];
+# ifdef OF_HAVE_BLOCKS
+	}
+# endif
+}
+
+# ifdef OF_HAVE_BLOCKS
+- (void)dealloc
+{
+	objc_release(_handler);
+
+	[super dealloc];
+}
+# endif
+@end
+
+@implementation OFRunLoopDatagramSendPacketsQueueItem
+- (bool)handleObject: (id)object
+{
+	size_t sent;
+	id exception = nil;
+
+	@try {
+		_sent += [object sendPackets: _packets + _sent
+				       count: _count - _sent];
+	} @catch (id e) {
+		exception = e;
+	}
+
+	/* Wait until the socket is writable again to send the rest. */
+	if (exception == nil && _sent < _count)
+		return true;
+
+	sent = _sent;
+	_sent = 0;
+
+# ifdef OF_HAVE_BLOCKS
+	if (_handler != NULL)
+		return _handler(object, _packets, sent, exception);
+	else {
+# endif
+		if (![_delegate respondsToSelector:
+		    @selector(socket:didSendPackets:count:exception:)])
+			return false;
+
+		return [_delegate socket: object
+			  didSendPackets: _packets
+				   count: sent
+			       exception: exception];
+# ifdef OF_HAVE_BLOCKS
+	}
+# endif
+}
+
+# ifdef OF_HAVE_BLOCKS
+- (void)dealloc
+{
+	objc_release(_handler);
+
+	[super dealloc];
+}
+# endif
+@end
+
 @implementation OFRunLoopPacketReceiveQueueItem
 - (bool)handleObject: (id)object
 {
@@ -1235,7 +1687,8 @@ static OFRunLoop *mainRunLoop = nil;
 #endif
 
 @implementation OFRunLoop
-@synthesize currentMode = _currentMode;
+@synthesize currentMode = _currentMode, numberOfWakeups = _numberOfWakeups;
+@synthesize collectsStatistics = _collectsStatistics;
 
 + (OFRunLoop *)mainRunLoop
 {
@@ -1270,6 +1723,7 @@ stateForMode(OFRunLoop *self, OFRunLoopMode mode, bool create,
 
 		if (create && state == nil) {
 			state = [[OFRunLoopState alloc] initWithMode: mode];
+			state->_collectsStatistics = self->_collectsStatistics;
 			@try {
 				[self->_states setObject: state forKey: mode];
 			} @finally {
@@ -1308,11 +1762,45 @@ stateForMode(OFRunLoop *self, OFRunLoopMode mode, bool create,
 }
 
 #ifdef OF_HAVE_SOCKETS
+/*
+ * Must only be called on the thread the run loop belongs to. While the run
+ * loop is running, this avoids taking the lock and looking up the state when
+ * a handler queues the next read or write for the mode it is called in.
+ */
+static OF_INLINE OFRunLoopState *
+ownStateForMode(OFRunLoop *self, OFRunLoopMode mode)
+{
+	OFRunLoopState *state = self->_currentState;
+
+	if (state != nil && state->_kernelEventObserver != nil &&
+	    (mode == self->_currentMode || [mode isEqual: self->_currentMode]))
+		return state;
+
+	return stateForMode(self, mode, true, true);
+}
+
+static id
+newReadQueueItem(OFRunLoopState *state, Class class)
+{
+	for (size_t i = 0; i < numRecycledReadQueueItems; i++) {
+		OFRunLoopQueueItem *queueItem =
+		    state->_recycledReadQueueItems[i];
+
+		if (queueItem != nil && object_getClass(queueItem) == class) {
+			state->_recycledReadQueueItems[i] = nil;
+			return objc_autorelease(queueItem);
+		}
+	}
+
+	return objc_autorelease([[class alloc] init]);
+}
+
 # define NEW_READ(type, object, mode)					 \
 	void *pool = objc_autoreleasePoolPush();			 \
 	OFRunLoop *runLoop = [self currentRunLoop];			 \
-	OFRunLoopState *state = stateForMode(runLoop, mode, true, true); \
+	OFRunLoopState *state = ownStateForMode(runLoop, mode);		 \
 	OFList *queue = [state->_readQueues objectForKey: object];	 \
+	size_t *queueDepth = &state->_readQueueDepth;			 \
 	type *queueItem;						 \
 									 \
 	if (queue == nil) {						 \
@@ -1321,15 +1809,15 @@ stateForMode(OFRunLoop *self, OFRunLoopMode mode, bool create,
 	}								 \
 									 \
 	if (queue.count == 0)						 \
-		[state->_kernelEventObserver				 \
-		    addObjectForReading: object];			 \
+		startObserving(state, object, false);			 \
 									 \
-	queueItem = objc_autorelease([[type alloc] init]);
+	queueItem = newReadQueueItem(state, [type class]);
 # define NEW_WRITE(type, object, mode)					 \
 	void *pool = objc_autoreleasePoolPush();			 \
 	OFRunLoop *runLoop = [self currentRunLoop];			 \
-	OFRunLoopState *state = stateForMode(runLoop, mode, true, true); \
+	OFRunLoopState *state = ownStateForMode(runLoop, mode);		 \
 	OFList *queue = [state->_writeQueues objectForKey: object];	 \
+	size_t *queueDepth = &state->_writeQueueDepth;			 \
 	type *queueItem;						 \
 									 \
 	if (queue == nil) {						 \
@@ -1338,12 +1826,12 @@ stateForMode(OFRunLoop *self, OFRunLoopMode mode, bool create,
 	}								 \
 									 \
 	if (queue.count == 0)						 \
-		[state->_kernelEventObserver				 \
-		    addObjectForWriting: object];			 \
+		startObserving(state, object, true);			 \
 									 \
 	queueItem = objc_autorelease([[type alloc] init]);
 #define QUEUE_ITEM							 \
 	[queue appendObject: queueItem];				 \
+	(*queueDepth)++;						 \
 									 \
 	objc_autoreleasePoolPop(pool);
 
@@ -1543,6 +2031,48 @@ stateForMode(OFRunLoop *self, OFRunLoopMode mode, bool create,
 	QUEUE_ITEM
 }
 
++ (void)of_addAsyncReceiveForDatagramSocket: (OFDatagramSocket *)sock
+   packets: (OFDatagramSocketPacket *)packets
+     count: (size_t)count
+      mode: (OFRunLoopMode)mode
+# ifdef OF_HAVE_BLOCKS
+   handler: (OFDatagramSocketPacketsReceivedHandler)handler
+# endif
+  delegate: (id <OFDatagramSocketDelegate>)delegate
+{
+	NEW_READ(OFRunLoopDatagramReceivePacketsQueueItem, sock, mode)
+
+	queueItem->_delegate = objc_retain(delegate);
+# ifdef OF_HAVE_BLOCKS
+	queueItem->_handler = [handler copy];
+# endif
+	queueItem->_packets = packets;
+	queueItem->_count = count;
+
+	QUEUE_ITEM
+}
+
++ (void)of_addAsyncSendForDatagramSocket: (OFDatagramSocket *)sock
+   packets: (const OFDatagramSocketPacket *)packets
+     count: (size_t)count
+      mode: (OFRunLoopMode)mode
+# ifdef OF_HAVE_BLOCKS
+   handler: (OFDatagramSocketPacketsSentHandler)handler
+# endif
+  delegate: (id <OFDatagramSocketDelegate>)delegate
+{
+	NEW_WRITE(OFRunLoopDatagramSendPacketsQueueItem, sock, mode)
+
+	queueItem->_delegate = objc_retain(delegate);
+# ifdef OF_HAVE_BLOCKS
+	queueItem->_handler = [handler copy];
+# endif
+	queueItem->_packets = packets;
+	queueItem->_count = count;
+
+	QUEUE_ITEM
+}
+
 + (void)of_addAsyncReceiveForSequencedPacketSocket: (OFSequencedPacketSocket *)
 							sock
     buffer: (void *)buffer
@@ -1655,10 +2185,10 @@ stateForMode(OFRunLoop *self, OFRunLoopMode mode, bool create,
 				 * called from a handler, as otherwise, we'd do
 				 * the cleanups below twice.
 				 */
+				state->_writeQueueDepth -= queue.count;
 				[queue removeAllObjects];
 
-				[state->_kernelEventObserver
-				    removeObjectForWriting: object];
+				stopObserving(state, object, true);
 				[state->_writeQueues
 				    removeObjectForKey: object];
 			}
@@ -1672,10 +2202,10 @@ stateForMode(OFRunLoop *self, OFRunLoopMode mode, bool create,
 				 * called from a handler, as otherwise, we'd do
 				 * the cleanups below twice.
 				 */
+				state->_readQueueDepth -= queue.count;
 				[queue removeAllObjects];
 
-				[state->_kernelEventObserver
-				    removeObjectForReading: object];
+				stopObserving(state, object, false);
 				[state->_readQueues
 				    removeObjectForKey: object];
 			}
@@ -1741,7 +2271,7 @@ stateForMode(OFRunLoop *self, OFRunLoopMode mode, bool create,
 	[state->_timersQueueMutex lock];
 	@try {
 #endif
-		[state->_timersQueue insertObject: timer];
+		[state->_timersQueue addTimer: timer];
 #ifdef OF_HAVE_THREADS
 	} @finally {
 		[state->_timersQueueMutex unlock];
@@ -1771,13 +2301,7 @@ stateForMode(OFRunLoop *self, OFRunLoopMode mode, bool create,
 	[state->_timersQueueMutex lock];
 	@try {
 #endif
-		for (OFListItem iter = state->_timersQueue.firstListItem;
-		    iter != NULL; iter = OFListItemNext(iter)) {
-			if ([OFListItemObject(iter) isEqual: timer]) {
-				[state->_timersQueue removeListItem: iter];
-				break;
-			}
-		}
+		[state->_timersQueue removeTimer: timer];
 #ifdef OF_HAVE_THREADS
 	} @finally {
 		[state->_timersQueueMutex unlock];
@@ -1913,62 +2437,98 @@ stateForMode(OFRunLoop *self, OFRunLoopMode mode, bool create,
 {
 	void *pool = objc_autoreleasePoolPush();
 	OFRunLoopMode previousMode = _currentMode;
+	OFRunLoopState *previousState = _currentState;
 	OFRunLoopState *state = stateForMode(self, mode, false, false);
+	bool collectsStatistics;
 
 	if (state == nil) {
 		objc_autoreleasePoolPop(pool);
 		return;
 	}
 
+	/*
+	 * Only count the iteration if statistics were already collected when
+	 * it started, as otherwise the handler time would be incomplete.
+	 */
+	if ((collectsStatistics = state->_collectsStatistics))
+		state->_iterationHandlerTime = 0;
+
 	_currentMode = mode;
+	_currentState = state;
 	@try {
+		OFTimeInterval now = [OFDate date].timeIntervalSince1970;
+		OFTimer *timer;
+		bool fired = false;
 		OFDate *nextTimer;
 #if defined(OF_AMIGAOS) && defined(OF_HAVE_THREADS)
 		ULONG signalMask;
 #endif
 
+		/*
+		 * Take the due timers out of the queue one at a time, so that
+		 * a handler that changes the fire date of another timer or
+		 * invalidates it is honored. Timers rescheduled by a handler
+		 * get a fire date after now and are not fired again.
+		 */
 		for (;;) {
-			OFTimer *timer;
-
 #ifdef OF_HAVE_THREADS
 			[state->_timersQueueMutex lock];
 			@try {
 #endif
-				OFListItem listItem =
-				    state->_timersQueue.firstListItem;
-
-				if (listItem != NULL &&
-				    [OFListItemObject(listItem) fireDate]
-				    .timeIntervalSinceNow <= 0) {
-					timer = objc_retainAutorelease(
-					    OFListItemObject(listItem));
-
-					[state->_timersQueue
-					    removeListItem: listItem];
-
-					[timer of_setInRunLoop: nil mode: nil];
-				} else
-					break;
+				timer = [state->_timersQueue
+				    removeFirstTimerDueAt: now];
 #ifdef OF_HAVE_THREADS
 			} @finally {
 				[state->_timersQueueMutex unlock];
 			}
 #endif
 
+			if (timer == nil)
+				break;
+
+			[timer of_setInRunLoop: nil mode: nil];
+
 			if (timer.valid) {
+				OFTimeInterval startTime = 0;
+
+				if (collectsStatistics) {
+					addTimerLateness(state, timer);
+					startTime = currentTime();
+				}
+
 				[timer of_reschedule];
 				[timer fire];
-				objc_autoreleasePoolPop(pool);
-				return;
+				fired = true;
+
+				if (collectsStatistics)
+					addHandlerTime(state, startTime,
+					    &state->_counters
+					    .numberOfTimerHandlerCalls,
+					    &state->_counters.timerHandlerTime);
 			}
 		}
 
+		if (fired) {
+			objc_autoreleasePoolPop(pool);
+			return;
+		}
+
 #ifdef OF_HAVE_THREADS
 		[state->_timersQueueMutex lock];
 		@try {
 #endif
-			nextTimer = [[state->_timersQueue
-			    firstObject] fireDate];
+			/*
+			 * Wake up at the latest time at which all timers whose
+			 * tolerance windows overlap can be fired together.
+			 */
+			if (state->_timersQueue.count > 0) {
+				OFTimeInterval wakeupTime =
+				    state->_timersQueue.nextWakeupTime;
+
+				nextTimer = [OFDate
+				    dateWithTimeIntervalSince1970: wakeupTime];
+			} else
+				nextTimer = nil;
 #ifdef OF_HAVE_THREADS
 		} @finally {
 			[state->_timersQueueMutex unlock];
@@ -2068,12 +2628,60 @@ stateForMode(OFRunLoop *self, OFRunLoopMode mode, bool create,
 #endif
 		}
 
+		_numberOfWakeups++;
+
 		objc_autoreleasePoolPop(pool);
 	} @finally {
+		if (collectsStatistics)
+			finishIteration(state);
+
 		_currentMode = previousMode;
+		_currentState = previousState;
 	}
 }
 
+- (void)setCollectsStatistics: (bool)collectsStatistics
+{
+	void *pool = objc_autoreleasePoolPush();
+
+#ifdef OF_HAVE_THREADS
+	[_statesMutex lock];
+	@try {
+#endif
+		_collectsStatistics = collectsStatistics;
+
+		for (OFRunLoopState *state in [_states objectEnumerator])
+			state->_collectsStatistics = collectsStatistics;
+#ifdef OF_HAVE_THREADS
+	} @finally {
+		[_statesMutex unlock];
+	}
+#endif
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (OFRunLoopStatistics *)statisticsForMode: (OFRunLoopMode)mode
+{
+	OFRunLoopState *state = stateForMode(self, mode, false, false);
+	struct OFRunLoopCounters counters;
+	size_t readQueueDepth = 0, writeQueueDepth = 0;
+
+	if (state == nil)
+		return nil;
+
+	counters = state->_counters;
+#ifdef OF_HAVE_SOCKETS
+	readQueueDepth = state->_readQueueDepth;
+	writeQueueDepth = state->_writeQueueDepth;
+#endif
+
+	return objc_autoreleaseReturnValue([[OFRunLoopStatistics alloc]
+	    of_initWithCounters: &counters
+		 readQueueDepth: readQueueDepth
+		writeQueueDepth: writeQueueDepth]);
+}
+
 - (void)stop
 {
 	OFRunLoopState *state = stateForMode(self, OFDefaultRunLoopMode,
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2008-2026 Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3.0 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * version 3.0 along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#import "OFRunLoopStatistics.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+#define OFRunLoopStatisticsHistogramBuckets 24
+
+struct OFRunLoopCounters {
+	unsigned long long numberOfIterations;
+	unsigned long long iterationHandlerTimeHistogram[
+	    OFRunLoopStatisticsHistogramBuckets];
+	OFTimeInterval maximumIterationHandlerTime;
+	unsigned long long numberOfReadHandlerCalls;
+	unsigned long long numberOfWriteHandlerCalls;
+	unsigned long long numberOfTimerHandlerCalls;
+	OFTimeInterval readHandlerTime, writeHandlerTime, timerHandlerTime;
+	unsigned long long numberOfLateTimers;
+	OFTimeInterval maximumTimerLateness;
+};
+
+OF_DIRECT_MEMBERS
+@interface OFRunLoopStatistics ()
+- (instancetype)
+    of_initWithCounters: (const struct OFRunLoopCounters *)counters
+	 readQueueDepth: (size_t)readQueueDepth
+	writeQueueDepth: (size_t)writeQueueDepth;
+@end
+
+OF_ASSUME_NONNULL_END
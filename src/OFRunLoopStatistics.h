@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2008-2026 Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3.0 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * version 3.0 along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#import "OFObject.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFArray OF_GENERIC(ObjectType);
+@class OFNumber;
+
+/**
+ * @class OFRunLoopStatistics OFRunLoopStatistics.h ObjFW/ObjFW.h
+ *
+ * @brief A snapshot of the statistics an @ref OFRunLoop collected for a mode.
+ *
+ * Statistics are only collected while @ref OFRunLoop#collectsStatistics is
+ * true. The queue depths are always available.
+ */
+@interface OFRunLoopStatistics: OFObject
+{
+	unsigned long long _numberOfIterations;
+	OFArray OF_GENERIC(OFNumber *) *_iterationHandlerTimeHistogram;
+	OFTimeInterval _maximumIterationHandlerTime;
+	unsigned long long _numberOfReadHandlerCalls;
+	unsigned long long _numberOfWriteHandlerCalls;
+	unsigned long long _numberOfTimerHandlerCalls;
+	OFTimeInterval _readHandlerTime, _writeHandlerTime, _timerHandlerTime;
+	unsigned long long _numberOfLateTimers;
+	OFTimeInterval _maximumTimerLateness;
+	size_t _readQueueDepth, _writeQueueDepth;
+	OF_RESERVE_IVARS(OFRunLoopStatistics, 4)
+}
+
+/**
+ * @brief The number of iterations the run loop ran in the mode.
+ */
+@property (readonly, nonatomic) unsigned long long numberOfIterations;
+
+/**
+ * @brief A histogram of the time spent running handlers per iteration.
+ *
+ * The first bucket counts iterations that spent less than 1 µs in handlers.
+ * Bucket n counts iterations that spent at least 2^(n-1) µs and less than 2^n
+ * µs in handlers, except for the last bucket, which counts all iterations
+ * that took even longer.
+ */
+@property (readonly, nonatomic)
+    OFArray OF_GENERIC(OFNumber *) *iterationHandlerTimeHistogram;
+
+/**
+ * @brief The longest time a single iteration spent running handlers.
+ */
+@property (readonly, nonatomic) OFTimeInterval maximumIterationHandlerTime;
+
+/**
+ * @brief The number of times a handler for a read, accept or receive was
+ *	  called.
+ */
+@property (readonly, nonatomic) unsigned long long numberOfReadHandlerCalls;
+
+/**
+ * @brief The number of times a handler for a write, connect or send was
+ *	  called.
+ */
+@property (readonly, nonatomic) unsigned long long numberOfWriteHandlerCalls;
+
+/**
+ * @brief The number of times a timer fired.
+ */
+@property (readonly, nonatomic) unsigned long long numberOfTimerHandlerCalls;
+
+/**
+ * @brief The total time spent in handlers for reads, accepts and receives.
+ */
+@property (readonly, nonatomic) OFTimeInterval readHandlerTime;
+
+/**
+ * @brief The total time spent in handlers for writes, connects and sends.
+ */
+@property (readonly, nonatomic) OFTimeInterval writeHandlerTime;
+
+/**
+ * @brief The total time spent in firing timers.
+ */
+@property (readonly, nonatomic) OFTimeInterval timerHandlerTime;
+
+/**
+ * @brief The number of timers that fired more than 1 ms after the end of their
+ *	  tolerance.
+ */
+@property (readonly, nonatomic) unsigned long long numberOfLateTimers;
+
+/**
+ * @brief The longest time a timer fired after the end of its tolerance.
+ */
+@property (readonly, nonatomic) OFTimeInterval maximumTimerLateness;
+
+/**
+ * @brief The number of asynchronous reads, accepts and receives that were
+ *	  pending when the snapshot was taken.
+ */
+@property (readonly, nonatomic) size_t readQueueDepth;
+
+/**
+ * @brief The number of asynchronous writes, connects and sends that were
+ *	  pending when the snapshot was taken.
+ */
+@property (readonly, nonatomic) size_t writeQueueDepth;
+
+- (instancetype)init OF_UNAVAILABLE;
+@end
+
+OF_ASSUME_NONNULL_END
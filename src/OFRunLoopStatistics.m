@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2008-2026 Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3.0 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * version 3.0 along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#import "OFRunLoopStatistics.h"
+#import "OFRunLoopStatistics+Private.h"
+#import "OFArray.h"
+#import "OFNumber.h"
+
+@implementation OFRunLoopStatistics
+@synthesize numberOfIterations = _numberOfIterations;
+@synthesize iterationHandlerTimeHistogram = _iterationHandlerTimeHistogram;
+@synthesize maximumIterationHandlerTime = _maximumIterationHandlerTime;
+@synthesize numberOfReadHandlerCalls = _numberOfReadHandlerCalls;
+@synthesize numberOfWriteHandlerCalls = _numberOfWriteHandlerCalls;
+@synthesize numberOfTimerHandlerCalls = _numberOfTimerHandlerCalls;
+@synthesize readHandlerTime = _readHandlerTime;
+@synthesize writeHandlerTime = _writeHandlerTime;
+@synthesize timerHandlerTime = _timerHandlerTime;
+@synthesize numberOfLateTimers = _numberOfLateTimers;
+@synthesize maximumTimerLateness = _maximumTimerLateness;
+@synthesize readQueueDepth = _readQueueDepth;
+@synthesize writeQueueDepth = _writeQueueDepth;
+
+- (instancetype)init
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)
+    of_initWithCounters: (const struct OFRunLoopCounters *)counters
+	 readQueueDepth: (size_t)readQueueDepth
+	writeQueueDepth: (size_t)writeQueueDepth
+{
+	self = [super init];
+
+	@try {
+		void *pool = objc_autoreleasePoolPush();
+		OFNumber *histogram[OFRunLoopStatisticsHistogramBuckets];
+
+		_numberOfIterations = counters->numberOfIterations;
+
+		for (size_t i = 0; i < OFRunLoopStatisticsHistogramBuckets; i++)
+			histogram[i] = [OFNumber numberWithUnsignedLongLong:
+			    counters->iterationHandlerTimeHistogram[i]];
+
+		_iterationHandlerTimeHistogram = [[OFArray alloc]
+		    initWithObjects: histogram
+			      count: OFRunLoopStatisticsHistogramBuckets];
+
+		_maximumIterationHandlerTime =
+		    counters->maximumIterationHandlerTime;
+		_numberOfReadHandlerCalls = counters->numberOfReadHandlerCalls;
+		_numberOfWriteHandlerCalls =
+		    counters->numberOfWriteHandlerCalls;
+		_numberOfTimerHandlerCalls =
+		    counters->numberOfTimerHandlerCalls;
+		_readHandlerTime = counters->readHandlerTime;
+		_writeHandlerTime = counters->writeHandlerTime;
+		_timerHandlerTime = counters->timerHandlerTime;
+		_numberOfLateTimers = counters->numberOfLateTimers;
+		_maximumTimerLateness = counters->maximumTimerLateness;
+		_readQueueDepth = readQueueDepth;
+		_writeQueueDepth = writeQueueDepth;
+
+		objc_autoreleasePoolPop(pool);
+	} @catch (id e) {
+		objc_release(self);
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	objc_release(_iterationHandlerTimeHistogram);
+
+	[super dealloc];
+}
+@end
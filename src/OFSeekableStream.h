@@ -104,6 +104,87 @@ typedef enum {
  */
 - (OFStreamOffset)lowlevelSeekToOffset: (OFStreamOffset)offset
 				whence: (OFSeekWhence)whence;
+
+/**
+ * @brief Reads at most `length` bytes from the specified offset into a buffer.
+ *
+ * This neither uses nor changes the current offset and the read buffer of the
+ * stream. Subclasses that support this can be read from multiple threads at
+ * the same time this way.
+ *
+ * @param buffer The buffer into which the data is read
+ * @param length The length of the data that should be read at most.
+ *		 The buffer *must* be *at least* this big!
+ * @param offset The offset from the start of the stream to read from
+ * @return The number of bytes read, which is 0 if the offset is at or beyond
+ *	   the end of the stream
+ * @throw OFReadFailedException Reading failed
+ * @throw OFNotOpenException The stream is not open
+ * @throw OFNotImplementedException The stream does not support reading from
+ *				    an offset
+ */
+- (size_t)readIntoBuffer: (void *)buffer
+		  length: (size_t)length
+		atOffset: (OFStreamOffset)offset;
+
+/**
+ * @brief Writes from a buffer to the specified offset.
+ *
+ * This neither uses nor changes the current offset of the stream and ignores
+ * the write buffer, which should therefore be flushed first. Subclasses that
+ * support this can be written from multiple threads at the same time this way.
+ *
+ * @param buffer The buffer from which the data is written
+ * @param length The length of the data that should be written
+ * @param offset The offset from the start of the stream to write to
+ * @throw OFWriteFailedException Writing failed
+ * @throw OFNotOpenException The stream is not open
+ * @throw OFNotImplementedException The stream does not support writing to an
+ *				    offset
+ */
+- (void)writeBuffer: (const void *)buffer
+	     length: (size_t)length
+	   atOffset: (OFStreamOffset)offset;
+
+/**
+ * @brief Performs a lowlevel read from the specified offset.
+ *
+ * @warning Do not call this directly!
+ *
+ * @note Override this method with your actual positional read implementation
+ *	 when subclassing! The default implementation throws an
+ *	 @ref OFNotImplementedException.
+ *
+ * @param buffer The buffer for the data to read
+ * @param length The length of the buffer
+ * @param offset The offset from the start of the stream to read from
+ * @return The number of bytes read
+ * @throw OFReadFailedException Reading failed
+ * @throw OFNotOpenException The stream is not open
+ */
+- (size_t)lowlevelReadIntoBuffer: (void *)buffer
+			  length: (size_t)length
+			atOffset: (OFStreamOffset)offset;
+
+/**
+ * @brief Performs a lowlevel write to the specified offset.
+ *
+ * @warning Do not call this directly!
+ *
+ * @note Override this method with your actual positional write implementation
+ *	 when subclassing! The default implementation throws an
+ *	 @ref OFNotImplementedException.
+ *
+ * @param buffer The buffer with the data to write
+ * @param length The length of the data to write
+ * @param offset The offset from the start of the stream to write to
+ * @return The number of bytes written
+ * @throw OFWriteFailedException Writing failed
+ * @throw OFNotOpenException The stream is not open
+ */
+- (size_t)lowlevelWriteBuffer: (const void *)buffer
+		       length: (size_t)length
+		     atOffset: (OFStreamOffset)offset;
 @end
 
 OF_ASSUME_NONNULL_END
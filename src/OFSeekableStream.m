@@ -21,11 +21,16 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <stdlib.h>
 #include <stdio.h>
 
 #import "OFSeekableStream.h"
 
+#import "OFNotImplementedException.h"
+#import "OFReadFailedException.h"
+#import "OFWriteFailedException.h"
+
 @implementation OFSeekableStream
 - (instancetype)init
 {
@@ -56,10 +61,79 @@
 
 	offset = [self lowlevelSeekToOffset: offset whence: whence];
 
-	OFFreeMemory(_readBufferMemory);
-	_readBuffer = _readBufferMemory = NULL;
+	/* Keep the memory, it will be reused for the next read. */
+	_readBuffer = _readBufferMemory;
 	_readBufferLength = 0;
 
 	return offset;
 }
+
+- (size_t)lowlevelReadIntoBuffer: (void *)buffer
+			  length: (size_t)length
+			atOffset: (OFStreamOffset)offset
+{
+	@throw [OFNotImplementedException exceptionWithSelector: _cmd
+							 object: self];
+}
+
+- (size_t)lowlevelWriteBuffer: (const void *)buffer
+		       length: (size_t)length
+		     atOffset: (OFStreamOffset)offset
+{
+	@throw [OFNotImplementedException exceptionWithSelector: _cmd
+							 object: self];
+}
+
+- (size_t)readIntoBuffer: (void *)buffer
+		  length: (size_t)length
+		atOffset: (OFStreamOffset)offset
+{
+	for (;;) {
+		@try {
+			return [self lowlevelReadIntoBuffer: buffer
+						     length: length
+						   atOffset: offset];
+		} @catch (OFReadFailedException *e) {
+			if (e.errNo != EINTR)
+				@throw e;
+		}
+	}
+}
+
+- (void)writeBuffer: (const void *)buffer
+	     length: (size_t)length
+	   atOffset: (OFStreamOffset)offset
+{
+	size_t bytesWritten = 0;
+
+	while (bytesWritten < length) {
+		size_t ret;
+
+		@try {
+			ret = [self
+			    lowlevelWriteBuffer: (const char *)buffer +
+						 bytesWritten
+					 length: length - bytesWritten
+				       atOffset: offset + bytesWritten];
+		} @catch (OFWriteFailedException *e) {
+			if (e.errNo == EINTR)
+				continue;
+
+			@throw [OFWriteFailedException
+			    exceptionWithObject: self
+				requestedLength: length
+				   bytesWritten: bytesWritten
+					  errNo: e.errNo];
+		}
+
+		if (ret == 0)
+			@throw [OFWriteFailedException
+			    exceptionWithObject: self
+				requestedLength: length
+				   bytesWritten: bytesWritten
+					  errNo: 0];
+
+		bytesWritten += ret;
+	}
+}
 @end
@@ -38,6 +38,10 @@ OF_ASSUME_NONNULL_BEGIN
 {
 	fd_set _readFDs, _writeFDs;
 	int _maxFD;
+#ifndef OF_WINDOWS
+	id _Nullable *_Nullable _readObjectsByFD, *_Nullable _writeObjectsByFD;
+	size_t _objectsByFDCount;
+#endif
 }
 @end
 
@@ -33,6 +33,7 @@
 
 #import "OFSelectKernelEventObserver.h"
 #import "OFArray.h"
+#import "OFKernelEventObserver+Private.h"
 #import "OFSocket.h"
 #import "OFSocket+Private.h"
 
@@ -84,6 +85,151 @@
 	return self;
 }
 
+- (void)dealloc
+{
+#ifndef OF_WINDOWS
+	for (size_t i = 0; i < _objectsByFDCount; i++) {
+		if (_readObjectsByFD[i] != nil)
+			[self of_stopObservingReadBufferOfObject:
+			    _readObjectsByFD[i]];
+
+		objc_release(_readObjectsByFD[i]);
+		objc_release(_writeObjectsByFD[i]);
+	}
+
+	OFFreeMemory(_readObjectsByFD);
+	OFFreeMemory(_writeObjectsByFD);
+#endif
+
+	[super dealloc];
+}
+
+static void
+removeFD(OFSelectKernelEventObserver *self, int fd, fd_set *FDs)
+{
+	FD_CLR((OFSocketHandle)fd, FDs);
+
+#ifndef OF_WINDOWS
+	/*
+	 * Shrink _maxFD so that select() does not need to check descriptors
+	 * that are no longer observed.
+	 */
+	if (fd != self->_maxFD)
+		return;
+
+	while (self->_maxFD >= 0 &&
+	    !FD_ISSET(self->_maxFD, &self->_readFDs) &&
+	    !FD_ISSET(self->_maxFD, &self->_writeFDs))
+		self->_maxFD--;
+#endif
+}
+
+#ifndef OF_WINDOWS
+/*
+ * Outside of Windows, descriptors are small integers, so the objects are kept
+ * in tables indexed by descriptor instead of in the arrays of the superclass,
+ * as removing them from those would need a linear search. An entry is only
+ * ever matched by both descriptor and object.
+ */
+
+/*
+ * Drops the objects that no longer have the descriptor they are stored for,
+ * e.g. because they were closed without being removed first and the descriptor
+ * was reused since. They are autoreleased, as their deallocation might call
+ * back into the observer.
+ */
+static void
+removeStaleObjects(OFSelectKernelEventObserver *self, int fd)
+{
+	id readObject, writeObject;
+
+	if ((size_t)fd >= self->_objectsByFDCount)
+		return;
+
+	readObject = self->_readObjectsByFD[fd];
+	writeObject = self->_writeObjectsByFD[fd];
+
+	if (readObject != nil && [readObject fileDescriptorForReading] != fd) {
+		[self of_stopObservingReadBufferOfObject: readObject];
+		objc_autorelease(readObject);
+		self->_readObjectsByFD[fd] = nil;
+		removeFD(self, fd, &self->_readFDs);
+	}
+
+	if (writeObject != nil &&
+	    [writeObject fileDescriptorForWriting] != fd) {
+		objc_autorelease(writeObject);
+		self->_writeObjectsByFD[fd] = nil;
+		removeFD(self, fd, &self->_writeFDs);
+	}
+}
+
+static void
+setObjectForFD(OFSelectKernelEventObserver *self, id object, int fd,
+    bool forReading)
+{
+	id *objects, oldObject;
+
+	if ((size_t)fd >= self->_objectsByFDCount) {
+		size_t count = self->_objectsByFDCount * 2;
+
+		if (count <= (size_t)fd)
+			count = (size_t)fd + 1;
+
+		self->_readObjectsByFD = OFResizeMemory(self->_readObjectsByFD,
+		    count, sizeof(id));
+		memset(self->_readObjectsByFD + self->_objectsByFDCount, 0,
+		    (count - self->_objectsByFDCount) * sizeof(id));
+		self->_writeObjectsByFD = OFResizeMemory(
+		    self->_writeObjectsByFD, count, sizeof(id));
+		memset(self->_writeObjectsByFD + self->_objectsByFDCount, 0,
+		    (count - self->_objectsByFDCount) * sizeof(id));
+		self->_objectsByFDCount = count;
+	}
+
+	removeStaleObjects(self, fd);
+
+	objects = (forReading
+	    ? self->_readObjectsByFD : self->_writeObjectsByFD);
+	oldObject = objects[fd];
+
+	if (oldObject == object)
+		return;
+
+	objects[fd] = objc_retain(object);
+
+	if (forReading) {
+		if (oldObject != nil)
+			[self of_stopObservingReadBufferOfObject: oldObject];
+
+		[self of_observeReadBufferOfObject: object];
+	}
+
+	objc_release(oldObject);
+}
+
+static bool
+removeObjectForFD(OFSelectKernelEventObserver *self, id object, int fd,
+    bool forReading)
+{
+	id *objects = (forReading
+	    ? self->_readObjectsByFD : self->_writeObjectsByFD);
+
+	removeStaleObjects(self, fd);
+
+	if ((size_t)fd >= self->_objectsByFDCount || objects[fd] != object)
+		return false;
+
+	if (forReading)
+		[self of_stopObservingReadBufferOfObject: object];
+
+	objects[fd] = nil;
+	objc_release(object);
+
+	return true;
+}
+#endif
+
 - (void)addObjectForReading: (id <OFReadyForReadingObserving>)object
 {
 	int fd = object.fileDescriptorForReading;
@@ -99,14 +245,16 @@
 #ifndef OF_WINDOWS
 	if (fd >= (int)FD_SETSIZE)
 		@throw [OFOutOfRangeException exception];
+
+	setObjectForFD(self, object, fd, true);
+#else
+	[super addObjectForReading: object];
 #endif
 
 	if (fd > _maxFD)
 		_maxFD = fd;
 
 	FD_SET((OFSocketHandle)fd, &_readFDs);
-
-	[super addObjectForReading: object];
 }
 
 - (void)addObjectForWriting: (id <OFReadyForWritingObserving>)object
@@ -124,20 +272,20 @@
 #ifndef OF_WINDOWS
 	if (fd >= (int)FD_SETSIZE)
 		@throw [OFOutOfRangeException exception];
+
+	setObjectForFD(self, object, fd, false);
+#else
+	[super addObjectForWriting: object];
 #endif
 
 	if (fd > _maxFD)
 		_maxFD = fd;
 
 	FD_SET((OFSocketHandle)fd, &_writeFDs);
-
-	[super addObjectForWriting: object];
 }
 
 - (void)removeObjectForReading: (id <OFReadyForReadingObserving>)object
 {
-	/* TODO: Adjust _maxFD */
-
 	int fd = object.fileDescriptorForReading;
 
 	if (fd < 0)
@@ -148,17 +296,18 @@
 #ifndef OF_WINDOWS
 	if (fd >= (int)FD_SETSIZE)
 		@throw [OFOutOfRangeException exception];
-#endif
 
-	FD_CLR((OFSocketHandle)fd, &_readFDs);
+	if (removeObjectForFD(self, object, fd, true))
+		removeFD(self, fd, &_readFDs);
+#else
+	removeFD(self, fd, &_readFDs);
 
 	[super removeObjectForReading: object];
+#endif
 }
 
 - (void)removeObjectForWriting: (id <OFReadyForWritingObserving>)object
 {
-	/* TODO: Adjust _maxFD */
-
 	int fd = object.fileDescriptorForWriting;
 
 	if (fd < 0)
@@ -166,16 +315,51 @@
 		    exceptionWithObserver: self
 				    errNo: EBADF];
 
-
 #ifndef OF_WINDOWS
 	if (fd >= (int)FD_SETSIZE)
 		@throw [OFOutOfRangeException exception];
-#endif
 
-	FD_CLR((OFSocketHandle)fd, &_writeFDs);
+	if (removeObjectForFD(self, object, fd, false))
+		removeFD(self, fd, &_writeFDs);
+#else
+	removeFD(self, fd, &_writeFDs);
 
 	[super removeObjectForWriting: object];
+#endif
+}
+
+#ifndef OF_WINDOWS
+static void
+notify(OFSelectKernelEventObserver *self, int fd, bool forReading)
+{
+	id *objects = (forReading
+	    ? self->_readObjectsByFD : self->_writeObjectsByFD);
+	void *pool;
+	id object;
+
+	/* The delegate might have removed the object in the meantime. */
+	if ((size_t)fd >= self->_objectsByFDCount ||
+	    (object = objects[fd]) == nil)
+		return;
+
+	pool = objc_autoreleasePoolPush();
+
+	/* The delegate might remove the object, which releases it. */
+	objc_retainAutorelease(object);
+
+	if (forReading) {
+		if ([self->_delegate respondsToSelector:
+		    @selector(objectIsReadyForReading:)])
+			[self->_delegate objectIsReadyForReading: object];
+	} else {
+		if ([self->_delegate respondsToSelector:
+		    @selector(objectIsReadyForWriting:)])
+			[self->_delegate objectIsReadyForWriting: object];
+	}
+
+	objc_autoreleasePoolPop(pool);
 }
+#endif
 
 - (void)observeForTimeInterval: (OFTimeInterval)timeInterval
 {
@@ -187,11 +371,20 @@
 	BYTE cancelSignal;
 	ULONG execSignalMask;
 #endif
+#ifndef OF_WINDOWS
+	int maxFD;
+#else
 	void *pool;
+#endif
 
 	if ([self processReadBuffers])
 		return;
 
+#ifndef OF_WINDOWS
+	/* The delegate might change _maxFD while events are delivered. */
+	maxFD = _maxFD;
+#endif
+
 #ifdef FD_COPY
 	FD_COPY(&_readFDs, &readFDs);
 	FD_COPY(&_writeFDs, &writeFDs);
@@ -269,6 +462,15 @@
 	}
 #endif
 
+#ifndef OF_WINDOWS
+	for (int fd = 0; fd <= maxFD; fd++) {
+		if (FD_ISSET(fd, &readFDs))
+			notify(self, fd, true);
+
+		if (FD_ISSET(fd, &writeFDs))
+			notify(self, fd, false);
+	}
+#else
 	pool = objc_autoreleasePoolPush();
 
 	for (id <OFReadyForReadingObserving> object in
@@ -298,5 +500,6 @@
 	}
 
 	objc_autoreleasePoolPop(pool);
+#endif
 }
 @end
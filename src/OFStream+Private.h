@@ -25,6 +25,12 @@ OF_DIRECT_MEMBERS
 @interface OFStream ()
 @property (readonly, nonatomic, getter=of_isWaitingForDelimiter)
     bool of_waitingForDelimiter;
+#ifdef OF_HAVE_SOCKETS
+@property OF_NULLABLE_PROPERTY (assign, nonatomic,
+    setter=of_setReadBufferObserver:) id of_readBufferObserver;
+@property (nonatomic, getter=of_isReadBufferCheckPending,
+    setter=of_setReadBufferCheckPending:) bool of_readBufferCheckPending;
+#endif
 @end
 
 OF_ASSUME_NONNULL_END
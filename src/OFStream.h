@@ -40,6 +40,18 @@ OF_ASSUME_NONNULL_BEGIN
 @class OFStream;
 @class OFData;
 
+/**
+ * @struct OFStreamBuffer OFStream.h ObjFW/ObjFW.h
+ *
+ * @brief A buffer that is part of a vectored write.
+ */
+typedef struct {
+	/** The data to write */
+	const void *buffer;
+	/** The length of the data to write */
+	size_t length;
+} OFStreamBuffer;
+
 #if defined(OF_HAVE_SOCKETS) && defined(OF_HAVE_BLOCKS)
 /**
  * @brief A block which is called when data was read asynchronously from a
@@ -344,6 +356,21 @@ typedef OFString *_Nullable (^OFStreamStringWrittenHandler)(OFStream *stream,
  */
 @property (nonatomic) size_t maxStringReadLength;
 
+/**
+ * @brief The capacity of the internal read buffer.
+ *
+ * The read buffer is allocated once and reused for all reads instead of being
+ * reallocated whenever data is buffered. Data is read into it in chunks of at
+ * least half its capacity. It grows beyond its capacity if necessary, e.g. to
+ * hold a line that is longer than the capacity, and shrinks back once it has
+ * been drained.
+ *
+ * The default is twice the page size.
+ *
+ * @throw OFInvalidArgumentException The specified capacity is 0
+ */
+@property (nonatomic) size_t readBufferCapacity;
+
 /**
  * @brief Whether the stream can block.
  *
@@ -405,6 +432,41 @@ typedef OFString *_Nullable (^OFStreamStringWrittenHandler)(OFStream *stream,
  */
  - (void)readIntoBuffer: (void *)buffer exactLength: (size_t)length;
 
+/**
+ * @brief Returns the data in the internal read buffer without consuming it,
+ *	  reading more from the stream first if less than `minimumLength`
+ *	  bytes are buffered.
+ *
+ * This allows parsing data in place without copying it out of the stream
+ * first. Once the data has been parsed, it needs to be consumed using
+ * @ref consumeLength:.
+ *
+ * The returned buffer is owned by the stream and only valid until the next
+ * operation on the stream.
+ *
+ * @param minimumLength The minimum number of bytes that should be buffered
+ * @param length A pointer to where to store the number of bytes in the
+ *		 returned buffer. This can be more than `minimumLength`, and it
+ *		 is only less if the end of the stream was reached.
+ * @return The data in the internal read buffer or `NULL` if it is empty
+ * @throw OFReadFailedException Reading failed
+ * @throw OFNotOpenException The stream is not open
+ */
+- (nullable const void *)peekBufferWithMinimumLength: (size_t)minimumLength
+					      length: (size_t *)length;
+
+/**
+ * @brief Consumes the specified number of bytes from the internal read buffer.
+ *
+ * This is used after @ref peekBufferWithMinimumLength:length: to remove the
+ * data that has been parsed.
+ *
+ * @param length The number of bytes to consume
+ * @throw OFOutOfRangeException More bytes than are in the internal read buffer
+ *				were specified
+ */
+- (void)consumeLength: (size_t)length;
+
 #ifdef OF_HAVE_SOCKETS
 /**
  * @brief Asynchronously reads *at most* `length` bytes from the stream into a
@@ -1409,6 +1471,43 @@ typedef OFString *_Nullable (^OFStreamStringWrittenHandler)(OFStream *stream,
  */
 - (void)writeBuffer: (const void *)buffer length: (size_t)length;
 
+/**
+ * @brief Writes multiple buffers into the stream.
+ *
+ * This behaves as if @ref writeBuffer:length: was called for each buffer, but
+ * if the stream does not buffer writes, the buffers are written without being
+ * copied and, if the stream supports it, using a single system call.
+ *
+ * @param buffers The buffers to write into the stream
+ * @param count The number of buffers
+ * @throw OFWriteFailedException Writing failed
+ * @throw OFNotOpenException The stream is not open
+ */
+- (void)writeBuffers: (const OFStreamBuffer *)buffers count: (size_t)count;
+
+/**
+ * @brief Writes up to the specified number of bytes read from another stream
+ *	  into the stream.
+ *
+ * If the other stream is an @ref OFFile and this stream is a file or a stream
+ * socket that does not buffer writes, the data is transferred by the kernel
+ * using `sendfile` where available, without being copied into user space.
+ * Otherwise, the data is copied through the read buffer of the other stream.
+ *
+ * This method blocks until all data has been written or the end of the other
+ * stream has been reached.
+ *
+ * @param stream The stream to read the data from
+ * @param length The maximum number of bytes to write
+ * @return The number of bytes written. This is only less than `length` if the
+ *	   end of the other stream has been reached.
+ * @throw OFReadFailedException Reading from the other stream failed
+ * @throw OFWriteFailedException Writing failed
+ * @throw OFNotOpenException One of the streams is not open
+ */
+- (unsigned long long)writeContentsOfStream: (OFStream *)stream
+				     length: (unsigned long long)length;
+
 #ifdef OF_HAVE_SOCKETS
 /**
  * @brief Asynchronously writes data into the stream.
@@ -1942,6 +2041,26 @@ typedef OFString *_Nullable (^OFStreamStringWrittenHandler)(OFStream *stream,
  */
 - (size_t)lowlevelWriteBuffer: (const void *)buffer length: (size_t)length;
 
+/**
+ * @brief Performs a lowlevel write of multiple buffers.
+ *
+ * The default implementation calls @ref lowlevelWriteBuffer:length: for each
+ * buffer until one could not be written completely.
+ *
+ * @warning Do not call this directly!
+ *
+ * @note Override this method if the stream can write multiple buffers more
+ *	 efficiently than one at a time, e.g. using `writev`.
+ *
+ * @param buffers The buffers with the data to write
+ * @param count The number of buffers
+ * @return The total number of bytes written
+ * @throw OFWriteFailedException Writing failed
+ * @throw OFNotOpenException The stream is not open
+ */
+- (size_t)lowlevelWriteBuffers: (const OFStreamBuffer *)buffers
+			 count: (size_t)count;
+
 /**
  * @brief Returns whether the lowlevel is at the end of the stream.
  *
@@ -28,6 +28,9 @@
 #ifdef HAVE_FCNTL_H
 # include <fcntl.h>
 #endif
+#ifdef HAVE_SYS_SENDFILE_H
+# include <sys/sendfile.h>
+#endif
 
 #include "platform.h"
 
@@ -39,12 +42,22 @@
 #import "OFStream+Private.h"
 #import "OFASPrintF.h"
 #import "OFData.h"
+#ifdef OF_HAVE_FILES
+# import "OFFile.h"
+# import "OFFile+Private.h"
+#endif
 #import "OFKernelEventObserver.h"
+#ifdef OF_HAVE_SOCKETS
+# import "OFKernelEventObserver+Private.h"
+#endif
 #import "OFRunLoop+Private.h"
 #import "OFRunLoop.h"
 #ifdef OF_HAVE_SOCKETS
 # import "OFSocket+Private.h"
 #endif
+#ifdef OF_HAVE_SOCKETS
+# import "OFStreamSocket.h"
+#endif
 #import "OFString.h"
 #import "OFSystemInfo.h"
 
@@ -59,11 +72,250 @@
 #import "OFWriteFailedException.h"
 
 #define minReadSize 512
+#define maxWriteBuffers 16
+
+/*
+ * State that was added after the ivar layout of OFStream became part of the
+ * ABI. It is kept in a struct pointed to by the reserved ivar instead.
+ */
+struct OFStreamIvars {
+	id _Nullable readBufferObserver;
+	bool readBufferCheckPending;
+	size_t readBufferSize, readBufferCapacity;
+};
+
+#ifdef OF_HAVE_NONFRAGILE_IVARS
+/* Non-fragile ivars have no reserved ivars, but allow adding ivars here. */
+@interface OFStream ()
+{
+	struct OFStreamIvars *_ivars;
+}
+@end
+#endif
+
+#if defined(OF_HAVE_FILES) && defined(OF_FILE_HANDLE_IS_FD) && \
+    defined(HAVE_SYS_SENDFILE_H) && defined(HAVE_SENDFILE)
+# define USE_SENDFILE
+#endif
 
 @implementation OFStream
 @synthesize buffersWrites = _buffersWrites;
 @synthesize of_waitingForDelimiter = _waitingForDelimiter, delegate = _delegate;
 
+static OF_INLINE struct OFStreamIvars *
+streamIvars(OFStream *self)
+{
+#ifdef OF_HAVE_NONFRAGILE_IVARS
+	return self->_ivars;
+#else
+	return self->_reserved_OFStream[0];
+#endif
+}
+
+/*
+ * Called before every operation that might leave data in the read buffer, so
+ * that the observer only needs to check streams that have been read from
+ * instead of all streams it observes.
+ */
+static OF_INLINE void
+scheduleReadBufferCheck(OFStream *self)
+{
+#ifdef OF_HAVE_SOCKETS
+	struct OFStreamIvars *ivars = streamIvars(self);
+
+	if (ivars->readBufferObserver != nil && !ivars->readBufferCheckPending)
+		[(OFKernelEventObserver *)ivars->readBufferObserver
+		    of_scheduleReadBufferCheckForStream: self];
+#endif
+}
+
+/*
+ * Returns the free space at the end of the read buffer, making sure there are
+ * at least minLength bytes by compacting the buffer first and only growing it
+ * if that is not enough.
+ */
+static char *
+reserveReadBuffer(OFStream *self, size_t minLength, size_t *length)
+{
+	struct OFStreamIvars *ivars = streamIvars(self);
+	size_t offset, used;
+
+	if (self->_readBufferMemory == NULL) {
+		size_t size = ivars->readBufferCapacity;
+
+		if (size < minLength)
+			size = minLength;
+
+		self->_readBuffer = self->_readBufferMemory =
+		    OFAllocMemory(size, 1);
+		ivars->readBufferSize = size;
+	}
+
+	offset = self->_readBuffer - self->_readBufferMemory;
+	used = offset + self->_readBufferLength;
+
+	if (ivars->readBufferSize - used < minLength && offset > 0) {
+		memmove(self->_readBufferMemory, self->_readBuffer,
+		    self->_readBufferLength);
+		self->_readBuffer = self->_readBufferMemory;
+		used = self->_readBufferLength;
+	}
+
+	if (ivars->readBufferSize - used < minLength) {
+		size_t size;
+
+		if (SIZE_MAX - used < minLength)
+			@throw [OFOutOfRangeException exception];
+
+		size = used + minLength;
+		if (ivars->readBufferSize <= SIZE_MAX / 2 &&
+		    size < ivars->readBufferSize * 2)
+			size = ivars->readBufferSize * 2;
+
+		self->_readBuffer = self->_readBufferMemory =
+		    OFResizeMemory(self->_readBufferMemory, size, 1);
+		ivars->readBufferSize = size;
+	}
+
+	*length = ivars->readBufferSize - used;
+	return self->_readBuffer + self->_readBufferLength;
+}
+
+static void
+clearReadBuffer(OFStream *self)
+{
+	struct OFStreamIvars *ivars = streamIvars(self);
+
+	self->_readBufferLength = 0;
+
+	/* Only keep the memory if it did not have to grow, e.g. for a line. */
+	if (ivars->readBufferSize > ivars->readBufferCapacity) {
+		OFFreeMemory(self->_readBufferMemory);
+		self->_readBufferMemory = NULL;
+		ivars->readBufferSize = 0;
+	}
+
+	self->_readBuffer = self->_readBufferMemory;
+}
+
+static OF_INLINE void
+consumeReadBuffer(OFStream *self, size_t length)
+{
+	if (length == self->_readBufferLength) {
+		clearReadBuffer(self);
+		return;
+	}
+
+	self->_readBuffer += length;
+	self->_readBufferLength -= length;
+}
+
+/*
+ * Returns the first occurrence of the delimiter in the buffer. The first byte
+ * is located using memchr, which is vectorized by most C libraries, and only
+ * then the rest is compared.
+ */
+static const char *
+findDelimiter(const char *buffer, size_t length, const char *delimiter,
+    size_t delimiterLength)
+{
+	const char *end = buffer + length;
+
+	while ((size_t)(end - buffer) >= delimiterLength) {
+		const char *match = memchr(buffer, delimiter[0],
+		    end - buffer - delimiterLength + 1);
+
+		if (match == NULL)
+			return NULL;
+
+		if (memcmp(match + 1, delimiter + 1, delimiterLength - 1) == 0)
+			return match;
+
+		buffer = match + 1;
+	}
+
+	return NULL;
+}
+
+/*
+ * Searches the read buffer for a delimiter or \0, starting at the specified
+ * offset, as everything before has already been searched. If one is found,
+ * the string before it is returned and both are consumed, otherwise nil is
+ * returned. For lines, the delimiter is \n and a preceding \r is removed.
+ *
+ * If creating the string throws, the data stays in the read buffer, so
+ * nothing is lost.
+ */
+static OFString *
+takeString(OFStream *self, size_t start, const char *delimiter,
+    size_t delimiterLength, bool isLine, OFStringEncoding encoding)
+{
+	const char *buffer = self->_readBuffer + start;
+	size_t length = self->_readBufferLength - start;
+	const char *end, *match = NULL;
+	size_t retLength, consumedLength;
+	OFString *ret;
+
+	if (length == 0)
+		return nil;
+
+	end = memchr(buffer, '\0', length);
+
+	if (delimiter != NULL)
+		match = findDelimiter(buffer,
+		    (end != NULL ? (size_t)(end - buffer) : length),
+		    delimiter, delimiterLength);
+
+	if (match != NULL) {
+		retLength = match - self->_readBuffer;
+		consumedLength = retLength + delimiterLength;
+	} else if (end != NULL) {
+		retLength = end - self->_readBuffer;
+		consumedLength = retLength + 1;
+	} else
+		return nil;
+
+	if (isLine && retLength > 0 && self->_readBuffer[retLength - 1] == '\r')
+		retLength--;
+
+	ret = [OFString stringWithCString: self->_readBuffer
+				 encoding: encoding
+				   length: retLength];
+
+	consumeReadBuffer(self, consumedLength);
+
+	return ret;
+}
+
+/*
+ * Reads into the free space at the end of the read buffer and returns a
+ * pointer to the newly read data. At least half the capacity is read at once,
+ * so that up to half the capacity can be buffered without growing the buffer.
+ */
+static char *
+fillReadBuffer(OFStream *self, size_t *length)
+{
+	size_t bufferLength;
+	char *buffer = reserveReadBuffer(self,
+	    (streamIvars(self)->readBufferCapacity + 1) / 2, &bufferLength);
+
+retry:
+	@try {
+		bufferLength = [self lowlevelReadIntoBuffer: buffer
+						     length: bufferLength];
+	} @catch (OFReadFailedException *e) {
+		if (e.errNo == EINTR)
+			goto retry;
+
+		@throw e;
+	}
+
+	self->_readBufferLength += bufferLength;
+	*length = bufferLength;
+
+	return buffer;
+}
+
 #if defined(SIGPIPE) && defined(SIG_IGN)
 + (void)initialize
 {
@@ -82,7 +334,17 @@
 			abort();
 		}
 
+		struct OFStreamIvars *ivars = OFAllocZeroedMemory(1,
+		    sizeof(*ivars));
+
+#ifdef OF_HAVE_NONFRAGILE_IVARS
+		_ivars = ivars;
+#else
+		_reserved_OFStream[0] = ivars;
+#endif
+
 		_canBlock = true;
+		ivars->readBufferCapacity = 2 * [OFSystemInfo pageSize];
 	} @catch (id e) {
 		objc_release(self);
 		@throw e;
@@ -93,12 +355,35 @@
 
 - (void)dealloc
 {
+	OFFreeMemory(streamIvars(self));
 	OFFreeMemory(_readBufferMemory);
 	OFFreeMemory(_writeBuffer);
 
 	[super dealloc];
 }
 
+#ifdef OF_HAVE_SOCKETS
+- (id)of_readBufferObserver
+{
+	return streamIvars(self)->readBufferObserver;
+}
+
+- (void)of_setReadBufferObserver: (id)readBufferObserver
+{
+	streamIvars(self)->readBufferObserver = readBufferObserver;
+}
+
+- (bool)of_isReadBufferCheckPending
+{
+	return streamIvars(self)->readBufferCheckPending;
+}
+
+- (void)of_setReadBufferCheckPending: (bool)readBufferCheckPending
+{
+	streamIvars(self)->readBufferCheckPending = readBufferCheckPending;
+}
+#endif
+
 - (size_t)lowlevelReadIntoBuffer: (void *)buffer length: (size_t)length
 {
 	OF_UNRECOGNIZED_SELECTOR
@@ -109,6 +394,34 @@
 	OF_UNRECOGNIZED_SELECTOR
 }
 
+- (size_t)lowlevelWriteBuffers: (const OFStreamBuffer *)buffers
+			 count: (size_t)count
+{
+	size_t bytesWritten = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		size_t length;
+
+		@try {
+			length = [self lowlevelWriteBuffer: buffers[i].buffer
+						    length: buffers[i].length];
+		} @catch (OFWriteFailedException *e) {
+			/* Report what has already been written instead. */
+			if (bytesWritten == 0)
+				@throw e;
+
+			return bytesWritten + e.bytesWritten;
+		}
+
+		bytesWritten += length;
+
+		if (length < buffers[i].length)
+			break;
+	}
+
+	return bytesWritten;
+}
+
 - (bool)lowlevelIsAtEndOfStream
 {
 	OF_UNRECOGNIZED_SELECTOR
@@ -134,6 +447,8 @@
 
 - (size_t)readIntoBuffer: (void *)buffer length: (size_t)length
 {
+	scheduleReadBufferCheck(self);
+
 	if (_readBufferLength == 0) {
 		/*
 		 * For small sizes, it is cheaper to read more and cache the
@@ -141,68 +456,33 @@
 		 * to do a syscall for every read.
 		 */
 		if (length < minReadSize) {
-			char tmp[minReadSize], *readBuffer;
 			size_t bytesRead;
 
-retry_1:
+			fillReadBuffer(self, &bytesRead);
+
+			if (bytesRead == 0)
+				return 0;
+		} else {
+retry:
 			@try {
-				bytesRead = [self
-				    lowlevelReadIntoBuffer: tmp
-						    length: minReadSize];
+				return [self lowlevelReadIntoBuffer: buffer
+							     length: length];
 			} @catch (OFReadFailedException *e) {
 				if (e.errNo == EINTR)
-					goto retry_1;
+					goto retry;
 
 				@throw e;
 			}
-
-			if (bytesRead > length) {
-				memcpy(buffer, tmp, length);
-
-				readBuffer = OFAllocMemory(bytesRead - length,
-				    1);
-				memcpy(readBuffer, tmp + length,
-				    bytesRead - length);
-
-				_readBuffer = _readBufferMemory = readBuffer;
-				_readBufferLength = bytesRead - length;
-
-				return length;
-			} else {
-				memcpy(buffer, tmp, bytesRead);
-				return bytesRead;
-			}
-		}
-
-retry_2:
-		@try {
-			return [self lowlevelReadIntoBuffer: buffer
-						     length: length];
-		} @catch (OFReadFailedException *e) {
-			if (e.errNo == EINTR)
-				goto retry_2;
-
-			@throw e;
 		}
 	}
 
-	if (length >= _readBufferLength) {
-		size_t ret = _readBufferLength;
-		memcpy(buffer, _readBuffer, _readBufferLength);
+	if (length > _readBufferLength)
+		length = _readBufferLength;
 
-		OFFreeMemory(_readBufferMemory);
-		_readBuffer = _readBufferMemory = NULL;
-		_readBufferLength = 0;
-
-		return ret;
-	} else {
-		memcpy(buffer, _readBuffer, length);
+	memcpy(buffer, _readBuffer, length);
+	consumeReadBuffer(self, length);
 
-		_readBuffer += length;
-		_readBufferLength -= length;
-
-		return length;
-	}
+	return length;
 }
 
 - (void)readIntoBuffer: (void *)buffer exactLength: (size_t)length
@@ -218,6 +498,46 @@ retry_2:
 	}
 }
 
+- (const void *)peekBufferWithMinimumLength: (size_t)minimumLength
+				     length: (size_t *)length
+{
+	scheduleReadBufferCheck(self);
+
+	while (_readBufferLength < minimumLength &&
+	    ![self lowlevelIsAtEndOfStream]) {
+		size_t bufferLength;
+
+		/* Make sure there is room for all of the missing data. */
+		reserveReadBuffer(self, minimumLength - _readBufferLength,
+		    &bufferLength);
+		fillReadBuffer(self, &bufferLength);
+
+		/*
+		 * A non-blocking stream might have no data available right now
+		 * without being at the end, so don't spin waiting for it.
+		 */
+		if (bufferLength == 0)
+			break;
+
+		/* The new data has not been searched for a delimiter. */
+		_waitingForDelimiter = false;
+	}
+
+	*length = _readBufferLength;
+	return (_readBufferLength > 0 ? _readBuffer : NULL);
+}
+
+- (void)consumeLength: (size_t)length
+{
+	if (length > _readBufferLength)
+		@throw [OFOutOfRangeException exception];
+
+	if (length == 0)
+		return;
+
+	consumeReadBuffer(self, length);
+}
+
 #ifdef OF_HAVE_SOCKETS
 - (void)asyncReadIntoBuffer: (void *)buffer length: (size_t)length
 {
@@ -554,164 +874,56 @@ retry_2:
 
 - (OFString *)tryReadLineWithEncoding: (OFStringEncoding)encoding
 {
-	size_t pageSize, bufferLength;
-	char *buffer, *readBuffer;
+	size_t bufferLength, oldLength;
 	OFString *ret;
 
-	/* Look if there's a line or \0 in our buffer */
-	if (!_waitingForDelimiter && _readBuffer != NULL) {
-		for (size_t i = 0; i < _readBufferLength; i++) {
-			if OF_UNLIKELY (_readBuffer[i] == '\n' ||
-			    _readBuffer[i] == '\0') {
-				size_t retLength = i;
-
-				if (i > 0 && _readBuffer[i - 1] == '\r')
-					retLength--;
-
-				ret = [OFString stringWithCString: _readBuffer
-							 encoding: encoding
-							   length: retLength];
+	scheduleReadBufferCheck(self);
 
-				_readBuffer += i + 1;
-				_readBufferLength -= i + 1;
-
-				_waitingForDelimiter = false;
-				return ret;
-			}
-		}
+	/* Look if there's a line or \0 in our buffer */
+	if (!_waitingForDelimiter &&
+	    (ret = takeString(self, 0, "\n", 1, true, encoding)) != nil) {
+		_waitingForDelimiter = false;
+		return ret;
 	}
 
-	/* Read and see if we got a newline or \0 */
-	pageSize = [OFSystemInfo pageSize];
-	buffer = OFAllocMemory(1, pageSize);
-
-	@try {
-		if ([self lowlevelIsAtEndOfStream]) {
-			size_t retLength;
-
-			if (_readBuffer == NULL) {
-				_waitingForDelimiter = false;
-				return nil;
-			}
-
-			retLength = _readBufferLength;
-
-			if (retLength > 0 && _readBuffer[retLength - 1] == '\r')
-				retLength--;
-
-			ret = [OFString stringWithCString: _readBuffer
-						 encoding: encoding
-						   length: retLength];
-
-			OFFreeMemory(_readBufferMemory);
-			_readBuffer = _readBufferMemory = NULL;
-			_readBufferLength = 0;
+	if ([self lowlevelIsAtEndOfStream]) {
+		size_t retLength;
 
+		if (_readBufferLength == 0) {
 			_waitingForDelimiter = false;
-			return ret;
+			return nil;
 		}
 
-retry:
-		@try {
-			bufferLength = [self lowlevelReadIntoBuffer: buffer
-							     length: pageSize];
-		} @catch (OFReadFailedException *e) {
-			if (e.errNo == EINTR)
-				goto retry;
-
-			@throw e;
-		}
+		retLength = _readBufferLength;
 
-		/* Look if there's a newline or \0 */
-		for (size_t i = 0; i < bufferLength; i++) {
-			if OF_UNLIKELY (buffer[i] == '\n' ||
-			    buffer[i] == '\0') {
-				size_t retLength = _readBufferLength + i;
-				char *retCString = OFAllocMemory(retLength, 1);
-
-				if (_readBuffer != NULL)
-					memcpy(retCString, _readBuffer,
-					    _readBufferLength);
-				memcpy(retCString + _readBufferLength,
-				    buffer, i);
-
-				if (retLength > 0 &&
-				    retCString[retLength - 1] == '\r')
-					retLength--;
-
-				@try {
-					ret = [OFString
-					    stringWithCString: retCString
-						     encoding: encoding
-						       length: retLength];
-				} @catch (id e) {
-					if (bufferLength > 0) {
-						/*
-						 * Append data to _readBuffer
-						 * to prevent loss of data.
-						 */
-						readBuffer = OFAllocMemory(
-						    _readBufferLength +
-						    bufferLength, 1);
-
-						memcpy(readBuffer, _readBuffer,
-						    _readBufferLength);
-						memcpy(readBuffer +
-						    _readBufferLength,
-						    buffer, bufferLength);
-
-						OFFreeMemory(_readBufferMemory);
-						_readBuffer = readBuffer;
-						_readBufferMemory = readBuffer;
-						_readBufferLength +=
-						    bufferLength;
-					}
-
-					@throw e;
-				} @finally {
-					OFFreeMemory(retCString);
-				}
-
-				readBuffer = OFAllocMemory(bufferLength - i - 1,
-				    1);
-				if (readBuffer != NULL)
-					memcpy(readBuffer, buffer + i + 1,
-					    bufferLength - i - 1);
-
-				OFFreeMemory(_readBufferMemory);
-				_readBuffer = _readBufferMemory = readBuffer;
-				_readBufferLength = bufferLength - i - 1;
-
-				_waitingForDelimiter = false;
-				return ret;
-			}
-		}
+		if (_readBuffer[retLength - 1] == '\r')
+			retLength--;
 
-		/* There was no newline or \0 */
-		if (bufferLength > 0) {
-			if (SIZE_MAX - _readBufferLength < bufferLength)
-				@throw [OFOutOfRangeException exception];
+		ret = [OFString stringWithCString: _readBuffer
+					 encoding: encoding
+					   length: retLength];
 
-			if (_maxStringReadLength > 0 &&
-			    _readBufferLength + bufferLength >
-			    _maxStringReadLength)
-				@throw [OFOutOfRangeException exception];
+		clearReadBuffer(self);
 
-			readBuffer = OFAllocMemory(
-			    _readBufferLength + bufferLength, 1);
+		_waitingForDelimiter = false;
+		return ret;
+	}
 
-			memcpy(readBuffer, _readBuffer, _readBufferLength);
-			memcpy(readBuffer + _readBufferLength,
-			    buffer, bufferLength);
+	/* Read and see if we got a newline or \0, only searching new data */
+	oldLength = _readBufferLength;
+	fillReadBuffer(self, &bufferLength);
 
-			OFFreeMemory(_readBufferMemory);
-			_readBuffer = _readBufferMemory = readBuffer;
-			_readBufferLength += bufferLength;
-		}
-	} @finally {
-		OFFreeMemory(buffer);
+	if ((ret = takeString(self, oldLength, "\n", 1, true,
+	    encoding)) != nil) {
+		_waitingForDelimiter = false;
+		return ret;
 	}
 
+	/* There was no newline or \0 */
+	if (_maxStringReadLength > 0 &&
+	    _readBufferLength > _maxStringReadLength)
+		@throw [OFOutOfRangeException exception];
+
 	_waitingForDelimiter = true;
 	return nil;
 }
@@ -894,149 +1106,49 @@ retry:
 
 - (OFString *)tryReadStringWithEncoding: (OFStringEncoding)encoding
 {
-	size_t pageSize, bufferLength;
-	char *buffer, *readBuffer;
+	size_t bufferLength, oldLength;
 	OFString *ret;
 
+	scheduleReadBufferCheck(self);
+
 	/* Look if there's something in our buffer */
-	if (!_waitingForDelimiter && _readBuffer != NULL) {
-		for (size_t i = 0; i < _readBufferLength; i++) {
-			if (_readBuffer[i] == '\0') {
-				ret = [OFString
-				    stringWithCString: _readBuffer
-					     encoding: encoding
-					       length: i];
-
-				_readBuffer += i + 1;
-				_readBufferLength -= i + 1;
-
-				_waitingForDelimiter = false;
-				return ret;
-			}
-		}
+	if (!_waitingForDelimiter &&
+	    (ret = takeString(self, 0, NULL, 0, false, encoding)) != nil) {
+		_waitingForDelimiter = false;
+		return ret;
 	}
 
-	/* Read and see if we got a \0 */
-	pageSize = [OFSystemInfo pageSize];
-	buffer = OFAllocMemory(1, pageSize);
-
-	@try {
-		if ([self lowlevelIsAtEndOfStream]) {
-			if (_readBuffer == NULL) {
-				_waitingForDelimiter = false;
-				return nil;
-			}
-
-			ret = [OFString stringWithCString: _readBuffer
-						 encoding: encoding
-						   length: _readBufferLength];
-
-			OFFreeMemory(_readBufferMemory);
-			_readBuffer = _readBufferMemory = NULL;
-			_readBufferLength = 0;
-
+	if ([self lowlevelIsAtEndOfStream]) {
+		if (_readBufferLength == 0) {
 			_waitingForDelimiter = false;
-			return ret;
-		}
-
-retry:
-		@try {
-			bufferLength = [self lowlevelReadIntoBuffer: buffer
-							     length: pageSize];
-		} @catch (OFReadFailedException *e) {
-			if (e.errNo == EINTR)
-				goto retry;
-
-			@throw e;
-		}
-
-		/* Look if there's a \0 */
-		for (size_t i = 0; i < bufferLength; i++) {
-			if (buffer[i] == '\0') {
-				size_t retLength;
-				char *retCString;
-
-				retLength = _readBufferLength + i;
-				retCString = OFAllocMemory(retLength, 1);
-
-				memcpy(retCString, _readBuffer,
-				    _readBufferLength);
-				memcpy(retCString + _readBufferLength,
-				    buffer, i);
-
-				@try {
-					ret = [OFString
-					    stringWithCString: retCString
-						     encoding: encoding
-						       length: retLength];
-				} @catch (id e) {
-					if (bufferLength > 0) {
-						/*
-						 * Append data to _readBuffer
-						 * to prevent loss of data.
-						 */
-						readBuffer = OFAllocMemory(
-						    _readBufferLength +
-						    bufferLength, 1);
-
-						memcpy(readBuffer, _readBuffer,
-						    _readBufferLength);
-						memcpy(readBuffer +
-						    _readBufferLength,
-						    buffer, bufferLength);
-
-						OFFreeMemory(_readBufferMemory);
-						_readBuffer = readBuffer;
-						_readBufferMemory = readBuffer;
-						_readBufferLength +=
-						    bufferLength;
-					}
-
-					@throw e;
-				} @finally {
-					OFFreeMemory(retCString);
-				}
-
-				readBuffer = OFAllocMemory(bufferLength - i - 1,
-				    1);
-				if (readBuffer != NULL)
-					memcpy(readBuffer, buffer + i + 1,
-					    bufferLength - i - 1);
-
-				OFFreeMemory(_readBufferMemory);
-				_readBuffer = _readBufferMemory = readBuffer;
-				_readBufferLength = bufferLength - i - 1;
-
-				_waitingForDelimiter = false;
-				return ret;
-			}
+			return nil;
 		}
 
-		/* No \0 was found */
-		if (bufferLength > 0) {
-			if (SIZE_MAX - _readBufferLength < bufferLength)
-				@throw [OFOutOfRangeException exception];
+		ret = [OFString stringWithCString: _readBuffer
+					 encoding: encoding
+					   length: _readBufferLength];
 
-			if (_maxStringReadLength > 0 &&
-			    _readBufferLength + bufferLength >
-			    _maxStringReadLength)
-				@throw [OFOutOfRangeException exception];
+		clearReadBuffer(self);
 
-			readBuffer = OFAllocMemory(
-			    _readBufferLength + bufferLength, 1);
+		_waitingForDelimiter = false;
+		return ret;
+	}
 
-			memcpy(readBuffer, _readBuffer, _readBufferLength);
-			memcpy(readBuffer + _readBufferLength,
-			    buffer, bufferLength);
+	/* Read and see if we got a \0, only searching new data */
+	oldLength = _readBufferLength;
+	fillReadBuffer(self, &bufferLength);
 
-			OFFreeMemory(_readBufferMemory);
-			_readBuffer = _readBufferMemory = readBuffer;
-			_readBufferLength += bufferLength;
-		}
-	} @finally {
-		OFFreeMemory(buffer);
+	if ((ret = takeString(self, oldLength, NULL, 0, false,
+	    encoding)) != nil) {
+		_waitingForDelimiter = false;
+		return ret;
 	}
 
+	/* No \0 was found */
+	if (_maxStringReadLength > 0 &&
+	    _readBufferLength > _maxStringReadLength)
+		@throw [OFOutOfRangeException exception];
+
 	_waitingForDelimiter = true;
 	return nil;
 }
@@ -1050,175 +1162,63 @@ retry:
 			   encoding: (OFStringEncoding)encoding
 {
 	const char *delimiterCString;
-	size_t j, delimiterLength, pageSize, bufferLength;
-	char *buffer, *readBuffer;
+	size_t delimiterLength, bufferLength, start;
 	OFString *ret;
 
+	scheduleReadBufferCheck(self);
+
 	delimiterCString = [delimiter cStringWithEncoding: encoding];
 	delimiterLength = [delimiter cStringLengthWithEncoding: encoding];
-	j = 0;
 
 	if (delimiterLength == 0)
 		@throw [OFInvalidArgumentException exception];
 
 	/* Look if there's something in our buffer */
-	if (!_waitingForDelimiter && _readBuffer != NULL) {
-		for (size_t i = 0; i < _readBufferLength; i++) {
-			if (_readBuffer[i] != delimiterCString[j++])
-				j = 0;
-
-			if (j == delimiterLength || _readBuffer[i] == '\0') {
-				if (_readBuffer[i] == '\0')
-					delimiterLength = 1;
-
-				ret = [OFString
-				    stringWithCString: _readBuffer
-					     encoding: encoding
-					       length: i + 1 - delimiterLength];
-
-				_readBuffer += i + 1;
-				_readBufferLength -= i + 1;
-
-				_waitingForDelimiter = false;
-				return ret;
-			}
-		}
+	if (!_waitingForDelimiter &&
+	    (ret = takeString(self, 0, delimiterCString, delimiterLength,
+	    false, encoding)) != nil) {
+		_waitingForDelimiter = false;
+		return ret;
 	}
 
-	/* Read and see if we got a delimiter or \0 */
-	pageSize = [OFSystemInfo pageSize];
-	buffer = OFAllocMemory(1, pageSize);
-
-	@try {
-		if ([self lowlevelIsAtEndOfStream]) {
-			if (_readBuffer == NULL) {
-				_waitingForDelimiter = false;
-				return nil;
-			}
-
-			ret = [OFString stringWithCString: _readBuffer
-						 encoding: encoding
-						   length: _readBufferLength];
-
-			OFFreeMemory(_readBufferMemory);
-			_readBuffer = _readBufferMemory = NULL;
-			_readBufferLength = 0;
-
+	if ([self lowlevelIsAtEndOfStream]) {
+		if (_readBufferLength == 0) {
 			_waitingForDelimiter = false;
-			return ret;
-		}
-
-retry:
-		@try {
-			bufferLength = [self lowlevelReadIntoBuffer: buffer
-							     length: pageSize];
-		} @catch (OFReadFailedException *e) {
-			if (e.errNo == EINTR)
-				goto retry;
-
-			@throw e;
+			return nil;
 		}
 
-		/* Look if there's a delimiter or \0 */
-		for (size_t i = 0; i < bufferLength; i++) {
-			if (buffer[i] != delimiterCString[j++])
-				j = 0;
-
-			if (j == delimiterLength || buffer[i] == '\0') {
-				size_t retLength;
-				char *retCString;
-
-				if (buffer[i] == '\0')
-					delimiterLength = 1;
-
-				retLength = _readBufferLength + i + 1 -
-				    delimiterLength;
-				retCString = OFAllocMemory(retLength, 1);
-
-				if (_readBuffer != NULL &&
-				    _readBufferLength <= retLength)
-					memcpy(retCString, _readBuffer,
-					    _readBufferLength);
-				else if (_readBuffer != NULL)
-					memcpy(retCString, _readBuffer,
-					    retLength);
-				if (i >= delimiterLength)
-					memcpy(retCString + _readBufferLength,
-					    buffer, i + 1 - delimiterLength);
-
-				@try {
-					ret = [OFString
-					    stringWithCString: retCString
-						     encoding: encoding
-						       length: retLength];
-				} @catch (id e) {
-					if (bufferLength > 0) {
-						/*
-						 * Append data to _readBuffer
-						 * to prevent loss of data.
-						 */
-						readBuffer = OFAllocMemory(
-						    _readBufferLength +
-						    bufferLength, 1);
-
-						memcpy(readBuffer, _readBuffer,
-						    _readBufferLength);
-						memcpy(readBuffer +
-						    _readBufferLength,
-						    buffer, bufferLength);
-
-						OFFreeMemory(_readBufferMemory);
-						_readBuffer = readBuffer;
-						_readBufferMemory = readBuffer;
-						_readBufferLength +=
-						    bufferLength;
-					}
-
-					@throw e;
-				} @finally {
-					OFFreeMemory(retCString);
-				}
-
-				readBuffer = OFAllocMemory(bufferLength - i - 1,
-				    1);
-				if (readBuffer != NULL)
-					memcpy(readBuffer, buffer + i + 1,
-					    bufferLength - i - 1);
-
-				OFFreeMemory(_readBufferMemory);
-				_readBuffer = _readBufferMemory = readBuffer;
-				_readBufferLength = bufferLength - i - 1;
-
-				_waitingForDelimiter = false;
-				return ret;
-			}
-		}
+		ret = [OFString stringWithCString: _readBuffer
+					 encoding: encoding
+					   length: _readBufferLength];
 
-		/* Neither the delimiter nor \0 was found */
-		if (bufferLength > 0) {
-			if (SIZE_MAX - _readBufferLength < bufferLength)
-				@throw [OFOutOfRangeException exception];
+		clearReadBuffer(self);
 
-			if (_maxStringReadLength > 0 &&
-			    _readBufferLength + bufferLength >
-			    _maxStringReadLength)
-				@throw [OFOutOfRangeException exception];
+		_waitingForDelimiter = false;
+		return ret;
+	}
 
-			readBuffer = OFAllocMemory(
-			    _readBufferLength + bufferLength, 1);
+	/*
+	 * Read and see if we got a delimiter or \0. Only new data needs to be
+	 * searched, plus the end of the old data, as the delimiter could
+	 * start there.
+	 */
+	start = 0;
+	if (_readBufferLength >= delimiterLength)
+		start = _readBufferLength - delimiterLength + 1;
 
-			memcpy(readBuffer, _readBuffer, _readBufferLength);
-			memcpy(readBuffer + _readBufferLength,
-			    buffer, bufferLength);
+	fillReadBuffer(self, &bufferLength);
 
-			OFFreeMemory(_readBufferMemory);
-			_readBuffer = _readBufferMemory = readBuffer;
-			_readBufferLength += bufferLength;
-		}
-	} @finally {
-		OFFreeMemory(buffer);
+	if ((ret = takeString(self, start, delimiterCString, delimiterLength,
+	    false, encoding)) != nil) {
+		_waitingForDelimiter = false;
+		return ret;
 	}
 
+	/* Neither the delimiter nor \0 was found */
+	if (_maxStringReadLength > 0 &&
+	    _readBufferLength > _maxStringReadLength)
+		@throw [OFOutOfRangeException exception];
+
 	_waitingForDelimiter = true;
 	return nil;
 }
@@ -1325,6 +1325,178 @@ retry:
 	}
 }
 
+- (void)writeBuffers: (const OFStreamBuffer *)buffers count: (size_t)count
+{
+	if (_buffersWrites) {
+		for (size_t i = 0; i < count; i++)
+			[self writeBuffer: buffers[i].buffer
+				   length: buffers[i].length];
+
+		return;
+	}
+
+	while (count > 0) {
+		size_t batchCount = (count < maxWriteBuffers
+		    ? count : maxWriteBuffers);
+		size_t length = 0, bytesWritten;
+
+		for (size_t i = 0; i < batchCount; i++) {
+			if (SIZE_MAX - length < buffers[i].length)
+				@throw [OFOutOfRangeException exception];
+
+			length += buffers[i].length;
+		}
+
+retry:
+		@try {
+			bytesWritten = [self lowlevelWriteBuffers: buffers
+							    count: batchCount];
+		} @catch (OFWriteFailedException *e) {
+			if (e.errNo == EINTR)
+				goto retry;
+
+			@throw e;
+		}
+
+		if (bytesWritten < length)
+			@throw [OFWriteFailedException
+			    exceptionWithObject: self
+				requestedLength: length
+				   bytesWritten: bytesWritten
+					  errNo: 0];
+
+		buffers += batchCount;
+		count -= batchCount;
+	}
+}
+
+#ifdef USE_SENDFILE
+/*
+ * Lets the kernel copy from a file into a file or socket without the data
+ * passing through user space. Adds the bytes written to *bytesWritten. Returns
+ * false without having written anything if the kernel does not support this for
+ * the file descriptors.
+ */
+static bool
+sendFile(OFStream *self, OFStream *stream, unsigned long long length,
+    unsigned long long *bytesWritten)
+{
+	unsigned long long start = *bytesWritten;
+	int outFD, inFD;
+
+	if (![stream isKindOfClass: [OFFile class]])
+		return false;
+
+	/*
+	 * Other streams might hand out the file descriptor of a stream they
+	 * wrap, e.g. a TLS stream, so only accept the classes known to write
+	 * to their file descriptor unmodified.
+	 */
+	if ([self isKindOfClass: [OFFile class]])
+		outFD = ((OFFile *)self).fileDescriptorForWriting;
+# ifdef OF_HAVE_SOCKETS
+	else if ([self isKindOfClass: [OFStreamSocket class]])
+		outFD = ((OFStreamSocket *)self).fileDescriptorForWriting;
+# endif
+	else
+		return false;
+
+	inFD = ((OFFile *)stream).fileDescriptorForReading;
+
+# ifdef OF_HAVE_ASYNC_FILE_IO
+	/* sendfile() uses the file positions, so they need to be settled. */
+	[(OFFile *)stream of_finishAsyncOperation];
+	if ([self isKindOfClass: [OFFile class]])
+		[(OFFile *)self of_finishAsyncOperation];
+# endif
+
+	while (*bytesWritten < length) {
+		/* Linux never transfers more than this at once. */
+		size_t chunkLength = 0x7FFFF000;
+		ssize_t ret;
+
+		if (length - *bytesWritten < chunkLength)
+			chunkLength = (size_t)(length - *bytesWritten);
+
+		if ((ret = sendfile(outFD, inFD, NULL, chunkLength)) < 0) {
+			if (errno == EINTR)
+				continue;
+
+			if (*bytesWritten == start &&
+			    (errno == EINVAL || errno == ENOSYS))
+				return false;
+
+			/*
+			 * This includes EWOULDBLOCK / EAGAIN for non-blocking
+			 * streams, for which the caller needs to know how much
+			 * was written, just like with -[writeBuffer:length:].
+			 */
+			@throw [OFWriteFailedException
+			    exceptionWithObject: self
+				requestedLength: (size_t)length
+				   bytesWritten: (size_t)*bytesWritten
+					  errNo: errno];
+		}
+
+		/* End of file */
+		if (ret == 0) {
+			[(OFFile *)stream of_setAtEndOfStream];
+			break;
+		}
+
+		*bytesWritten += ret;
+	}
+
+	return true;
+}
+#endif
+
+- (unsigned long long)writeContentsOfStream: (OFStream *)stream
+				     length: (unsigned long long)length
+{
+	unsigned long long bytesWritten = 0;
+#ifdef USE_SENDFILE
+	bool triedSendFile = false;
+#endif
+
+	while (bytesWritten < length) {
+		size_t bufferLength;
+		const void *buffer;
+
+		/* Data already read into the buffer has to be written first. */
+		buffer = [stream peekBufferWithMinimumLength: 0
+						      length: &bufferLength];
+
+		if (buffer == NULL) {
+#ifdef USE_SENDFILE
+			if (!_buffersWrites && !triedSendFile) {
+				triedSendFile = true;
+
+				if (sendFile(self, stream, length,
+				    &bytesWritten))
+					return bytesWritten;
+			}
+#endif
+
+			buffer = [stream
+			    peekBufferWithMinimumLength: 1
+						 length: &bufferLength];
+
+			if (buffer == NULL)
+				break;
+		}
+
+		if (bufferLength > length - bytesWritten)
+			bufferLength = (size_t)(length - bytesWritten);
+
+		[self writeBuffer: buffer length: bufferLength];
+		[stream consumeLength: bufferLength];
+		bytesWritten += bufferLength;
+	}
+
+	return bytesWritten;
+}
+
 #ifdef OF_HAVE_SOCKETS
 - (void)asyncWriteData: (OFData *)data
 {
@@ -1720,6 +1892,22 @@ retry:
 	_maxStringReadLength = maxStringReadLength;
 }
 
+- (size_t)readBufferCapacity
+{
+	return streamIvars(self)->readBufferCapacity;
+}
+
+- (void)setReadBufferCapacity: (size_t)readBufferCapacity
+{
+	if (readBufferCapacity == 0)
+		@throw [OFInvalidArgumentException exception];
+
+	streamIvars(self)->readBufferCapacity = readBufferCapacity;
+
+	if (_readBufferLength == 0)
+		clearReadBuffer(self);
+}
+
 - (bool)canBlock
 {
 	return _canBlock;
@@ -1811,25 +1999,40 @@ retry:
 
 - (void)unreadFromBuffer: (const void *)buffer length: (size_t)length
 {
-	char *readBuffer;
+	size_t offset;
 
 	if (length > SIZE_MAX - _readBufferLength)
 		@throw [OFOutOfRangeException exception];
 
-	readBuffer = OFAllocMemory(_readBufferLength + length, 1);
-	memcpy(readBuffer, buffer, length);
-	memcpy(readBuffer + length, _readBuffer, _readBufferLength);
+	if (length == 0)
+		return;
 
-	OFFreeMemory(_readBufferMemory);
-	_readBuffer = _readBufferMemory = readBuffer;
+	scheduleReadBufferCheck(self);
+
+	offset = _readBuffer - _readBufferMemory;
+
+	if (offset < length) {
+		size_t bufferLength;
+
+		/* Make room at the end and move the data behind the gap. */
+		reserveReadBuffer(self, length, &bufferLength);
+
+		offset = _readBuffer - _readBufferMemory;
+		memmove(_readBuffer + length - offset, _readBuffer,
+		    _readBufferLength);
+		_readBuffer += length - offset;
+	}
+
+	_readBuffer -= length;
 	_readBufferLength += length;
+	memcpy(_readBuffer, buffer, length);
 }
 
 - (void)close
 {
 	OFFreeMemory(_readBufferMemory);
 	_readBuffer = _readBufferMemory = NULL;
-	_readBufferLength = 0;
+	_readBufferLength = streamIvars(self)->readBufferSize = 0;
 
 	OFFreeMemory(_writeBuffer);
 	_writeBuffer = NULL;
@@ -27,6 +27,10 @@
 #include <errno.h>
 #include <string.h>
 
+#ifdef HAVE_SYS_UIO_H
+# include <sys/uio.h>
+#endif
+
 #import "OFStreamSocket.h"
 #import "OFStreamSocket+Private.h"
 #import "OFRunLoop.h"
@@ -166,6 +170,42 @@
 	return (size_t)bytesWritten;
 }
 
+#if defined(HAVE_WRITEV) && !defined(OF_WINDOWS) && !defined(OF_AMIGAOS) && \
+    !defined(OF_WII) && !defined(OF_NINTENDO_3DS)
+- (size_t)lowlevelWriteBuffers: (const OFStreamBuffer *)buffers
+			 count: (size_t)count
+{
+	struct iovec iov[16];
+	size_t length = 0;
+	ssize_t bytesWritten;
+
+	if (_socket == OFInvalidSocketHandle)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	/* Any further buffers are left for the caller as a short write. */
+	if (count > sizeof(iov) / sizeof(*iov))
+		count = sizeof(iov) / sizeof(*iov);
+
+	for (size_t i = 0; i < count; i++) {
+		if (buffers[i].length > SSIZE_MAX - length)
+			@throw [OFOutOfRangeException exception];
+
+		iov[i].iov_base = (void *)buffers[i].buffer;
+		iov[i].iov_len = buffers[i].length;
+		length += buffers[i].length;
+	}
+
+	if ((bytesWritten = writev(_socket, iov, (int)count)) < 0)
+		@throw [OFWriteFailedException
+		    exceptionWithObject: self
+			requestedLength: length
+			   bytesWritten: 0
+				  errNo: _OFSocketErrNo()];
+
+	return (size_t)bytesWritten;
+}
+#endif
+
 #if defined(OF_WINDOWS) || defined(OF_AMIGAOS)
 - (void)setCanBlock: (bool)canBlock
 {
@@ -130,6 +130,18 @@ typedef void (^OFTCPSocketConnectedHandler)(OFTCPSocket *socket,
  */
 @property (nonatomic) bool allowsMPTCP;
 
+/**
+ * @brief Whether the socket sets `SO_REUSEPORT` when binding.
+ *
+ * This allows multiple sockets to bind to the same host and port, with the
+ * kernel distributing incoming connections between them. Set this to true
+ * on all sockets that should share the port before binding them.
+ *
+ * @throw OFNotImplementedException `SO_REUSEPORT` is not supported on this
+ *				    platform
+ */
+@property (nonatomic) bool reusesPort;
+
 /**
  * @brief The host to use as a SOCKS5 proxy.
  */
@@ -62,7 +62,8 @@
 enum {
 	flagAllowsMPTCP = 1,
 	flagMapIPv4 = 2,
-	flagUseConnectX = 4
+	flagUseConnectX = 4,
+	flagReusesPort = 8
 };
 
 static const OFRunLoopMode connectRunLoopMode =
@@ -504,6 +505,24 @@ mapIPv4(const OFSocketAddress *IPv4Address)
 	setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR,
 	    (char *)&one, (socklen_t)sizeof(one));
 
+#ifdef SO_REUSEPORT
+	if (_flags & flagReusesPort) {
+		if (setsockopt(_socket, SOL_SOCKET, SO_REUSEPORT,
+		    (char *)&one, (socklen_t)sizeof(one)) != 0) {
+			int errNo = _OFSocketErrNo();
+
+			closesocket(_socket);
+			_socket = OFInvalidSocketHandle;
+
+			@throw [OFBindIPSocketFailedException
+			    exceptionWithHost: host
+					 port: port
+				       socket: self
+					errNo: errNo];
+		}
+	}
+#endif
+
 #if defined(OF_HPUX) || defined(OF_WII) || defined(OF_NINTENDO_3DS)
 	if (port != 0) {
 #endif
@@ -671,6 +690,25 @@ mapIPv4(const OFSocketAddress *IPv4Address)
 	return (_flags & flagAllowsMPTCP);
 }
 
+- (void)setReusesPort: (bool)reusesPort
+{
+#ifdef SO_REUSEPORT
+	if (reusesPort)
+		_flags |= flagReusesPort;
+	else
+		_flags &= ~flagReusesPort;
+#else
+	if (reusesPort)
+		@throw [OFNotImplementedException exceptionWithSelector: _cmd
+								 object: self];
+#endif
+}
+
+- (bool)reusesPort
+{
+	return (_flags & flagReusesPort);
+}
+
 - (void)close
 {
 #ifdef OF_WII
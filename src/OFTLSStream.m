@@ -19,12 +19,15 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #import "OFTLSStream.h"
 #import "OFArray.h"
 #import "OFDate.h"
 
 #import "OFNotImplementedException.h"
 #import "OFTLSHandshakeFailedException.h"
+#import "OFWriteFailedException.h"
 
 @interface OFTLSStreamHandshakeDelegate: OFObject <OFTLSStreamDelegate>
 {
@@ -201,6 +204,67 @@ OFTLSStreamErrorCodeDescription(OFTLSStreamErrorCode errorCode)
 	return _atEndOfStream;
 }
 
+static bool
+writeBuffer(OFTLSStream *self, const void *buffer, size_t length,
+    size_t *bytesWritten)
+{
+	size_t written;
+
+	@try {
+		written = [self lowlevelWriteBuffer: buffer length: length];
+	} @catch (OFWriteFailedException *e) {
+		/* Report what has already been written instead. */
+		if (*bytesWritten == 0)
+			@throw e;
+
+		*bytesWritten += e.bytesWritten;
+		return false;
+	}
+
+	*bytesWritten += written;
+	return (written == length);
+}
+
+- (size_t)lowlevelWriteBuffers: (const OFStreamBuffer *)buffers
+			 count: (size_t)count
+{
+	/*
+	 * Small buffers, e.g. protocol framing, are collected and written at
+	 * once, so that they end up in a single TLS record and a single write
+	 * on the underlying stream instead of one each.
+	 */
+	char coalesced[1024];
+	size_t coalescedLength = 0, bytesWritten = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		if (coalescedLength > 0 &&
+		    buffers[i].length > sizeof(coalesced) - coalescedLength) {
+			if (!writeBuffer(self, coalesced, coalescedLength,
+			    &bytesWritten))
+				return bytesWritten;
+
+			coalescedLength = 0;
+		}
+
+		if (buffers[i].length > sizeof(coalesced)) {
+			if (!writeBuffer(self, buffers[i].buffer,
+			    buffers[i].length, &bytesWritten))
+				return bytesWritten;
+
+			continue;
+		}
+
+		memcpy(coalesced + coalescedLength, buffers[i].buffer,
+		    buffers[i].length);
+		coalescedLength += buffers[i].length;
+	}
+
+	if (coalescedLength > 0)
+		writeBuffer(self, coalesced, coalescedLength, &bytesWritten);
+
+	return bytesWritten;
+}
+
 - (int)fileDescriptorForReading
 {
 	return _underlyingStream.fileDescriptorForReading;
@@ -26,6 +26,8 @@ OF_DIRECT_MEMBERS
 - (void)of_setInRunLoop: (nullable OFRunLoop *)runLoop
 		   mode: (nullable OFRunLoopMode)mode;
 - (void)of_reschedule;
+- (size_t)of_timerQueueIndex;
+- (void)of_setTimerQueueIndex: (size_t)index;
 @end
 
 OF_ASSUME_NONNULL_END
@@ -48,7 +48,7 @@ OF_SUBCLASSING_RESTRICTED
 @interface OFTimer: OFObject <OFComparing>
 {
 	OFDate *_fireDate;
-	OFTimeInterval _interval;
+	OFTimeInterval _interval, _tolerance;
 	id _target;
 	id _Nullable _object1, _object2, _object3, _object4;
 	SEL _selector;
@@ -64,6 +64,7 @@ OF_SUBCLASSING_RESTRICTED
 #endif
 	OFRunLoop *_Nullable _inRunLoop;
 	OFRunLoopMode _Nullable _inRunLoopMode;
+	size_t _timerQueueIndex;
 }
 
 /**
@@ -92,6 +93,19 @@ OF_SUBCLASSING_RESTRICTED
  */
 @property (copy, nonatomic) OFDate *fireDate;
 
+/**
+ * @brief The amount of time after the fire date the timer may be delayed.
+ *
+ * A tolerance allows the run loop to fire multiple timers whose fire dates are
+ * close to each other with a single wakeup. The timer will never fire before
+ * its fire date, but it might fire up to the tolerance after it.
+ *
+ * The default is 0, meaning the timer fires as close to its fire date as
+ * possible. If the timer is already scheduled in a run loop, it will be
+ * rescheduled.
+ */
+@property (nonatomic) OFTimeInterval tolerance;
+
 /**
  * @brief Creates and schedules a new timer with the specified time interval.
  *
@@ -528,6 +528,16 @@
 	objc_release(oldInRunLoopMode);
 }
 
+- (size_t)of_timerQueueIndex
+{
+	return _timerQueueIndex;
+}
+
+- (void)of_setTimerQueueIndex: (size_t)index
+{
+	_timerQueueIndex = index;
+}
+
 - (void)of_reschedule
 {
 	long long missedIntervals;
@@ -634,6 +644,31 @@
 	}
 }
 
+- (OFTimeInterval)tolerance
+{
+	return _tolerance;
+}
+
+- (void)setTolerance: (OFTimeInterval)tolerance
+{
+	if (tolerance < 0)
+		@throw [OFInvalidArgumentException exception];
+
+	objc_retain(self);
+	@try {
+		@synchronized (self) {
+			[_inRunLoop of_removeTimer: self
+					   forMode: _inRunLoopMode];
+
+			_tolerance = tolerance;
+
+			[_inRunLoop addTimer: self forMode: _inRunLoopMode];
+		}
+	} @finally {
+		objc_release(self);
+	}
+}
+
 - (void)invalidate
 {
 	_valid = false;
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2008-2026 Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3.0 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * version 3.0 along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#import "OFObject.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFTimer;
+
+/*
+ * An entry of the timer queue. The fire date is cached as a time interval so
+ * that comparisons don't need to send messages, and the sequence number keeps
+ * timers with the same fire date in the order they were added. The deadline is
+ * the fire date plus the timer's tolerance.
+ */
+typedef struct {
+	OFTimeInterval fireTime, deadline;
+	unsigned long long sequence;
+	OFTimer *timer;
+} OFTimerQueueEntry;
+
+/*
+ * A 4-ary min-heap of timers ordered by their fire date. Each timer remembers
+ * its index in the heap, making both insertion and removal O(log n).
+ */
+OF_DIRECT_MEMBERS
+@interface OFTimerQueue: OFObject
+{
+	OFTimerQueueEntry *_entries;
+	size_t _count, _capacity;
+	unsigned long long _nextSequence;
+}
+
+@property (readonly, nonatomic) size_t count;
+@property OF_NULLABLE_PROPERTY (readonly, nonatomic) OFTimer *firstTimer;
+
+/*
+ * The latest time at which the run loop needs to wake up in order to fire the
+ * first timer as well as all timers whose tolerance windows overlap with it.
+ * Only a bounded number of timers is searched, so with many overlapping timers
+ * this can be earlier, but never later than any timer's deadline. Only valid
+ * if count is not 0.
+ */
+@property (readonly, nonatomic) OFTimeInterval nextWakeupTime;
+
+- (void)addTimer: (OFTimer *)timer;
+- (void)removeTimer: (OFTimer *)timer;
+- (nullable OFTimer *)removeFirstTimerDueAt: (OFTimeInterval)time;
+@end
+
+OF_ASSUME_NONNULL_END
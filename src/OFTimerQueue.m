@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2008-2026 Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3.0 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * version 3.0 along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#import "OFTimerQueue.h"
+#import "OFDate.h"
+#import "OFTimer.h"
+#import "OFTimer+Private.h"
+
+#import "OFOutOfMemoryException.h"
+#import "OFOutOfRangeException.h"
+
+static const size_t minCapacity = 16;
+/* Bounds the work done per run loop iteration with many timers. */
+static const size_t maxDeadlineSearchEntries = 32;
+
+static OF_INLINE bool
+entryLessThan(const OFTimerQueueEntry *a, const OFTimerQueueEntry *b)
+{
+	if (a->fireTime != b->fireTime)
+		return (a->fireTime < b->fireTime);
+
+	return (a->sequence < b->sequence);
+}
+
+@implementation OFTimerQueue
+@synthesize count = _count;
+
+static OF_INLINE void
+moveEntry(OFTimerQueue *self, size_t index, const OFTimerQueueEntry *entry)
+{
+	self->_entries[index] = *entry;
+	[entry->timer of_setTimerQueueIndex: index];
+}
+
+static void
+siftUp(OFTimerQueue *self, size_t index)
+{
+	OFTimerQueueEntry entry = self->_entries[index];
+
+	while (index > 0) {
+		size_t parent = (index - 1) / 4;
+
+		if (!entryLessThan(&entry, &self->_entries[parent]))
+			break;
+
+		moveEntry(self, index, &self->_entries[parent]);
+		index = parent;
+	}
+
+	moveEntry(self, index, &entry);
+}
+
+static void
+siftDown(OFTimerQueue *self, size_t index)
+{
+	OFTimerQueueEntry entry = self->_entries[index];
+
+	for (;;) {
+		size_t first = 4 * index + 1, smallest = index, last;
+		const OFTimerQueueEntry *smallestEntry = &entry;
+
+		if (first >= self->_count)
+			break;
+
+		last = (self->_count - first > 4 ? first + 4 : self->_count);
+
+		for (size_t i = first; i < last; i++) {
+			if (entryLessThan(&self->_entries[i], smallestEntry)) {
+				smallest = i;
+				smallestEntry = &self->_entries[i];
+			}
+		}
+
+		if (smallest == index)
+			break;
+
+		moveEntry(self, index, smallestEntry);
+		index = smallest;
+	}
+
+	moveEntry(self, index, &entry);
+}
+
+static void
+removeEntryAtIndex(OFTimerQueue *self, size_t index)
+{
+	OFTimer *timer = self->_entries[index].timer;
+	size_t last = --self->_count;
+
+	if (index != last) {
+		bool up;
+
+		up = entryLessThan(&self->_entries[last],
+		    &self->_entries[index]);
+		moveEntry(self, index, &self->_entries[last]);
+
+		if (up)
+			siftUp(self, index);
+		else
+			siftDown(self, index);
+	}
+
+	objc_release(timer);
+}
+
+static void
+findEarliestDeadline(OFTimerQueue *self, size_t index,
+    OFTimeInterval *deadline, size_t *budget)
+{
+	size_t first = 4 * index + 1, last;
+
+	if (first >= self->_count)
+		return;
+
+	last = (self->_count - first > 4 ? first + 4 : self->_count);
+
+	/*
+	 * Children always fire after their parent, so only subtrees whose root
+	 * fires before the current deadline can contain an earlier deadline.
+	 */
+	for (size_t i = first; i < last; i++) {
+		if (self->_entries[i].fireTime >= *deadline)
+			continue;
+
+		/*
+		 * Once the budget is used up, wake up when the subtree starts
+		 * firing instead of searching it. This coalesces less, but no
+		 * timer in it can miss its deadline.
+		 */
+		if (*budget == 0) {
+			*deadline = self->_entries[i].fireTime;
+			continue;
+		}
+		(*budget)--;
+
+		if (self->_entries[i].deadline < *deadline)
+			*deadline = self->_entries[i].deadline;
+
+		findEarliestDeadline(self, i, deadline, budget);
+	}
+}
+
+- (void)dealloc
+{
+	for (size_t i = 0; i < _count; i++)
+		objc_release(_entries[i].timer);
+
+	OFFreeMemory(_entries);
+
+	[super dealloc];
+}
+
+- (OFTimer *)firstTimer
+{
+	if (_count == 0)
+		return nil;
+
+	return _entries[0].timer;
+}
+
+- (OFTimeInterval)nextWakeupTime
+{
+	OFTimeInterval deadline;
+	size_t budget = maxDeadlineSearchEntries;
+
+	OFAssert(_count > 0);
+
+	deadline = _entries[0].deadline;
+	findEarliestDeadline(self, 0, &deadline, &budget);
+
+	return deadline;
+}
+
+- (void)addTimer: (OFTimer *)timer
+{
+	OFTimerQueueEntry entry;
+
+	if (_count == SIZE_MAX)
+		@throw [OFOutOfRangeException exception];
+
+	if (_count >= _capacity) {
+		size_t newCapacity = (_capacity > 0 ? _capacity : minCapacity);
+
+		while (newCapacity <= _count) {
+			if (newCapacity > SIZE_MAX / 2)
+				@throw [OFOutOfRangeException exception];
+
+			newCapacity *= 2;
+		}
+
+		_entries = OFResizeMemory(_entries, newCapacity,
+		    sizeof(*_entries));
+		_capacity = newCapacity;
+	}
+
+	entry.fireTime = timer.fireDate.timeIntervalSince1970;
+	entry.deadline = entry.fireTime + timer.tolerance;
+	entry.sequence = _nextSequence++;
+	entry.timer = objc_retain(timer);
+
+	_entries[_count] = entry;
+	siftUp(self, _count++);
+}
+
+- (void)removeTimer: (OFTimer *)timer
+{
+	size_t index = [timer of_timerQueueIndex];
+
+	/*
+	 * A timer that has been added to multiple queues only remembers its
+	 * index in the queue it was added to last, so fall back to a linear
+	 * search if the index does not match.
+	 */
+	if (index >= _count || _entries[index].timer != timer) {
+		for (index = 0; index < _count; index++)
+			if (_entries[index].timer == timer)
+				break;
+
+		if (index == _count)
+			return;
+	}
+
+	removeEntryAtIndex(self, index);
+}
+
+- (OFTimer *)removeFirstTimerDueAt: (OFTimeInterval)time
+{
+	OFTimer *timer;
+
+	if (_count == 0 || _entries[0].fireTime > time)
+		return nil;
+
+	timer = objc_retainAutorelease(_entries[0].timer);
+	removeEntryAtIndex(self, 0);
+
+	if (_count < _capacity / 4 && _capacity > minCapacity) {
+		@try {
+			_entries = OFResizeMemory(_entries, _capacity / 2,
+			    sizeof(*_entries));
+			_capacity /= 2;
+		} @catch (OFOutOfMemoryException *e) {
+			/* We don't care, as we only made it smaller */
+		}
+	}
+
+	return timer;
+}
+@end
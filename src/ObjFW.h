@@ -26,6 +26,9 @@
 #import "OFData.h"
 #import "OFArray.h"
 #import "OFSecureData.h"
+#ifdef OF_HAVE_FILES
+# import "OFMappedData.h"
+#endif
 
 #import "OFList.h"
 #import "OFSortedList.h"
@@ -81,6 +84,7 @@
 #import "OFZooArchive.h"
 #import "OFZooArchiveEntry.h"
 #import "OFFileManager.h"
+#import "OFDirectoryEnumerator.h"
 #ifdef OF_HAVE_FILES
 # import "OFFile.h"
 #endif
@@ -127,6 +131,7 @@
 # import "OFHTTPRequest.h"
 # import "OFHTTPResponse.h"
 # import "OFHTTPServer.h"
+# import "OFHTTPStaticFileHandler.h"
 # import "OFTitanRequest.h"
 #endif
 
@@ -163,6 +168,7 @@
 #import "OFOptionsParser.h"
 #import "OFTimer.h"
 #import "OFRunLoop.h"
+#import "OFRunLoopStatistics.h"
 
 #import "OFMatrix4x4.h"
 
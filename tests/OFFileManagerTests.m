@@ -186,6 +186,130 @@
 	    _testFileIRI.fileSystemRepresentation, nil]));
 }
 
+- (void)testEnumeratorAtIRI
+{
+	OFIRI *subdirectoryIRI = [_testsDirectoryIRI
+	    IRIByAppendingPathComponent: @"a"];
+	OFIRI *fileIRI = [subdirectoryIRI
+	    IRIByAppendingPathComponent: @"1.txt"];
+	OFMutableSet *IRIs = [OFMutableSet set];
+	OFDirectoryEnumerator *enumerator;
+
+	[_fileManager createDirectoryAtIRI: subdirectoryIRI];
+	[@"1" writeToIRI: fileIRI];
+
+	enumerator = [_fileManager
+	    enumeratorAtIRI: _testsDirectoryIRI
+		    options: 0
+	      attributeKeys: [OFArray arrayWithObject: OFFileSize]];
+
+	for (OFIRI *IRI in enumerator) {
+		OFFileAttributes attributes = enumerator.currentAttributes;
+
+		OTAssertEqual(enumerator.currentLevel, 1);
+
+		if ([IRI.lastPathComponent isEqual: @"a"])
+			OTAssertEqualObjects(attributes.fileType,
+			    OFFileTypeDirectory);
+		else {
+			OTAssertEqualObjects(attributes.fileType,
+			    OFFileTypeRegular);
+			OTAssertEqual(attributes.fileSize, 4);
+		}
+
+		[IRIs addObject: IRI.lastPathComponent];
+	}
+
+	OTAssertEqualObjects(IRIs,
+	    ([OFSet setWithObjects: @"a", @"test.txt", nil]));
+}
+
+- (void)testRecursiveEnumeratorAtIRI
+{
+	OFIRI *subdirectory1IRI = [_testsDirectoryIRI
+	    IRIByAppendingPathComponent: @"a"];
+	OFIRI *subdirectory2IRI = [subdirectory1IRI
+	    IRIByAppendingPathComponent: @"b"];
+	OFIRI *file1IRI = [subdirectory1IRI
+	    IRIByAppendingPathComponent: @"1.txt"];
+	OFIRI *file2IRI = [subdirectory2IRI
+	    IRIByAppendingPathComponent: @"2.txt"];
+	OFSet *expected;
+
+	[_fileManager createDirectoryAtIRI: subdirectory2IRI
+			     createParents: true];
+	[@"1" writeToIRI: file1IRI];
+	[@"2" writeToIRI: file2IRI];
+
+	expected = [OFSet setWithObjects: @"test.txt", @"a", @"a/1.txt",
+	    @"a/b", @"a/b/2.txt", nil];
+
+	for (int i = 0; i < 2; i++) {
+		OFDirectoryEnumeratorOptions options =
+		    OFDirectoryEnumeratorOptionRecursive;
+		OFMutableSet *paths = [OFMutableSet set];
+		OFDirectoryEnumerator *enumerator;
+
+		if (i == 1)
+			options |= OFDirectoryEnumeratorOptionParallel;
+
+		enumerator = [_fileManager enumeratorAtIRI: _testsDirectoryIRI
+						   options: options
+					     attributeKeys: nil];
+
+		for (OFIRI *IRI in enumerator) {
+			OFString *path = [IRI.path substringFromIndex:
+			    _testsDirectoryIRI.path.length];
+
+			if ([path hasPrefix: @"/"])
+				path = [path substringFromIndex: 1];
+			if ([path hasSuffix: @"/"])
+				path = [path substringToIndex:
+				    path.length - 1];
+
+			/* Parents must be returned before their contents. */
+			if (path.stringByDeletingLastPathComponent.length > 0)
+				OTAssertTrue([paths containsObject:
+				    path.stringByDeletingLastPathComponent]);
+
+			OTAssertEqual(enumerator.currentLevel,
+			    [path componentsSeparatedByString: @"/"].count);
+
+			[paths addObject: path];
+		}
+
+		OTAssertEqualObjects(paths, expected);
+	}
+}
+
+- (void)testSkipDescendants
+{
+	OFIRI *subdirectoryIRI = [_testsDirectoryIRI
+	    IRIByAppendingPathComponent: @"a"];
+	OFMutableSet *IRIs = [OFMutableSet set];
+	OFDirectoryEnumerator *enumerator;
+
+	[_fileManager createDirectoryAtIRI: subdirectoryIRI];
+	[@"1" writeToIRI:
+	    [subdirectoryIRI IRIByAppendingPathComponent: @"1.txt"]];
+
+	enumerator = [_fileManager
+	    enumeratorAtIRI: _testsDirectoryIRI
+		    options: OFDirectoryEnumeratorOptionRecursive
+	      attributeKeys: nil];
+
+	for (OFIRI *IRI in enumerator) {
+		if ([enumerator.currentAttributes.fileType
+		    isEqual: OFFileTypeDirectory])
+			[enumerator skipDescendants];
+
+		[IRIs addObject: IRI.lastPathComponent];
+	}
+
+	OTAssertEqualObjects(IRIs,
+	    ([OFSet setWithObjects: @"a", @"test.txt", nil]));
+}
+
 - (void)testChangeCurrentDirectoryPath
 {
 	OFString *oldDirectoryPath = _fileManager.currentDirectoryPath;
@@ -250,6 +374,52 @@
 	    @"2");
 }
 
+- (void)testCopyItemAtIRIToIRIWithHoles
+{
+	OFIRI *sourceIRI = [_testsDirectoryIRI
+	    IRIByAppendingPathComponent: @"sparse"];
+	OFIRI *destinationIRI = [_testsDirectoryIRI
+	    IRIByAppendingPathComponent: @"copy"];
+	OFSeekableStream *stream = (OFSeekableStream *)
+	    [OFIRIHandler openItemAtIRI: sourceIRI mode: @"w"];
+	OFData *data;
+
+	[stream writeString: @"start"];
+	[stream seekToOffset: 1048576 whence: OFSeekSet];
+	[stream writeString: @"middle"];
+	[stream seekToOffset: 4194304 whence: OFSeekSet];
+	[stream writeString: @"end"];
+	[stream close];
+
+	[_fileManager copyItemAtIRI: sourceIRI toIRI: destinationIRI];
+
+	data = [OFData dataWithContentsOfIRI: destinationIRI];
+	OTAssertEqualObjects(data, [OFData dataWithContentsOfIRI: sourceIRI]);
+	OTAssertEqual(data.count, 4194307);
+
+	OTAssertThrowsSpecific([_fileManager copyItemAtIRI: sourceIRI
+						     toIRI: destinationIRI],
+	    OFCopyItemFailedException);
+}
+
+- (void)testWriteContentsOfFile
+{
+	OFIRI *destinationIRI = [_testsDirectoryIRI
+	    IRIByAppendingPathComponent: @"destination.txt"];
+	OFStream *source = [OFIRIHandler openItemAtIRI: _testFileIRI
+						  mode: @"r"];
+	OFStream *destination = [OFIRIHandler openItemAtIRI: destinationIRI
+						       mode: @"w"];
+
+	OTAssertEqual([destination writeContentsOfStream: source length: 3], 3);
+	OTAssertEqual([destination writeContentsOfStream: source length: 10],
+	    1);
+	[destination close];
+
+	OTAssertEqualObjects([OFString stringWithContentsOfIRI: destinationIRI],
+	    @"test");
+}
+
 - (void)testMoveItemAtPathToPath
 {
 	OFIRI *sourceIRI = [_testsDirectoryIRI
@@ -313,6 +483,82 @@
 	OTAssertFalse([_fileManager directoryExistsAtIRI: subdirectoryIRI]);
 }
 
+- (void)testCopyAndRemoveTreeInParallel
+{
+	OFIRI *sourceIRI = [_testsDirectoryIRI
+	    IRIByAppendingPathComponent: @"source"];
+	OFIRI *destinationIRI = [_testsDirectoryIRI
+	    IRIByAppendingPathComponent: @"destination"];
+	OFIRI *subdirectoryIRI = [sourceIRI
+	    IRIByAppendingPathComponent: @"a"];
+	OFString *sourcePath = sourceIRI.fileSystemRepresentation;
+	OFString *destinationPath = destinationIRI.fileSystemRepresentation;
+	OFMutableArray *expected = [OFMutableArray array];
+	OFMutableArray *subpaths = [OFMutableArray array];
+
+	[_fileManager createDirectoryAtIRI: subdirectoryIRI
+			     createParents: true];
+
+	for (int i = 0; i < 32; i++) {
+		OFString *name = [OFString stringWithFormat: @"%d.txt", i];
+
+		[name writeToIRI:
+		    [sourceIRI IRIByAppendingPathComponent: name]];
+		[name writeToIRI:
+		    [subdirectoryIRI IRIByAppendingPathComponent: name]];
+	}
+
+	for (OFString *path in
+	    [_fileManager subpathsOfDirectoryAtPath: sourcePath])
+		[expected addObject:
+		    [path substringFromIndex: sourcePath.length]];
+
+	[_fileManager copyItemAtIRI: sourceIRI
+			      toIRI: destinationIRI
+			    options: OFFileManagerTreeOptionParallel];
+
+	for (OFString *path in
+	    [_fileManager subpathsOfDirectoryAtPath: destinationPath])
+		[subpaths addObject:
+		    [path substringFromIndex: destinationPath.length]];
+
+	OTAssertEqualObjects(subpaths.sortedArray, expected.sortedArray);
+	OTAssertEqualObjects([OFString stringWithContentsOfIRI:
+	    [[destinationIRI IRIByAppendingPathComponent: @"a"]
+	    IRIByAppendingPathComponent: @"31.txt"]], @"31.txt");
+
+	[_fileManager removeItemAtIRI: destinationIRI
+			      options: OFFileManagerTreeOptionParallel];
+	OTAssertFalse([_fileManager fileExistsAtIRI: destinationIRI]);
+}
+
+#ifdef OF_HAVE_BLOCKS
+- (void)testRemoveTreeWithItemHandler
+{
+	OFIRI *subdirectoryIRI = [_testsDirectoryIRI
+	    IRIByAppendingPathComponent: @"dir"];
+	__block size_t count = 0;
+
+	[_fileManager createDirectoryAtIRI: subdirectoryIRI];
+	[@"1" writeToIRI:
+	    [subdirectoryIRI IRIByAppendingPathComponent: @"1.txt"]];
+	[@"2" writeToIRI:
+	    [subdirectoryIRI IRIByAppendingPathComponent: @"2.txt"]];
+
+	[_fileManager removeItemAtIRI: subdirectoryIRI
+			      options: OFFileManagerTreeOptionParallel
+			  itemHandler: ^ (OFIRI *IRI, id exception) {
+		OTAssertNil(exception);
+		count++;
+		return true;
+	}];
+
+	/* Both files and the directory itself. */
+	OTAssertEqual(count, 3);
+	OTAssertFalse([_fileManager fileExistsAtIRI: subdirectoryIRI]);
+}
+#endif
+
 #ifdef OF_FILE_MANAGER_SUPPORTS_LINKS
 - (void)testLinkItemAtPathToPath
 {
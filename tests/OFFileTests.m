@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2008-2026 Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3.0 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * version 3.0 along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "ObjFW.h"
+#import "ObjFWTest.h"
+
+#define numChunks 64
+#define chunkSize 4096
+
+@interface OFFileTests: OTTestCase
+#ifdef OF_HAVE_SOCKETS
+    <OFStreamDelegate>
+#endif
+{
+	OFString *_path;
+#ifdef OF_HAVE_SOCKETS
+	unsigned char _buffer[chunkSize];
+	size_t _numWritten, _numRead;
+	bool _failed;
+#endif
+}
+@end
+
+#ifdef OF_HAVE_SOCKETS
+static OFRunLoopMode testMode = @"OFFileTestsMode";
+#endif
+
+#ifdef OF_HAVE_THREADS
+@interface OFFileTestsReader: OFThread
+{
+	OFFile *_file;
+	size_t _firstChunk;
+}
+
+- (instancetype)initWithFile: (OFFile *)file firstChunk: (size_t)firstChunk;
+@end
+#endif
+
+static void
+fillChunk(unsigned char *buffer, size_t chunk)
+{
+	for (size_t i = 0; i < chunkSize; i++)
+		buffer[i] = (unsigned char)(chunk * 7 + i);
+}
+
+@implementation OFFileTests
+- (void)setUp
+{
+	OFIRI *temporaryDirectoryIRI = [OFSystemInfo temporaryDirectoryIRI];
+
+	OTAssertNotNil(temporaryDirectoryIRI);
+
+	_path = objc_retain([temporaryDirectoryIRI
+	    IRIByAppendingPathComponent: @"objfw-file-test"]
+	    .fileSystemRepresentation);
+}
+
+- (void)tearDown
+{
+	OFFileManager *fileManager = [OFFileManager defaultManager];
+
+	if (_path != nil && [fileManager fileExistsAtPath: _path])
+		[fileManager removeItemAtPath: _path];
+}
+
+- (void)dealloc
+{
+	objc_release(_path);
+
+	[super dealloc];
+}
+
+- (OFFile *)writeChunks
+{
+	OFFile *file = [OFFile fileWithPath: _path mode: @"w+"];
+	unsigned char buffer[chunkSize];
+
+	/* Backwards, to make sure the offset is used and not the position. */
+	for (size_t i = numChunks; i > 0; i--) {
+		fillChunk(buffer, i - 1);
+
+		@try {
+			[file writeBuffer: buffer
+				   length: chunkSize
+				 atOffset: (i - 1) * chunkSize];
+		} @catch (OFNotImplementedException *e) {
+			return nil;
+		}
+	}
+
+	return file;
+}
+
+- (void)testReadAndWriteAtOffset
+{
+	OFFile *file = [self writeChunks];
+	unsigned char buffer[chunkSize], expected[chunkSize];
+
+	if (file == nil)
+		return;
+
+	OTAssertEqual([file seekToOffset: 0 whence: OFSeekCurrent], 0);
+	OTAssertEqual([file seekToOffset: 0 whence: OFSeekEnd],
+	    numChunks * chunkSize);
+
+	fillChunk(expected, 5);
+	OTAssertEqual([file readIntoBuffer: buffer
+				    length: chunkSize
+				  atOffset: 5 * chunkSize], chunkSize);
+	OTAssertEqual(memcmp(buffer, expected, chunkSize), 0);
+
+	OTAssertEqual([file readIntoBuffer: buffer
+				    length: chunkSize
+				  atOffset: numChunks * chunkSize], 0);
+
+	/* The position and the read buffer are left alone. */
+	[file seekToOffset: 3 whence: OFSeekSet];
+	OTAssertEqual([file readInt8], (uint8_t)3);
+	OTAssertEqual([file readIntoBuffer: buffer
+				    length: 1
+				  atOffset: 0], 1);
+	OTAssertEqual(buffer[0], 0);
+	OTAssertEqual([file readInt8], (uint8_t)4);
+}
+
+#ifdef OF_HAVE_THREADS
+- (void)testConcurrentReadsAtOffset
+{
+	OFFile *file = [self writeChunks];
+	OFMutableArray *readers = [OFMutableArray array];
+
+	if (file == nil)
+		return;
+
+	for (size_t i = 0; i < 4; i++) {
+		OFFileTestsReader *reader = objc_autorelease(
+		    [[OFFileTestsReader alloc] initWithFile: file
+						 firstChunk: i]);
+
+		[reader start];
+		[readers addObject: reader];
+	}
+
+	for (OFFileTestsReader *reader in readers)
+		OTAssertNil([reader join]);
+}
+#endif
+
+#ifdef OF_HAVE_SOCKETS
+- (void)testAsyncReadAndWrite
+{
+	OFFile *file = [OFFile fileWithPath: _path mode: @"w+"];
+	OFDate *deadline;
+
+	file.delegate = self;
+
+	fillChunk(_buffer, 0);
+	[file asyncWriteData: [OFData dataWithItems: _buffer count: chunkSize]
+		 runLoopMode: testMode];
+
+	deadline = [OFDate dateWithTimeIntervalSinceNow: 5];
+	while (_numRead < numChunks && !_failed &&
+	    deadline.timeIntervalSinceNow > 0)
+		[[OFRunLoop currentRunLoop] runMode: testMode
+					 beforeDate: deadline];
+
+	OTAssertFalse(_failed);
+	OTAssertEqual(_numWritten, numChunks);
+	OTAssertEqual(_numRead, numChunks);
+	OTAssertEqual([file seekToOffset: 0 whence: OFSeekCurrent],
+	    numChunks * chunkSize);
+}
+
+- (OFData *)stream: (OFStream *)stream
+      didWriteData: (OFData *)data
+      bytesWritten: (size_t)bytesWritten
+	 exception: (id)exception
+{
+	if (exception != nil || bytesWritten != chunkSize) {
+		_failed = true;
+		return nil;
+	}
+
+	if (++_numWritten < numChunks) {
+		fillChunk(_buffer, _numWritten);
+		return [OFData dataWithItems: _buffer count: chunkSize];
+	}
+
+	[(OFFile *)stream seekToOffset: 0 whence: OFSeekSet];
+	[stream asyncReadIntoBuffer: _buffer
+			exactLength: chunkSize
+			runLoopMode: testMode];
+
+	return nil;
+}
+
+-      (bool)stream: (OFStream *)stream
+  didReadIntoBuffer: (void *)buffer
+	     length: (size_t)length
+	  exception: (id)exception
+{
+	unsigned char expected[chunkSize];
+
+	fillChunk(expected, _numRead);
+
+	if (exception != nil || length != chunkSize ||
+	    memcmp(buffer, expected, chunkSize) != 0) {
+		_failed = true;
+		return false;
+	}
+
+	return (++_numRead < numChunks);
+}
+#endif
+@end
+
+#ifdef OF_HAVE_THREADS
+@implementation OFFileTestsReader
+- (instancetype)initWithFile: (OFFile *)file firstChunk: (size_t)firstChunk
+{
+	self = [super init];
+
+	_file = objc_retain(file);
+	_firstChunk = firstChunk;
+
+	return self;
+}
+
+- (void)dealloc
+{
+	objc_release(_file);
+
+	[super dealloc];
+}
+
+- (id)main
+{
+	unsigned char buffer[chunkSize], expected[chunkSize];
+
+	for (size_t i = 0; i < 100; i++) {
+		for (size_t chunk = _firstChunk; chunk < numChunks;
+		    chunk += 4) {
+			fillChunk(expected, chunk);
+
+			if ([_file readIntoBuffer: buffer
+					   length: chunkSize
+					 atOffset: chunk * chunkSize] !=
+			    chunkSize ||
+			    memcmp(buffer, expected, chunkSize) != 0)
+				return [OFString stringWithFormat:
+				    @"Chunk %zu differs", chunk];
+		}
+	}
+
+	return nil;
+}
+@end
+#endif
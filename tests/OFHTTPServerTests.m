@@ -0,0 +1,600 @@
+/*
+ * Copyright (c) 2008-2026 Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3.0 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * version 3.0 along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#import "ObjFW.h"
+#import "ObjFWTest.h"
+
+static const size_t numClients = 2;
+static const size_t numRequestsPerClient = 10;
+static char slowBody[65536];
+static char largeBody[1048576];
+
+@interface OFHTTPServerTests: OTTestCase <OFHTTPServerDelegate,
+    OFStreamDelegate>
+{
+	size_t _numFinishedClients;
+	OFHTTPRequest *_lastRequest;
+	OFData *_lastRequestBody;
+	OFHTTPStaticFileHandler *_staticFileHandler;
+	size_t _numStaticRequests;
+}
+@end
+
+@interface OFHTTPServerTestsClient: OFThread
+{
+	uint16_t _port;
+	OFHTTPServerTests *_testCase;
+}
+
+- (instancetype)initWithPort: (uint16_t)port
+		    testCase: (OFHTTPServerTests *)testCase;
+- (OFString *)performRequest;
+@end
+
+/* Only starts reading a large response after the server had to queue it. */
+@interface OFHTTPServerTestsSlowReader: OFHTTPServerTestsClient
+@end
+
+@implementation OFHTTPServerTests
+- (void)dealloc
+{
+	objc_release(_lastRequest);
+	objc_release(_lastRequestBody);
+	objc_release(_staticFileHandler);
+
+	[super dealloc];
+}
+
+-      (void)server: (OFHTTPServer *)server
+  didReceiveRequest: (OFHTTPRequest *)request
+	requestBody: (OFStream *)requestBody
+	   response: (OFHTTPResponse *)response
+{
+	if ([request.IRI.path isEqual: @"/slow"]) {
+		/* Sends an endless body without blocking. */
+		response.statusCode = 200;
+		response.canBlock = false;
+		response.delegate = self;
+		[response asyncWriteData:
+		    [OFData dataWithItemsNoCopy: slowBody
+					  count: sizeof(slowBody)
+				   freeWhenDone: false]];
+		return;
+	}
+
+	if ([request.IRI.path isEqual: @"/large"]) {
+		response.statusCode = 200;
+		response.headers = [OFDictionary
+		    dictionaryWithObject: [OFString stringWithFormat:
+					      @"%zu", sizeof(largeBody)]
+				  forKey: @"Content-Length"];
+		response.canBlock = false;
+		response.delegate = self;
+		[response asyncWriteData:
+		    [OFData dataWithItemsNoCopy: largeBody
+					  count: sizeof(largeBody)
+				   freeWhenDone: false]];
+		return;
+	}
+
+	if (_staticFileHandler != nil &&
+	    [request.IRI.path hasPrefix: @"/static/"]) {
+		[_staticFileHandler handleRequest: request response: response];
+		_numStaticRequests++;
+		return;
+	}
+
+	/* Only requests with a body are recorded, the clients send none. */
+	if (requestBody != nil) {
+		objc_release(_lastRequest);
+		_lastRequest = objc_retain(request);
+
+		objc_release(_lastRequestBody);
+		_lastRequestBody =
+		    objc_retain([requestBody readDataUntilEndOfStream]);
+	}
+
+	response.statusCode = 200;
+	response.headers = [OFDictionary
+	    dictionaryWithObject: @"2"
+			  forKey: @"Content-Length"];
+	[response writeString: @"OK"];
+	[response close];
+}
+
+- (OFData *)stream: (OFStream *)stream
+      didWriteData: (OFData *)data
+      bytesWritten: (size_t)bytesWritten
+	 exception: (id)exception
+{
+	if (data.items == largeBody) {
+		/*
+		 * Not closed right away, as the run loop still needs the file
+		 * descriptor of the response to stop observing it.
+		 */
+		[stream performSelector: @selector(close) afterDelay: 0];
+		return nil;
+	}
+
+	/* The slow body is sent endlessly. */
+	return (exception == nil ? data : nil);
+}
+
+- (void)clientDidFinish
+{
+	_numFinishedClients++;
+}
+
+- (void)runClientsWithNumberOfThreads: (size_t)numberOfThreads
+		  listensOnAllThreads: (bool)listensOnAllThreads
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFHTTPServer *server = [OFHTTPServer server];
+	OFMutableArray *clients = [OFMutableArray array];
+
+	server.delegate = self;
+	server.host = @"127.0.0.1";
+	server.numberOfThreads = numberOfThreads;
+
+	if (listensOnAllThreads) {
+		@try {
+			server.listensOnAllThreads = true;
+		} @catch (OFNotImplementedException *e) {
+			objc_autoreleasePoolPop(pool);
+			return;
+		}
+	}
+
+	[server start];
+
+	_numFinishedClients = 0;
+
+	for (size_t i = 0; i < numClients; i++) {
+		OFHTTPServerTestsClient *client = objc_autorelease(
+		    [[OFHTTPServerTestsClient alloc] initWithPort: server.port
+							 testCase: self]);
+		client.supportsSockets = true;
+
+		[client start];
+		[clients addObject: client];
+	}
+
+	while (_numFinishedClients < numClients)
+		[[OFRunLoop mainRunLoop] runUntilDate:
+		    [OFDate dateWithTimeIntervalSinceNow: 0.01]];
+
+	for (OFHTTPServerTestsClient *client in clients)
+		OTAssertNil([client join]);
+
+	[server stop];
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (void)testParseRequestSplitAcrossReads
+{
+	OFHTTPServer *server = [OFHTTPServer server];
+	OFTCPSocket *sock = [OFTCPSocket socket];
+	OFDate *timeout = [OFDate dateWithTimeIntervalSinceNow: 5];
+	OFDictionary OF_GENERIC(OFString *, OFString *) *headers;
+
+	server.delegate = self;
+	server.host = @"127.0.0.1";
+	[server start];
+
+	[sock connectToHost: @"127.0.0.1" port: server.port];
+	[sock writeString: @"POST /path?query HTTP/1.1\r\nho"];
+	[[OFRunLoop mainRunLoop] runUntilDate:
+	    [OFDate dateWithTimeIntervalSinceNow: 0.01]];
+	[sock writeString: @"st: 127.0.0.1:1234\r\nX-Test: a\r\n"
+			   @"x-test:   b\r\nContent-Length: 4\r\n\r"];
+	[[OFRunLoop mainRunLoop] runUntilDate:
+	    [OFDate dateWithTimeIntervalSinceNow: 0.01]];
+	[sock writeString: @"\nbody"];
+
+	while (_lastRequest == nil && timeout.timeIntervalSinceNow > 0)
+		[[OFRunLoop mainRunLoop] runUntilDate:
+		    [OFDate dateWithTimeIntervalSinceNow: 0.01]];
+
+	[server stop];
+
+	OTAssertNotNil(_lastRequest);
+	OTAssertEqual(_lastRequest.method, OFHTTPRequestMethodPost);
+	OTAssertEqualObjects(_lastRequest.IRI.path, @"/path");
+	OTAssertEqualObjects(_lastRequest.IRI.query, @"query");
+	OTAssertEqualObjects(_lastRequest.IRI.host, @"127.0.0.1");
+	OTAssertEqualObjects(_lastRequest.IRI.port,
+	    [OFNumber numberWithUnsignedShort: 1234]);
+
+	headers = _lastRequest.headers;
+	OTAssertEqualObjects([headers objectForKey: @"Host"],
+	    @"127.0.0.1:1234");
+	OTAssertEqualObjects([headers objectForKey: @"X-Test"], @"a,b");
+	OTAssertEqualObjects([headers objectForKey: @"Content-Length"], @"4");
+
+	OTAssertEqualObjects(_lastRequestBody,
+	    [OFData dataWithItems: "body" count: 4]);
+}
+
+- (void)testSlowClientDoesNotStallOthers
+{
+	OFHTTPServer *server = [OFHTTPServer server];
+	OFTCPSocket *slowSocket = [OFTCPSocket socket];
+	OFHTTPServerTestsClient *client;
+	OFDate *timeout;
+
+	server.delegate = self;
+	server.host = @"127.0.0.1";
+	[server start];
+
+	/* Requests an endless body, but never reads it. */
+	[slowSocket connectToHost: @"127.0.0.1" port: server.port];
+	[slowSocket writeFormat: @"GET /slow HTTP/1.1\r\n"
+				 @"Host: 127.0.0.1:%" @PRIu16 "\r\n"
+				 @"\r\n",
+				 server.port];
+
+	_numFinishedClients = 0;
+	client = objc_autorelease(
+	    [[OFHTTPServerTestsClient alloc] initWithPort: server.port
+						 testCase: self]);
+	client.supportsSockets = true;
+	[client start];
+
+	timeout = [OFDate dateWithTimeIntervalSinceNow: 30];
+	while (_numFinishedClients < 1 && timeout.timeIntervalSinceNow > 0)
+		[[OFRunLoop mainRunLoop] runUntilDate:
+		    [OFDate dateWithTimeIntervalSinceNow: 0.01]];
+
+	OTAssertEqual(_numFinishedClients, 1);
+	OTAssertNil([client join]);
+
+	[slowSocket close];
+	[server stop];
+}
+
+- (void)testSlowClientReceivesWholeBody
+{
+	OFHTTPServer *server = [OFHTTPServer server];
+	OFHTTPServerTestsSlowReader *reader;
+	OFDate *timeout;
+
+	for (size_t i = 0; i < sizeof(largeBody); i++)
+		largeBody[i] = (char)(i * 31 + i / 256);
+
+	server.delegate = self;
+	server.host = @"127.0.0.1";
+	[server start];
+
+	_numFinishedClients = 0;
+	reader = objc_autorelease(
+	    [[OFHTTPServerTestsSlowReader alloc] initWithPort: server.port
+						     testCase: self]);
+	reader.supportsSockets = true;
+	[reader start];
+
+	timeout = [OFDate dateWithTimeIntervalSinceNow: 30];
+	while (_numFinishedClients < 1 && timeout.timeIntervalSinceNow > 0)
+		[[OFRunLoop mainRunLoop] runUntilDate:
+		    [OFDate dateWithTimeIntervalSinceNow: 0.01]];
+
+	OTAssertEqual(_numFinishedClients, 1);
+	OTAssertNil([reader join]);
+
+	[server stop];
+}
+
+#ifdef OF_HAVE_FILES
+- (long long)requestPath: (OFString *)path
+	    extraHeaders: (OFString *)extraHeaders
+		    port: (uint16_t)port
+		 headers: (OFDictionary **)headersOut
+		    body: (OFString **)bodyOut
+{
+	OFTCPSocket *sock = [OFTCPSocket socket];
+	OFMutableDictionary *headers = [OFMutableDictionary dictionary];
+	size_t numStaticRequests = _numStaticRequests;
+	OFDate *timeout = [OFDate dateWithTimeIntervalSinceNow: 5];
+	OFString *statusLine, *line, *contentLength;
+	OFData *body = [OFData data];
+
+	[sock connectToHost: @"127.0.0.1" port: port];
+	[sock writeFormat: @"GET %@ HTTP/1.1\r\n"
+			   @"Host: 127.0.0.1:%" @PRIu16 "\r\n"
+			   @"%@\r\n",
+			   path, port, extraHeaders];
+
+	/* The server runs on this thread, so it has to be run until done. */
+	while (_numStaticRequests == numStaticRequests &&
+	    timeout.timeIntervalSinceNow > 0)
+		[[OFRunLoop mainRunLoop] runUntilDate:
+		    [OFDate dateWithTimeIntervalSinceNow: 0.01]];
+
+	statusLine = [sock readLine];
+
+	while ((line = [sock readLine]) != nil && line.length > 0) {
+		size_t pos = [line rangeOfString: @": "].location;
+
+		if (pos == OFNotFound)
+			continue;
+
+		[headers setObject: [line substringFromIndex: pos + 2]
+			    forKey: [line substringToIndex: pos]
+					.lowercaseString];
+	}
+
+	if ((contentLength = [headers objectForKey: @"content-length"]) != nil)
+		body = [sock readDataWithCount:
+		    (size_t)contentLength.longLongValue];
+
+	*headersOut = headers;
+	*bodyOut = [OFString stringWithUTF8String: body.items
+					   length: body.count];
+
+	return [statusLine substringWithRange: OFMakeRange(9, 3)]
+	    .longLongValue;
+}
+
+- (void)testStaticFileHandler
+{
+	OFFileManager *fileManager = [OFFileManager defaultManager];
+	OFIRI *rootIRI = [[OFSystemInfo temporaryDirectoryIRI]
+	    IRIByAppendingPathComponent: @"objfw-http-server-tests"];
+	OFIRI *staticIRI = [rootIRI IRIByAppendingPathComponent: @"static"];
+	OFHTTPServer *server = [OFHTTPServer server];
+	OFDictionary OF_GENERIC(OFString *, OFString *) *headers;
+	OFString *body, *ETag;
+	long long statusCode;
+
+	/* In case a previous test run failed and left things. */
+	if ([fileManager directoryExistsAtIRI: rootIRI])
+		[fileManager removeItemAtIRI: rootIRI];
+
+	[fileManager createDirectoryAtIRI: staticIRI createParents: true];
+	[@"Hello World!" writeToIRI:
+	    [staticIRI IRIByAppendingPathComponent: @"test.txt"]];
+
+	_staticFileHandler =
+	    [[OFHTTPStaticFileHandler alloc] initWithRootIRI: rootIRI];
+
+	server.delegate = self;
+	server.host = @"127.0.0.1";
+	[server start];
+
+	@try {
+		statusCode = [self requestPath: @"/static/test.txt"
+				  extraHeaders: @""
+					  port: server.port
+				       headers: &headers
+					  body: &body];
+		OTAssertEqual(statusCode, 200);
+		OTAssertEqualObjects(body, @"Hello World!");
+		OTAssertEqualObjects([headers objectForKey: @"content-type"],
+		    @"text/plain; charset=UTF-8");
+		OTAssertNotNil([headers objectForKey: @"last-modified"]);
+		ETag = [headers objectForKey: @"etag"];
+		OTAssertNotNil(ETag);
+
+		statusCode = [self requestPath: @"/static/test.txt"
+				  extraHeaders: @"Range: bytes=6-10\r\n"
+					  port: server.port
+				       headers: &headers
+					  body: &body];
+		OTAssertEqual(statusCode, 206);
+		OTAssertEqualObjects(body, @"World");
+		OTAssertEqualObjects([headers objectForKey: @"content-range"],
+		    @"bytes 6-10/12");
+
+		statusCode = [self requestPath: @"/static/test.txt"
+				  extraHeaders: @"Range: bytes=0-4,-1\r\n"
+					  port: server.port
+				       headers: &headers
+					  body: &body];
+		OTAssertEqual(statusCode, 206);
+		OTAssertTrue([[headers objectForKey: @"content-type"]
+		    hasPrefix: @"multipart/byteranges; boundary="]);
+		OTAssertTrue([body containsString:
+		    @"Content-Range: bytes 0-4/12\r\n\r\nHello\r\n"]);
+		OTAssertTrue([body containsString:
+		    @"Content-Range: bytes 11-11/12\r\n\r\n!\r\n"]);
+
+		statusCode = [self requestPath: @"/static/test.txt"
+				  extraHeaders: @"Range: bytes=12-\r\n"
+					  port: server.port
+				       headers: &headers
+					  body: &body];
+		OTAssertEqual(statusCode, 416);
+		OTAssertEqualObjects([headers objectForKey: @"content-range"],
+		    @"bytes */12");
+
+		statusCode = [self requestPath: @"/static/test.txt"
+				  extraHeaders: [OFString stringWithFormat:
+						    @"If-None-Match: %@\r\n",
+						    ETag]
+					  port: server.port
+				       headers: &headers
+					  body: &body];
+		OTAssertEqual(statusCode, 304);
+
+		statusCode = [self requestPath: @"/static/missing.txt"
+				  extraHeaders: @""
+					  port: server.port
+				       headers: &headers
+					  body: &body];
+		OTAssertEqual(statusCode, 404);
+	} @finally {
+		[server stop];
+
+		objc_release(_staticFileHandler);
+		_staticFileHandler = nil;
+
+		[fileManager removeItemAtIRI: rootIRI];
+	}
+}
+#endif
+
+- (void)testConcurrentClients
+{
+	[self runClientsWithNumberOfThreads: 1 listensOnAllThreads: false];
+	[self runClientsWithNumberOfThreads: 2 listensOnAllThreads: true];
+}
+@end
+
+@implementation OFHTTPServerTestsClient
+- (instancetype)initWithPort: (uint16_t)port
+		    testCase: (OFHTTPServerTests *)testCase
+{
+	self = [super init];
+
+	_port = port;
+	_testCase = objc_retain(testCase);
+
+	return self;
+}
+
+- (void)dealloc
+{
+	objc_release(_testCase);
+
+	[super dealloc];
+}
+
+- (id)main
+{
+	OFString *error = nil;
+
+	@try {
+		for (size_t i = 0; i < numRequestsPerClient && error == nil;
+		    i++) {
+			void *pool = objc_autoreleasePoolPush();
+
+			error = [self performRequest];
+
+			objc_autoreleasePoolPop(pool);
+		}
+	} @catch (id e) {
+		error = [e description];
+	}
+
+	[_testCase performSelector: @selector(clientDidFinish)
+			  onThread: [OFThread mainThread]
+			withObject: nil
+		     waitUntilDone: false];
+
+	return error;
+}
+
+- (OFString *)performRequest
+{
+	OFTCPSocket *sock = [OFTCPSocket socket];
+	unsigned long long contentLength = 0;
+	bool hasDate = false;
+	OFString *line;
+	char body[2];
+
+	[sock connectToHost: @"127.0.0.1" port: _port];
+	[sock writeFormat: @"GET / HTTP/1.1\r\n"
+			   @"Host: 127.0.0.1:%" @PRIu16 "\r\n"
+			   @"\r\n",
+			   _port];
+
+	if (![[sock readLine] hasPrefix: @"HTTP/1.1 200 "])
+		return @"Wrong status";
+
+	while ((line = [sock readLine]) != nil && line.length > 0) {
+		if ([line.lowercaseString hasPrefix: @"content-length: "])
+			contentLength =
+			    [line substringFromIndex: 16].unsignedLongLongValue;
+		else if ([line.lowercaseString hasPrefix: @"date: "] &&
+		    [line hasSuffix: @" GMT"])
+			hasDate = true;
+	}
+
+	if (contentLength != 2)
+		return @"Wrong content length";
+
+	if (!hasDate)
+		return @"Missing date";
+
+	[sock readIntoBuffer: body exactLength: 2];
+	if (memcmp(body, "OK", 2) != 0)
+		return @"Wrong body";
+
+	return nil;
+}
+@end
+
+@implementation OFHTTPServerTestsSlowReader
+- (id)main
+{
+	OFString *error = nil;
+
+	@try {
+		error = [self performRequest];
+	} @catch (id e) {
+		error = [e description];
+	}
+
+	[_testCase performSelector: @selector(clientDidFinish)
+			  onThread: [OFThread mainThread]
+			withObject: nil
+		     waitUntilDone: false];
+
+	return error;
+}
+
+- (OFString *)performRequest
+{
+	OFTCPSocket *sock = [OFTCPSocket socket];
+	unsigned long long contentLength = 0;
+	OFString *line;
+	OFData *body;
+
+	[sock connectToHost: @"127.0.0.1" port: _port];
+	[sock writeFormat: @"GET /large HTTP/1.1\r\n"
+			   @"Host: 127.0.0.1:%" @PRIu16 "\r\n"
+			   @"\r\n",
+			   _port];
+
+	/* Let the server fill the socket buffers and its queue. */
+	[OFThread sleepForTimeInterval: 0.5];
+
+	if (![[sock readLine] hasPrefix: @"HTTP/1.1 200 "])
+		return @"Wrong status";
+
+	while ((line = [sock readLine]) != nil && line.length > 0)
+		if ([line.lowercaseString hasPrefix: @"content-length: "])
+			contentLength =
+			    [line substringFromIndex: 16].unsignedLongLongValue;
+
+	if (contentLength != sizeof(largeBody))
+		return @"Wrong content length";
+
+	body = [sock readDataWithCount: sizeof(largeBody)];
+	if (memcmp(body.items, largeBody, sizeof(largeBody)) != 0)
+		return @"Wrong body";
+
+	return nil;
+}
+@end
@@ -41,10 +41,21 @@
 	OFTCPSocket *_server, *_client, *_accepted;
 	OFKernelEventObserver *_observer;
 	size_t _events;
+	OFMutableArray OF_GENERIC(OFUDPSocket *) *_churnSockets;
+}
+@end
+
+@interface OFKernelEventObserverTestsReadBufferDelegate: OFObject
+    <OFKernelEventObserverDelegate>
+{
+@public
+	size_t _count;
+	id _lastObject;
 }
 @end
 
 static const size_t numExpectedEvents = 3;
+static const size_t numChurnSockets = 256;
 
 @implementation OFKernelEventObserverTests
 - (void)setUp
@@ -69,16 +80,22 @@ static const size_t numExpectedEvents = 3;
 	objc_release(_server);
 	objc_release(_accepted);
 	objc_release(_observer);
+	objc_release(_churnSockets);
 
 	[super dealloc];
 }
 
 - (void)testKernelEventObserverWithClass: (Class)class
+{
+	[self testKernelEventObserver: objc_autorelease([[class alloc] init])];
+}
+
+- (void)testKernelEventObserver: (OFKernelEventObserver *)observer
 {
 	bool deadlineExceeded = false;
 	OFDate *deadline;
 
-	_observer = [[class alloc] init];
+	_observer = objc_retain(observer);
 	_observer.delegate = self;
 	[_observer addObjectForReading: _server];
 
@@ -97,6 +114,68 @@ static const size_t numExpectedEvents = 3;
 	OTAssertEqual(_events, numExpectedEvents);
 }
 
+- (void)testKernelEventObserverChurnWithClass: (Class)class
+{
+	OFKernelEventObserver *observer =
+	    objc_autorelease([[class alloc] init]);
+
+	_churnSockets = [[OFMutableArray alloc] init];
+
+	for (size_t i = 0; i < numChurnSockets; i++) {
+		OFUDPSocket *sock = [OFUDPSocket socket];
+
+		[sock bindToHost: @"127.0.0.1" port: 0];
+		[_churnSockets addObject: sock];
+
+		[observer addObjectForReading: sock];
+		[observer addObjectForWriting: sock];
+	}
+
+	/* Remove in an order that moves the remaining entries around. */
+	for (size_t i = 0; i < numChurnSockets; i += 2)
+		[observer removeObjectForWriting:
+		    [_churnSockets objectAtIndex: i]];
+	for (size_t i = 1; i < numChurnSockets; i += 2)
+		[observer removeObjectForWriting:
+		    [_churnSockets objectAtIndex: i]];
+
+	/*
+	 * The idle sockets stay observed for reading. Some of them are
+	 * removed once the connection has been accepted, so that the entry
+	 * for the accepted socket gets moved while being observed.
+	 */
+	[self testKernelEventObserver: observer];
+}
+
+- (void)testReusedFileDescriptorWithClass: (Class)class
+{
+	OFKernelEventObserver *observer =
+	    objc_autorelease([[class alloc] init]);
+	OFUDPSocket *closed = [OFUDPSocket socket];
+	OFUDPSocket *reused = [OFUDPSocket socket];
+	int fd;
+
+	observer.delegate = self;
+
+	[closed bindToHost: @"127.0.0.1" port: 0];
+	fd = closed.fileDescriptorForWriting;
+
+	/* Closed without being removed first. */
+	[observer addObjectForWriting: closed];
+	[closed close];
+
+	[reused bindToHost: @"127.0.0.1" port: 0];
+	if (reused.fileDescriptorForReading != fd)
+		OTSkip(@"File descriptor was not reused");
+
+	[observer addObjectForReading: reused];
+	[observer removeObjectForReading: reused];
+
+	/* The closed socket must not be reported as writable anymore. */
+	[observer observeForTimeInterval: 0];
+	OTAssertEqual(_events, 0);
+}
+
 - (void)objectIsReadyForReading: (id)object
 {
 	char buffer;
@@ -107,6 +186,10 @@ static const size_t numExpectedEvents = 3;
 
 		_accepted = objc_retain([object accept]);
 		[_observer addObjectForReading: _accepted];
+
+		for (size_t i = 0; i < _churnSockets.count; i += 2)
+			[_observer removeObjectForReading:
+			    [_churnSockets objectAtIndex: i]];
 		break;
 	case 1:
 		OTAssert(object, _accepted);
@@ -126,12 +209,69 @@ static const size_t numExpectedEvents = 3;
 	}
 }
 
+- (void)objectIsReadyForWriting: (id)object
+{
+	_events++;
+}
+
+- (void)testProcessReadBuffers
+{
+	OFKernelEventObserver *observer = [OFKernelEventObserver observer];
+	OFKernelEventObserverTestsReadBufferDelegate *delegate =
+	    objc_autorelease([[OFKernelEventObserverTestsReadBufferDelegate
+	    alloc] init]);
+	OFTCPSocket *accepted = [_server accept];
+	char buffer;
+
+	observer.delegate = delegate;
+
+	[accepted readIntoBuffer: &buffer exactLength: 1];
+	OTAssertEqual(buffer, '0');
+
+	/* Data that is already buffered when the stream is added */
+	[accepted unreadFromBuffer: "a" length: 1];
+	[observer addObjectForReading: accepted];
+	OTAssertTrue([observer processReadBuffers]);
+	OTAssertEqual(delegate->_count, 1);
+	OTAssertEqual(delegate->_lastObject, accepted);
+
+	/* Nothing was consumed, so it needs to be reported again */
+	OTAssertTrue([observer processReadBuffers]);
+	OTAssertEqual(delegate->_count, 2);
+
+	OTAssertEqual([accepted readIntoBuffer: &buffer length: 1], 1);
+	OTAssertEqual(buffer, 'a');
+	OTAssertFalse([observer processReadBuffers]);
+	OTAssertEqual(delegate->_count, 2);
+
+	/* Data that gets buffered while the stream is observed */
+	[accepted unreadFromBuffer: "b" length: 1];
+	OTAssertTrue([observer processReadBuffers]);
+	OTAssertEqual(delegate->_count, 3);
+
+	[observer removeObjectForReading: accepted];
+	OTAssertFalse([observer processReadBuffers]);
+	OTAssertEqual(delegate->_count, 3);
+}
+
 #ifdef HAVE_SELECT
 - (void)testSelectKernelEventObserver
 {
 	[self testKernelEventObserverWithClass:
 	    [OFSelectKernelEventObserver class]];
 }
+
+- (void)testSelectKernelEventObserverChurn
+{
+	[self testKernelEventObserverChurnWithClass:
+	    [OFSelectKernelEventObserver class]];
+}
+
+- (void)testSelectKernelEventObserverReusedFileDescriptor
+{
+	[self testReusedFileDescriptorWithClass:
+	    [OFSelectKernelEventObserver class]];
+}
 #endif
 
 #ifdef HAVE_POLL
@@ -140,6 +280,18 @@ static const size_t numExpectedEvents = 3;
 	[self testKernelEventObserverWithClass:
 	    [OFPollKernelEventObserver class]];
 }
+
+- (void)testPollKernelEventObserverChurn
+{
+	[self testKernelEventObserverChurnWithClass:
+	    [OFPollKernelEventObserver class]];
+}
+
+- (void)testPollKernelEventObserverReusedFileDescriptor
+{
+	[self testReusedFileDescriptorWithClass:
+	    [OFPollKernelEventObserver class]];
+}
 #endif
 
 #ifdef HAVE_EPOLL
@@ -148,6 +300,23 @@ static const size_t numExpectedEvents = 3;
 	[self testKernelEventObserverWithClass:
 	    [OFEpollKernelEventObserver class]];
 }
+
+- (void)testEpollKernelEventObserverReusedFileDescriptor
+{
+	[self testReusedFileDescriptorWithClass:
+	    [OFEpollKernelEventObserver class]];
+}
+
+- (void)testEdgeTriggeredEpollKernelEventObserver
+{
+	OFEpollKernelEventObserver *observer =
+	    objc_autorelease([[OFEpollKernelEventObserver alloc] init]);
+
+	observer.edgeTriggered = true;
+	OTAssertTrue(observer.edgeTriggered);
+
+	[self testKernelEventObserver: observer];
+}
 #endif
 
 #ifdef HAVE_KQUEUE
@@ -158,3 +327,11 @@ static const size_t numExpectedEvents = 3;
 }
 #endif
 @end
+
+@implementation OFKernelEventObserverTestsReadBufferDelegate
+- (void)objectIsReadyForReading: (id)object
+{
+	_count++;
+	_lastObject = object;
+}
+@end
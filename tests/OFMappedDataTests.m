@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2008-2026 Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3.0 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * version 3.0 along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#import "ObjFW.h"
+#import "ObjFWTest.h"
+
+@interface OFMappedDataTests: OTTestCase
+{
+	OFIRI *_fileIRI;
+	OFMutableData *_contents;
+}
+@end
+
+@implementation OFMappedDataTests
+- (void)setUp
+{
+	OFIRI *temporaryDirectoryIRI = [OFSystemInfo temporaryDirectoryIRI];
+
+	OTAssertNotNil(temporaryDirectoryIRI);
+
+	_fileIRI = objc_retain([temporaryDirectoryIRI
+	    IRIByAppendingPathComponent: @"objfw-mapped-data-test"]);
+
+	_contents = [[OFMutableData alloc] init];
+	for (uint32_t i = 0; i < 100000; i++) {
+		uint32_t bigEndian = OFToBigEndian32(i);
+		[_contents addItems: &bigEndian count: 4];
+	}
+
+	[_contents writeToIRI: _fileIRI];
+}
+
+- (void)tearDown
+{
+	if (_fileIRI != nil)
+		[[OFFileManager defaultManager] removeItemAtIRI: _fileIRI];
+}
+
+- (void)dealloc
+{
+	objc_release(_fileIRI);
+	objc_release(_contents);
+
+	[super dealloc];
+}
+
+- (void)testDataWithContentsOfIRI
+{
+	OFMappedData *data = [OFMappedData dataWithContentsOfIRI: _fileIRI];
+
+#ifdef HAVE_MMAP
+	OTAssertTrue(data.mapped);
+#endif
+	OTAssertEqualObjects(data, _contents);
+
+	[data adviseAccess: OFMappedDataAccessSequential];
+	[data adviseAccess: OFMappedDataAccessWillNeed
+		     range: OFMakeRange(4097, 8192)];
+	OTAssertEqualObjects(data, _contents);
+
+	OTAssertThrowsSpecific([data adviseAccess: OFMappedDataAccessRandom
+					    range: OFMakeRange(1, data.count)],
+	    OFOutOfRangeException);
+}
+
+- (void)testSubdataOutlivesData
+{
+	OFRange range = OFMakeRange(12345, 6789);
+	void *pool = objc_autoreleasePoolPush();
+	OFMappedData *data = [OFMappedData dataWithContentsOfIRI: _fileIRI];
+	OFData *subdata = objc_retain([data subdataWithRange: range]);
+
+	/* Releases the OFMappedData, which must stay mapped for the subdata. */
+	objc_autoreleasePoolPop(pool);
+
+	@try {
+		OTAssertEqualObjects(subdata,
+		    [_contents subdataWithRange: range]);
+	} @finally {
+		objc_release(subdata);
+	}
+}
+
+- (void)testEmptyFile
+{
+	OFMappedData *data;
+
+	[[OFData data] writeToIRI: _fileIRI];
+	data = [OFMappedData dataWithContentsOfIRI: _fileIRI];
+
+	OTAssertFalse(data.mapped);
+	OTAssertEqual(data.count, 0);
+}
+
+- (void)testNonFileIRI
+{
+	OFIRI *IRI = [OFIRI IRIWithString: @"embedded:testfile.bin"];
+	OFMappedData *data = [OFMappedData dataWithContentsOfIRI: IRI];
+
+	OTAssertFalse(data.mapped);
+	OTAssertEqualObjects(data, [OFData dataWithContentsOfIRI: IRI]);
+}
+@end
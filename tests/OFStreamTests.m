@@ -19,6 +19,8 @@
 
 #include "config.h"
 
+#include <inttypes.h>
+
 #import "ObjFW.h"
 #import "ObjFWTest.h"
 
@@ -31,6 +33,32 @@
 }
 @end
 
+@interface OFChunkedTestStream: OFStream
+{
+	OFData *_data;
+	size_t _position, _numChunks;
+}
+
+- (instancetype)initWithData: (OFData *)data;
+@end
+
+static const uint32_t numRecords = 100000;
+
+static OFData *
+recordsData(void)
+{
+	OFMutableData *data = [OFMutableData data];
+
+	for (uint32_t i = 0; i < numRecords; i++) {
+		uint32_t bigEndian = OFToBigEndian32(i);
+
+		[data addItems: &bigEndian count: 4];
+		[data addItems: "line\r\n" count: 6];
+	}
+
+	return data;
+}
+
 @implementation OFStreamTests
 - (void)testStream
 {
@@ -60,6 +88,159 @@
 		OFFreeMemory(cString);
 	}
 }
+
+- (void)readRecordsWithReadBufferCapacity: (size_t)capacity
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFChunkedTestStream *stream = objc_autorelease(
+	    [[OFChunkedTestStream alloc] initWithData: recordsData()]);
+
+	if (capacity > 0)
+		stream.readBufferCapacity = capacity;
+
+	for (uint32_t i = 0; i < numRecords; i++) {
+		OTAssertEqual([stream readBigEndianInt32], i);
+		OTAssertEqualObjects([stream readLine], @"line");
+
+		if (i % 1000 == 0) {
+			uint32_t bigEndian = OFToBigEndian32(i);
+
+			[stream unreadFromBuffer: &bigEndian length: 4];
+			OTAssertEqual([stream readBigEndianInt32], i);
+		}
+	}
+
+	OTAssertNil([stream readLine]);
+	OTAssertTrue(stream.atEndOfStream);
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (void)testReadSmallItemsAndLines
+{
+	[self readRecordsWithReadBufferCapacity: 0];
+}
+
+- (void)testReadSmallItemsAndLinesWithSmallReadBuffer
+{
+	[self readRecordsWithReadBufferCapacity: 7];
+}
+
+- (void)testPeekAndConsume
+{
+	OFChunkedTestStream *stream = objc_autorelease(
+	    [[OFChunkedTestStream alloc] initWithData: recordsData()]);
+	const unsigned char *buffer;
+	size_t length;
+	uint32_t bigEndian;
+
+	for (uint32_t i = 0; i < numRecords; i++) {
+		buffer = [stream peekBufferWithMinimumLength: 10
+						      length: &length];
+		OTAssertGreaterThanOrEqual(length, 10);
+
+		memcpy(&bigEndian, buffer, 4);
+		OTAssertEqual(OFFromBigEndian32(bigEndian), i);
+		OTAssertEqual(memcmp(buffer + 4, "line\r\n", 6), 0);
+
+		[stream consumeLength: 10];
+	}
+
+	OTAssertTrue([stream peekBufferWithMinimumLength: 1
+						  length: &length] == NULL);
+	OTAssertEqual(length, 0);
+	OTAssertThrowsSpecific([stream consumeLength: 1],
+	    OFOutOfRangeException);
+}
+
+- (void)testReadUntilDelimiter
+{
+	OFMutableData *data = [OFMutableData data];
+	OFChunkedTestStream *stream;
+
+	for (uint32_t i = 0; i < numRecords; i++) {
+		OFString *record = [OFString stringWithFormat: @"%" @PRIu32, i];
+
+		[data addItems: record.UTF8String
+			 count: record.UTF8StringLength];
+		/* The delimiter overlaps with a partial match before it. */
+		[data addItems: "aaab" count: 4];
+	}
+
+	stream = objc_autorelease(
+	    [[OFChunkedTestStream alloc] initWithData: data]);
+
+	for (uint32_t i = 0; i < numRecords; i++)
+		OTAssertEqualObjects([stream readUntilDelimiter: @"aab"],
+		    ([OFString stringWithFormat: @"%" @PRIu32 "a", i]));
+
+	OTAssertNil([stream readUntilDelimiter: @"aab"]);
+}
+
+- (void)testWriteBuffers
+{
+	char memory[52];
+	OFMemoryStream *stream = [OFMemoryStream
+	    streamWithMemoryAddress: memory
+			       size: sizeof(memory)
+			   writable: true];
+	OFStreamBuffer buffers[20];
+
+	/* More buffers than are written at once, including empty ones. */
+	for (size_t i = 0; i < 20; i++) {
+		buffers[i].buffer = "01234567890" + i % 10;
+		buffers[i].length = (i % 3 == 0 ? 0 : 2);
+	}
+
+	[stream writeBuffers: buffers count: 20];
+	OTAssertEqual(memcmp(memory, "12234556788901123445677890", 26), 0);
+
+	stream.buffersWrites = true;
+	[stream writeBuffers: buffers count: 20];
+	OTAssertTrue([stream flushWriteBuffer]);
+	OTAssertEqual(
+	    memcmp(memory + 26, "12234556788901123445677890", 26), 0);
+}
+
+- (void)testWriteContentsOfStream
+{
+	OFData *data = recordsData();
+	OFChunkedTestStream *source = objc_autorelease(
+	    [[OFChunkedTestStream alloc] initWithData: data]);
+	size_t count = data.count;
+	char *memory = OFAllocMemory(count, 1);
+
+	@try {
+		OFMemoryStream *destination = [OFMemoryStream
+		    streamWithMemoryAddress: memory
+				       size: count
+				   writable: true];
+
+		/* Leaves data in the read buffer that needs to go first. */
+		OTAssertEqual([source readBigEndianInt32], 0);
+		[destination writeBuffer: data.items length: 4];
+
+		OTAssertEqual([destination writeContentsOfStream: source
+							  length: count - 14],
+		    count - 14);
+		OTAssertEqual([destination writeContentsOfStream: source
+							  length: count],
+		    10);
+		OTAssertTrue(source.atEndOfStream);
+		OTAssertEqual(memcmp(memory, data.items, count), 0);
+	} @finally {
+		OFFreeMemory(memory);
+	}
+}
+
+- (void)testReadBufferCapacity
+{
+	OFTestStream *stream = objc_autorelease([[OFTestStream alloc] init]);
+
+	OTAssertEqual(stream.readBufferCapacity, 2 * [OFSystemInfo pageSize]);
+	OTAssertThrowsSpecific(stream.readBufferCapacity = 0,
+	    OFInvalidArgumentException);
+}
 @end
 
 @implementation OFTestStream
@@ -129,3 +310,42 @@
 	return 0;
 }
 @end
+
+@implementation OFChunkedTestStream
+- (instancetype)initWithData: (OFData *)data
+{
+	self = [super init];
+
+	_data = [data copy];
+
+	return self;
+}
+
+- (void)dealloc
+{
+	objc_release(_data);
+
+	[super dealloc];
+}
+
+- (bool)lowlevelIsAtEndOfStream
+{
+	return (_position >= _data.count);
+}
+
+- (size_t)lowlevelReadIntoBuffer: (void *)buffer length: (size_t)length
+{
+	/* Use odd chunk sizes so that items and lines span multiple reads. */
+	size_t chunkSize = 1 + (_numChunks++ * 37) % 251;
+
+	if (length > chunkSize)
+		length = chunkSize;
+	if (length > _data.count - _position)
+		length = _data.count - _position;
+
+	memcpy(buffer, (const char *)_data.items + _position, length);
+	_position += length;
+
+	return length;
+}
+@end
@@ -24,9 +24,17 @@
 #import "ObjFW.h"
 #import "ObjFWTest.h"
 
-@interface OFTCPSocketTests: OTTestCase
+@interface OFTCPSocketTests: OTTestCase <OFStreamDelegate>
+{
+	char _buffer[5];
+	size_t _numMessages;
+	bool _failed;
+}
 @end
 
+static OFRunLoopMode testMode = @"OFTCPSocketTestsMode";
+static const size_t numMessages = 1000;
+
 @implementation OFTCPSocketTests
 - (void)testTCPSocket
 {
@@ -52,4 +60,76 @@
 	[accepted readIntoBuffer: buffer exactLength: 6];
 	OTAssertEqual(memcmp(buffer, "Hello!", 6), 0);
 }
+
+- (void)testAsyncReadsRequeuedFromHandler
+{
+	OFTCPSocket *server, *client, *accepted;
+	OFSocketAddress address;
+	OFDate *deadline;
+
+	server = [OFTCPSocket socket];
+	client = [OFTCPSocket socket];
+
+	address = [server bindToHost: @"127.0.0.1" port: 0];
+	[server listen];
+
+	[client connectToHost: @"127.0.0.1"
+			 port: OFSocketAddressIPPort(&address)];
+	accepted = [server accept];
+
+	/*
+	 * Alternate between reading a line and reading an exact length, each
+	 * queued from the handler of the previous read, so that the run loop
+	 * needs to reuse queue items of different types.
+	 */
+	accepted.delegate = self;
+	[accepted asyncReadLineWithEncoding: OFStringEncodingASCII
+				runLoopMode: testMode];
+
+	for (size_t i = 0; i < numMessages; i++)
+		[client writeString: @"msg\nHello"];
+
+	deadline = [OFDate dateWithTimeIntervalSinceNow: 5];
+	while (_numMessages < numMessages && !_failed &&
+	    deadline.timeIntervalSinceNow > 0)
+		[[OFRunLoop currentRunLoop] runMode: testMode
+					 beforeDate: deadline];
+
+	OTAssertFalse(_failed);
+	OTAssertEqual(_numMessages, numMessages);
+}
+
+- (bool)stream: (OFStream *)stream
+   didReadLine: (OFString *)line
+     exception: (id)exception
+{
+	if (exception != nil || ![line isEqual: @"msg"]) {
+		_failed = true;
+		return false;
+	}
+
+	[stream asyncReadIntoBuffer: _buffer
+			exactLength: 5
+			runLoopMode: testMode];
+
+	return false;
+}
+
+-      (bool)stream: (OFStream *)stream
+  didReadIntoBuffer: (void *)buffer
+	     length: (size_t)length
+	  exception: (id)exception
+{
+	if (exception != nil || length != 5 ||
+	    memcmp(buffer, "Hello", 5) != 0) {
+		_failed = true;
+		return false;
+	}
+
+	if (++_numMessages < numMessages)
+		[stream asyncReadLineWithEncoding: OFStringEncodingASCII
+				      runLoopMode: testMode];
+
+	return false;
+}
 @end
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2008-2026 Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3.0 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * version 3.0 along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#import "ObjFW.h"
+#import "ObjFWTest.h"
+
+static OFRunLoopMode testMode = @"OFTimerTestsMode";
+static const size_t numManyTimers = 100000;
+
+@interface OFTimerTests: OTTestCase
+{
+	size_t _fireCount;
+	OFTimeInterval _lastFireTime;
+	bool _outOfOrder;
+}
+@end
+
+@implementation OFTimerTests
+- (void)timerFired: (OFTimer *)timer
+{
+	OFTimeInterval fireTime = timer.fireDate.timeIntervalSince1970;
+
+	if (fireTime < _lastFireTime)
+		_outOfOrder = true;
+
+	_lastFireTime = fireTime;
+	_fireCount++;
+}
+
+- (OFTimer *)addTimerWithFireDate: (OFDate *)fireDate
+{
+	OFTimer *timer = objc_autorelease([[OFTimer alloc]
+	    initWithFireDate: fireDate
+		    interval: 0
+		      target: self
+		    selector: @selector(timerFired:)
+		     repeats: false]);
+
+	[[OFRunLoop currentRunLoop] addTimer: timer forMode: testMode];
+
+	return timer;
+}
+
+- (void)testManyTimersFireInOrderInOneIteration
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFTimeInterval now = [OFDate date].timeIntervalSince1970;
+
+	/* Add the timers out of order so that the queue has to sort them. */
+	for (size_t i = 0; i < numManyTimers; i++) {
+		OFTimeInterval offset =
+		    (OFTimeInterval)((i * 7919) % numManyTimers) /
+		    numManyTimers;
+
+		[self addTimerWithFireDate:
+		    [OFDate dateWithTimeIntervalSince1970: now - 1 - offset]];
+	}
+
+	[[OFRunLoop currentRunLoop] runMode: testMode beforeDate: nil];
+
+	OTAssertEqual(_fireCount, numManyTimers);
+	OTAssertFalse(_outOfOrder);
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (void)testRescheduleTimers
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFRunLoop *runLoop = [OFRunLoop currentRunLoop];
+	OFDate *future = [OFDate dateWithTimeIntervalSinceNow: 3600];
+	OFDate *past = [OFDate dateWithTimeIntervalSinceNow: -1];
+	OFMutableArray *timers = [OFMutableArray array];
+
+	for (size_t i = 0; i < 1000; i++)
+		[timers addObject: [self addTimerWithFireDate: future]];
+
+	for (size_t i = 0; i < 1000; i += 2)
+		[[timers objectAtIndex: i] setFireDate: past];
+
+	[runLoop runMode: testMode beforeDate: nil];
+	OTAssertEqual(_fireCount, 500);
+
+	for (size_t i = 1; i < 1000; i += 2)
+		[[timers objectAtIndex: i] setFireDate: past];
+
+	[runLoop runMode: testMode beforeDate: nil];
+	OTAssertEqual(_fireCount, 1000);
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (void)testToleranceCoalescesWakeups
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFRunLoop *runLoop = [OFRunLoop currentRunLoop];
+	OFTimer *timer1 = [self addTimerWithFireDate:
+	    [OFDate dateWithTimeIntervalSinceNow: 0.01]];
+	OFTimer *timer2 = [self addTimerWithFireDate:
+	    [OFDate dateWithTimeIntervalSinceNow: 0.03]];
+	unsigned long long wakeups;
+
+	timer1.tolerance = 0.1;
+	timer2.tolerance = 0.1;
+	OTAssertEqual(timer1.tolerance, 0.1);
+
+	wakeups = runLoop.numberOfWakeups;
+
+	while (_fireCount < 2)
+		[runLoop runMode: testMode beforeDate: nil];
+
+	OTAssertEqual(runLoop.numberOfWakeups - wakeups, 1);
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (void)testStatistics
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFRunLoop *runLoop = [OFRunLoop currentRunLoop];
+	OFRunLoopMode mode = @"OFTimerTestsStatisticsMode";
+	OFTimer *timer = objc_autorelease([[OFTimer alloc]
+	    initWithFireDate: [OFDate dateWithTimeIntervalSinceNow: -1]
+		    interval: 0
+		      target: self
+		    selector: @selector(timerFired:)
+		     repeats: false]);
+	OFRunLoopStatistics *statistics;
+	unsigned long long sum = 0;
+
+	[runLoop addTimer: timer forMode: mode];
+
+	runLoop.collectsStatistics = true;
+	@try {
+		[runLoop runMode: mode beforeDate: nil];
+	} @finally {
+		runLoop.collectsStatistics = false;
+	}
+
+	OTAssertEqual(_fireCount, 1);
+
+	statistics = [runLoop statisticsForMode: mode];
+	OTAssertEqual(statistics.numberOfIterations, 1);
+	OTAssertEqual(statistics.numberOfTimerHandlerCalls, 1);
+	OTAssertEqual(statistics.numberOfReadHandlerCalls, 0);
+	OTAssertEqual(statistics.numberOfLateTimers, 1);
+	OTAssertGreaterThanOrEqual(statistics.maximumTimerLateness, 1);
+
+	for (OFNumber *count in statistics.iterationHandlerTimeHistogram)
+		sum += count.unsignedLongLongValue;
+	OTAssertEqual(sum, 1);
+
+	OTAssertNil([runLoop statisticsForMode: @"OFTimerTestsUnusedMode"]);
+
+	objc_autoreleasePoolPop(pool);
+}
+@end
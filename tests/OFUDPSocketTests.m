@@ -47,4 +47,40 @@
 	OTAssertEqual(OFSocketAddressIPPort(&addr2),
 	    OFSocketAddressIPPort(&addr1));
 }
+
+- (void)testSendAndReceivePackets
+{
+	OFUDPSocket *sock = [OFUDPSocket socket];
+	OFDatagramSocketPacket packets[3];
+	char buffers[3][6];
+	const char *messages[3] = { "Hello", "World", "Batch" };
+	OFSocketAddress addr;
+	size_t received = 0;
+
+	addr = [sock bindToHost: @"127.0.0.1" port: 0];
+
+	for (size_t i = 0; i < 3; i++) {
+		packets[i].buffer = (void *)messages[i];
+		packets[i].length = 6;
+		packets[i].address = addr;
+	}
+
+	OTAssertEqual([sock sendPackets: packets count: 3], 3);
+
+	for (size_t i = 0; i < 3; i++) {
+		packets[i].buffer = buffers[i];
+		packets[i].capacity = 6;
+	}
+
+	while (received < 3)
+		received += [sock receivePackets: packets + received
+					   count: 3 - received];
+
+	for (size_t i = 0; i < 3; i++) {
+		OTAssertEqual(packets[i].length, 6);
+		OTAssertEqual(memcmp(buffers[i], messages[i], 6), 0);
+		OTAssertEqual(OFSocketAddressIPPort(&packets[i].address),
+		    OFSocketAddressIPPort(&addr));
+	}
+}
 @end